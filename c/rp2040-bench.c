@@ -0,0 +1,179 @@
+/* rp2040-bench.c - cycle-counting benchmark harness
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-bench.h"
+#include "rp2040-timer.h"
+#include "rp2040-clocks.h"
+#include "rp2040-sio.h"
+#include "rp2040-cm0.h"
+
+#define BENCH_NCAL		16		/* No. of calls of the empty function for calibration */
+
+static u32_t bench_cyc_per_us;
+static u32_t bench_systick_us;	/* Calls that take at least this long are timed with the microsecond timer */
+static u32_t bench_max_us;		/* Calls that take at least this long are reported as 0xffffffff cycles */
+static u32_t bench_overhead;	/* Cycles for calling an empty function */
+static rp2040_clk_notifier_t bench_clk_notifier;
+
+static void bench_empty(void *arg)
+{
+}
+
+/* bench_one() - measure one call of a benchmark function
+*/
+static u32_t bench_one(const rp2040_bench_t *b)
+{
+	u32_t pm = cxm_get_primask();
+	u32_t t0, t1, us0, us1;
+
+	if ( (b->flags & RP2040_BENCH_IRQS) == 0 )
+		cxm_set_primask(INTDISABLED);
+
+	us0 = rp2040_timer.time_lraw;
+	t0 = cxm_systick_read();
+	b->fn(b->arg);
+	t1 = cxm_systick_read();
+	us1 = rp2040_timer.time_lraw;
+
+	cxm_set_primask(pm);
+
+	us1 -= us0;
+	if ( us1 < bench_systick_us )
+		return cxm_systick_elapsed(t0, t1);
+	if ( us1 < bench_max_us )
+		return us1 * bench_cyc_per_us;
+	return 0xffffffff;
+}
+
+/* bench_sort() - insertion sort. The arrays are small.
+*/
+static void bench_sort(u32_t *a, int n)
+{
+	for ( int i = 1; i < n; i++ )
+	{
+		u32_t v = a[i];
+		int j = i;
+
+		while ( j > 0 && a[j-1] > v )
+		{
+			a[j] = a[j-1];
+			j--;
+		}
+		a[j] = v;
+	}
+}
+
+/* bench_set_freq() - calculate the microsecond timer limits for a clk_sys frequency
+*/
+static void bench_set_freq(u32_t hz)
+{
+	bench_cyc_per_us = rp2040_udiv(hz, 1000000, 0);
+	bench_systick_us = rp2040_udiv(SYST_MASK, bench_cyc_per_us, 0) - 2;	/* Allow for the timer's granularity */
+	bench_max_us = rp2040_udiv(0xffffffff, bench_cyc_per_us, 0);
+}
+
+/* bench_clk_notify() - clock change notifier: recalculate the limits after a change of clk_sys
+ *
+ * The overhead is in cycles, so it doesn't change.
+*/
+static void bench_clk_notify(rp2040_clk_notifier_t *n, int phase, u32_t old_hz, u32_t new_hz)
+{
+	if ( phase == RP2040_CLK_POST )
+		bench_set_freq(new_hz);
+}
+
+/* rp2040_bench_init() - start SysTick and measure the overhead of a measurement
+*/
+void rp2040_bench_init(void)
+{
+	rp2040_bench_t cal = { "", bench_empty, 0, 0, 0, BENCH_NCAL, 0 };
+	u32_t min = 0xffffffff;
+
+	cxm_systick_start();
+
+	bench_set_freq(rp2040_clk_sys_hz());
+	rp2040_clk_notifier_register(&bench_clk_notifier, bench_clk_notify);
+
+	bench_overhead = 0;
+	for ( int i = 0; i < BENCH_NCAL; i++ )
+	{
+		u32_t t = bench_one(&cal);
+		if ( t < min )
+			min = t;
+	}
+	bench_overhead = min;
+}
+
+/* rp2040_bench_run() - run a benchmark
+*/
+void rp2040_bench_run(const rp2040_bench_t *b, rp2040_benchresult_t *r)
+{
+	u32_t t[RP2040_BENCH_MAXREP];
+	int n = b->n_rep;
+
+	if ( n > RP2040_BENCH_MAXREP )
+		n = RP2040_BENCH_MAXREP;
+	if ( n < 1 )
+		n = 1;
+
+	for ( int i = 0; i < b->n_warmup; i++ )
+	{
+		if ( b->setup != 0 )
+			b->setup(b->arg);
+		b->fn(b->arg);
+	}
+
+	for ( int i = 0; i < n; i++ )
+	{
+		if ( b->setup != 0 )
+			b->setup(b->arg);
+		t[i] = bench_one(b);
+		if ( t[i] == 0xffffffff )
+			continue;
+		t[i] = (t[i] > bench_overhead) ? (t[i] - bench_overhead) : 0;
+	}
+
+	bench_sort(t, n);
+
+	r->n = (u32_t)n;
+	r->min = t[0];
+	r->median = t[n/2];
+	r->max = t[n-1];
+}
+
+/* rp2040_bench_report() - print the result of a benchmark
+ *
+ * Format: BENCH,<name>,<n>,<min>,<median>,<max>
+*/
+void rp2040_bench_report(const rp2040_bench_t *b, const rp2040_benchresult_t *r, void (*putc)(char))
+{
+	rp2040_puts(putc, "BENCH,");
+	rp2040_puts(putc, b->name);
+	putc(',');
+	rp2040_putdec(putc, r->n);
+	putc(',');
+	rp2040_putdec(putc, r->min);
+	putc(',');
+	rp2040_putdec(putc, r->median);
+	putc(',');
+	rp2040_putdec(putc, r->max);
+	putc('\n');
+}
@@ -21,40 +21,88 @@
 #include "rp2040-types.h"
 #include "rp2040-clocks.h"
 #include "rp2040-resets.h"
+#include "rp2040-delay.h"
+#include "rp2040-sio.h"
 
-/* ToDo: allow these to be configured externally
+/* PLL settings, calculated from RP2040_CLK_SYS_HZ and RP2040_CLK_USB_HZ in rp2040-clocks.h
+ * For the default 133 MHz: VCO at 1596 MHz, divided by 6 and 2.
+ * For the USB PLL: VCO at 1440 MHz, divided by 6 and 5.
 */
-#define APP_REFDIV			1		/* VCO input at 12 MHz */
-#define APP_FBDIV			133		/* VCO at 1596 MHz */
-#define APP_POSTDIV1		6		/* Div1 output at 266 MHz */
-#define APP_POSTDIV2		2		/* Div2 output at 133 MHz */
+#define APP_REFDIV			RP2040_PLL_SYS_REFDIV
+#define APP_FBDIV			RP2040_PLL_SYS_FBDIV
+#define APP_POSTDIV1		RP2040_PLL_SYS_POSTDIV1
+#define APP_POSTDIV2		RP2040_PLL_SYS_POSTDIV2
 #define APP_POSTDIVS		((APP_POSTDIV1 << 16) | (APP_POSTDIV2 << 12))
 
-#define APP_USB_REFDIV		APP_REFDIV			
-#define APP_USB_FBDIV		120		/* VCO at 1440 MHz */
-#define APP_USB_POSTDIV1	6		/* Div1 output at 240 MHz */
-#define APP_USB_POSTDIV2	5		/* Div2 output at 48 MHz */
+#define APP_USB_REFDIV		RP2040_PLL_USB_REFDIV
+#define APP_USB_FBDIV		RP2040_PLL_USB_FBDIV
+#define APP_USB_POSTDIV1	RP2040_PLL_USB_POSTDIV1
+#define APP_USB_POSTDIV2	RP2040_PLL_USB_POSTDIV2
 #define APP_USB_POSTDIVS	((APP_USB_POSTDIV1 << 16) | (APP_USB_POSTDIV2 << 12))
 
+/* Timeouts, in CPU cycles because the timer isn't running yet.
+ * The XOSC is started while the CPU runs from the ROSC (nominally 6.5 MHz, but with a wide tolerance);
+ * the PLLs are started while the CPU runs from the XOSC.
+ * The XOSC normally needs about 1 ms and a PLL a few tens of microseconds.
+*/
+#ifndef RP2040_XOSC_TIMEOUT_CYCLES
+#define RP2040_XOSC_TIMEOUT_CYCLES	1000000		/* ROSC 1.8 to 12 MHz: 80 ms to 550 ms (150 ms nominal) */
+#endif
+#ifndef RP2040_PLL_TIMEOUT_CYCLES
+#define RP2040_PLL_TIMEOUT_CYCLES	120000		/* 10 ms at 12 MHz */
+#endif
+
+/* Frequency counter: the measurement interval is 2^RP2040_FC0_INTERVAL reference ticks of about 1 us.
+ * 64 us counts thousands of cycles of any clock above 20 MHz, far finer than the 1/64 accept band,
+ * and keeps the check at boot short.
+ * The timeout is in CPU cycles because clk_sys is one of the clocks that might be wrong.
+*/
+#ifndef RP2040_FC0_INTERVAL
+#define RP2040_FC0_INTERVAL			6
+#endif
+#ifndef RP2040_FC0_TIMEOUT_CYCLES
+#define RP2040_FC0_TIMEOUT_CYCLES	2000000		/* 15 ms at 133 MHz */
+#endif
+
+/* The current frequency of clk_sys. This is in .data rather than .bss because rp2040_pll_init()
+ * runs before the .bss is cleared.
+*/
+u32_t rp2040_clk_sys_freq = RP2040_CLK_SYS_HZ;
 
-void rp2040_clock_init(void)
+/* Result of the clock verification in rp2040_kickstart()
+*/
+u32_t rp2040_clk_failed;
+
+static rp2040_clk_notifier_t *clk_notifiers;
+
+/* rp2040_clock_init() - start the XOSC and use it for clk_ref, clk_sys and clk_peri
+ *
+ * Returns 0 if OK, -1 if the XOSC doesn't become stable. In that case the clocks are not changed.
+*/
+int rp2040_clock_init(void)
 {
 	rp2040_clocks.sys_resus_ctrl = 0x00;				/* Disable resuscitation for now */
 
 	rp2040_xosc.ctrl = XOSC_1_15_MHZ | XOSC_DISABLE;	/* Should be fixed according to datasheet, but is R/W */
-	rp2040_xosc.startup = ((12000000/1000)+255)/256;	/* 1 ms at 12 MHz, rounded up */
+	rp2040_xosc.startup = ((RP2040_XOSC_HZ/1000)+255)/256;	/* 1 ms, rounded up */
 	rp2040_xosc.ctrl = XOSC_1_15_MHZ | XOSC_ENABLE;
-	do {	/* Wait */	} while ( (rp2040_xosc.status & XOSC_STABLE) == 0 );
+	if ( rp2040_wait_reg_cycles(&rp2040_xosc.status, XOSC_STABLE, XOSC_STABLE, RP2040_XOSC_TIMEOUT_CYCLES) != 0 )
+		return -1;
 
 	rp2040_clocks.ref.ctrl = CLKSRC_REF_XOSC;			/* Select XOSC as the reference clock source */
 	rp2040_clocks.sys.ctrl = CLKSRC_SYS_REF;			/* Select REF as the system clock source */
 
 	rp2040_clocks.peri.ctrl = CLK_ENABLE | CLKSRC_PERI_XOSC;		/* Select xosc as peripheral clock */
+	return 0;
 }
 
-static void pll_helper(rp2040_pll_t *pll, rp2040_pll_t *pll_w1c, u32_t fbdiv, u32_t postdivs);
+static int pll_helper(rp2040_pll_t *pll, rp2040_pll_t *pll_w1c, u32_t refdiv, u32_t fbdiv, u32_t postdivs);
 
-void rp2040_pll_init(void)
+/* rp2040_pll_init() - start the system PLL and use it for clk_sys
+ *
+ * Returns 0 if OK, -1 if the PLL doesn't lock. In that case clk_sys remains on clk_ref.
+*/
+int rp2040_pll_init(void)
 {
 	/* Check if PLL is already correctly configured and running
 	*/
@@ -62,7 +110,7 @@ void rp2040_pll_init(void)
 		 (rp2040_pll.cs & PLL_REFDIV) == APP_REFDIV &&
 		 (rp2040_pll.fbdiv_int & PLL_FBDIV) == APP_FBDIV &&
 		 (rp2040_pll.prim & (PLL_POSTDIV1 | PLL_POSTDIV2)) == APP_POSTDIVS )
-		return;
+		return 0;
 
 	/* Reset and re-enable the PLL.
 	*/
@@ -70,15 +118,29 @@ void rp2040_pll_init(void)
 
 	/* Initialise the main PLL
 	*/
-	pll_helper(&rp2040_pll, &rp2040_pll_w1c, APP_FBDIV, APP_POSTDIVS);
+	if ( pll_helper(&rp2040_pll, &rp2040_pll_w1c, APP_REFDIV, APP_FBDIV, APP_POSTDIVS) != 0 )
+	{
+		rp2040_clk_sys_freq = RP2040_XOSC_HZ;
+		return -1;
+	}
 
 	/* Switch the sys clock to the PLL
 	*/
 	rp2040_clocks.sys.ctrl = CLKSRC_SYS_REF | CLKSRC_SYS_AUX_PLL;	/* Should be this already */
 	rp2040_clocks.sys.ctrl = CLKSRC_SYS_AUX | CLKSRC_SYS_AUX_PLL;	/* Switch to the aux clock */
+	rp2040_clk_sys_freq = RP2040_CLK_SYS_HZ;
+
+#if RP2040_CLK_PERI_SYS
+	rp2040_clocks.peri.ctrl = CLK_ENABLE | CLKSRC_PERI_SYS;		/* Peripheral clock follows clk_sys */
+#endif
+	return 0;
 }
 
-void rp2040_usbpll_init(void)
+/* rp2040_usbpll_init() - start the USB PLL and use it for clk_usb
+ *
+ * Returns 0 if OK, -1 if the PLL doesn't lock. In that case clk_usb is not changed.
+*/
+int rp2040_usbpll_init(void)
 {
 	/* Check if USB PLL is already correctly configured and running
 	*/
@@ -86,7 +148,7 @@ void rp2040_usbpll_init(void)
 		 (rp2040_usbpll.cs & PLL_REFDIV) == APP_USB_REFDIV &&
 		 (rp2040_usbpll.fbdiv_int & PLL_FBDIV) == APP_USB_FBDIV &&
 		 (rp2040_usbpll.prim & (PLL_POSTDIV1 | PLL_POSTDIV2)) == APP_USB_POSTDIVS )
-		return;
+		return 0;
 
 	/* Reset and re-enable the PLL.
 	*/
@@ -94,19 +156,25 @@ void rp2040_usbpll_init(void)
 
 	/* Initialise the USB PLL
 	*/
-	pll_helper(&rp2040_usbpll, &rp2040_usbpll_w1c, APP_USB_FBDIV, APP_USB_POSTDIVS);
+	if ( pll_helper(&rp2040_usbpll, &rp2040_usbpll_w1c, APP_USB_REFDIV, APP_USB_FBDIV, APP_USB_POSTDIVS) != 0 )
+		return -1;
 
 	/* Switch the USB clock to the PLL
 	*/
 	rp2040_clocks.usb.div = CLK_DIVBY1;
 	rp2040_clocks.usb.ctrl = CLK_ENABLE | CLKSRC_USB_PLL_USB;
+	return 0;
 }
 
-static void pll_helper(rp2040_pll_t *pll, rp2040_pll_t *pll_w1c, u32_t fbdiv, u32_t postdivs)
+/* pll_helper() - configure and start a PLL
+ *
+ * Returns 0 if OK, -1 if the PLL doesn't lock. In that case the PLL is powered down again.
+*/
+static int pll_helper(rp2040_pll_t *pll, rp2040_pll_t *pll_w1c, u32_t refdiv, u32_t fbdiv, u32_t postdivs)
 {
 	/* Load the VCO-related dividers
 	*/
-	pll->cs = APP_REFDIV;
+	pll->cs = refdiv;
 	pll->fbdiv_int = fbdiv;
 
 	/* Power on the PLL
@@ -115,7 +183,11 @@ static void pll_helper(rp2040_pll_t *pll, rp2040_pll_t *pll_w1c, u32_t fbdiv, u3
 
 	/* Wait for the PLL to lock
 	*/
-	do {	/* Wait */	} while ( (pll->cs & PLL_LOCK) == 0 );
+	if ( rp2040_wait_reg_cycles(&pll->cs, PLL_LOCK, PLL_LOCK, RP2040_PLL_TIMEOUT_CYCLES) != 0 )
+	{
+		pll->pwr = PLL_VCOPD | PLL_PD | PLL_POSTDIVPD | PLL_DSMPD;
+		return -1;
+	}
 
 	/* Configure the post-dividers
 	*/
@@ -124,4 +196,196 @@ static void pll_helper(rp2040_pll_t *pll, rp2040_pll_t *pll_w1c, u32_t fbdiv, u3
 	/* Power on the post-dividers
 	*/
 	pll_w1c->pwr = PLL_POSTDIVPD;
+	return 0;
+}
+
+/* pll_postdivs[] - the POSTDIV1/POSTDIV2 pairs, in the same order as RP2040_PLL_SOLVE()
+*/
+static const u8_t pll_postdivs[] =
+{	0x77, 0x76, 0x66, 0x75, 0x65, 0x74, 0x55, 0x64, 0x73, 0x54, 0x63, 0x44, 0x53, 0x72,
+	0x62, 0x43, 0x52, 0x33, 0x42, 0x71, 0x61, 0x32, 0x51, 0x41, 0x22, 0x31, 0x21, 0x11
+};
+
+/* pll_solve() - the run-time equivalent of RP2040_PLL_SOLVE()
+ *
+ * Returns 0 and the settings if hz can be generated exactly, -1 otherwise.
+*/
+static int pll_solve(u32_t hz, u32_t *refdiv, u32_t *fbdiv, u32_t *postdivs)
+{
+	if ( hz == 0 )
+		return -1;
+
+	for ( u32_t r = 1; r <= 2; r++ )
+	{
+		for ( unsigned i = 0; i < sizeof(pll_postdivs); i++ )
+		{
+			u32_t pd1 = pll_postdivs[i] >> 4;
+			u32_t pd2 = pll_postdivs[i] & 0x0f;
+			u32_t vco, rem;
+
+			if ( hz > rp2040_udiv(RP2040_PLL_VCO_MAX, pd1 * pd2, 0) )
+				continue;
+
+			vco = hz * pd1 * pd2;
+			if ( vco < RP2040_PLL_VCO_MIN )
+				continue;
+
+			*fbdiv = rp2040_udiv(vco * r, RP2040_XOSC_HZ, &rem);
+			if ( rem == 0 )
+			{
+				*refdiv = r;
+				*postdivs = (pd1 << 16) | (pd2 << 12);
+				return 0;
+			}
+		}
+	}
+	return -1;
+}
+
+/* clk_notify() - call all the clock change notifiers
+*/
+static void clk_notify(int phase, u32_t old_hz, u32_t new_hz)
+{
+	for ( rp2040_clk_notifier_t *n = clk_notifiers; n != 0; n = n->next )
+	{
+		n->fn(n, phase, old_hz, new_hz);
+	}
+}
+
+/* rp2040_clk_notifier_register() - register a function to be called before and after a change of clk_sys
+ *
+ * Registering the same notifier twice has no effect.
+*/
+void rp2040_clk_notifier_register(rp2040_clk_notifier_t *n, rp2040_clk_notifyfunc_t fn)
+{
+	for ( rp2040_clk_notifier_t *x = clk_notifiers; x != 0; x = x->next )
+	{
+		if ( x == n )
+			return;
+	}
+
+	n->fn = fn;
+	n->next = clk_notifiers;
+	clk_notifiers = n;
+}
+
+/* rp2040_clk_sys_set() - change the frequency of clk_sys at run time
+ *
+ * The sequence is:
+ *	- call the notifiers with RP2040_CLK_PRE (e.g. to let the UART finish sending)
+ *	- switch clk_sys to clk_ref with the glitchless mux
+ *	- reprogram and restart the system PLL; the CPU runs at the XOSC frequency meanwhile
+ *	- switch clk_sys back to the PLL with the glitchless mux
+ *	- call the notifiers with RP2040_CLK_POST (e.g. to recalculate dividers)
+ *
+ * Returns 0 if OK, -1 if hz can't be generated exactly (nothing is changed) or if the PLL doesn't
+ * lock (clk_sys stays on clk_ref at the XOSC frequency, and the POST notifiers are told so).
+ *
+ * Call this in thread mode on core 0. Interrupt handlers and core 1 keep running, but at the interim
+ * frequency for a few tens of microseconds. The voltage regulator is not changed, so frequencies much
+ * higher than 133 MHz might need a higher core voltage.
+*/
+int rp2040_clk_sys_set(u32_t hz)
+{
+	u32_t refdiv, fbdiv, postdivs;
+	u32_t old_hz = rp2040_clk_sys_freq;
+	int result = 0;
+
+	if ( pll_solve(hz, &refdiv, &fbdiv, &postdivs) != 0 )
+		return -1;
+
+	clk_notify(RP2040_CLK_PRE, old_hz, hz);
+
+	/* Glitchless switch to clk_ref. The SELECTED register is one-hot: bit 0 is clk_ref, bit 1 the aux mux.
+	*/
+	rp2040_clocks.sys.ctrl = CLKSRC_SYS_REF | CLKSRC_SYS_AUX_PLL;
+	(void)rp2040_wait_reg_cycles(&rp2040_clocks.sys.selected, 0x3, 0x1, RP2040_PLL_TIMEOUT_CYCLES);
+	rp2040_clk_sys_freq = RP2040_XOSC_HZ;
+
+	rp2040_reset(RESETS_pll_sys);
+	if ( pll_helper(&rp2040_pll, &rp2040_pll_w1c, refdiv, fbdiv, postdivs) == 0 )
+	{
+		/* The aux mux is only changed while it isn't selected (above), so this switch is glitch-free too.
+		*/
+		rp2040_clocks.sys.ctrl = CLKSRC_SYS_AUX | CLKSRC_SYS_AUX_PLL;
+		(void)rp2040_wait_reg_cycles(&rp2040_clocks.sys.selected, 0x3, 0x2, RP2040_PLL_TIMEOUT_CYCLES);
+		rp2040_clk_sys_freq = hz;
+	}
+	else
+		result = -1;
+
+	clk_notify(RP2040_CLK_POST, old_hz, rp2040_clk_sys_freq);
+	return result;
+}
+
+/* rp2040_fc0_measure_khz() - measure a clock with the frequency counter
+ *
+ * Returns the frequency in kHz, or 0 if it can't be measured.
+*/
+u32_t rp2040_fc0_measure_khz(u32_t src)
+{
+	/* The reference frequency must be known
+	*/
+	if ( (rp2040_clocks.ref.selected & CLK_REF_SELECTED_XOSC) == 0 )
+		return 0;
+
+	if ( rp2040_wait_reg_cycles(&rp2040_clocks.fc0_status, FC0_RUNNING, 0, RP2040_FC0_TIMEOUT_CYCLES) != 0 )
+		return 0;
+
+	rp2040_clocks.fc0_ref_khz = RP2040_XOSC_HZ / 1000;
+	rp2040_clocks.fc0_interval = RP2040_FC0_INTERVAL;
+	rp2040_clocks.fc0_min_khz = 0;
+	rp2040_clocks.fc0_max_khz = 0xffffffff;
+	rp2040_clocks.fc0_src = src;		/* Starts the measurement */
+
+	if ( rp2040_wait_reg_cycles(&rp2040_clocks.fc0_status, FC0_DONE, FC0_DONE, RP2040_FC0_TIMEOUT_CYCLES) != 0 )
+		return 0;
+
+	if ( (rp2040_clocks.fc0_status & FC0_DIED) != 0 )
+		return 0;
+
+	return (rp2040_clocks.fc0_result & FC0_RESULT_KHZ) >> 5;
+}
+
+/* clk_check() - measure a clock and compare it with the expected frequency
+ *
+ * Returns 0 if the clock is within 1/64 of hz, otherwise the bit.
+*/
+static u32_t clk_check(u32_t src, u32_t hz, u32_t *khz, u32_t bit)
+{
+	u32_t expected = rp2040_udiv(hz, 1000, 0);
+	u32_t tolerance = (expected >> 6) + 1;
+
+	*khz = rp2040_fc0_measure_khz(src);
+
+	if ( *khz + tolerance < expected || *khz > expected + tolerance )
+		return bit;
+	return 0;
+}
+
+/* rp2040_clk_verify() - check that the clocks run at the expected frequencies
+ *
+ * Returns a RP2040_CLKCHK_xxx bit for each clock that is wrong, 0 if all are OK.
+ * clk_usb and clk_adc are only checked if they are enabled and come from the USB PLL undivided.
+*/
+u32_t rp2040_clk_verify(void)
+{
+	u32_t failed;
+	u32_t khz;
+
+	failed = clk_check(FC0_SRC_CLK_SYS, rp2040_clk_sys_freq, &khz, RP2040_CLKCHK_SYS);
+	if ( failed != 0 && khz != 0 )
+		rp2040_clk_sys_freq = khz * 1000;
+
+	failed |= clk_check(FC0_SRC_CLK_PERI, rp2040_clk_peri_hz(), &khz, RP2040_CLKCHK_PERI);
+
+	if ( (rp2040_clocks.usb.ctrl & (CLK_ENABLE | CLKSRC_AUX_MASK)) == (CLK_ENABLE | CLKSRC_USB_PLL_USB) &&
+		 rp2040_clocks.usb.div == CLK_DIVBY1 )
+		failed |= clk_check(FC0_SRC_CLK_USB, RP2040_CLK_USB_HZ, &khz, RP2040_CLKCHK_USB);
+
+	if ( (rp2040_clocks.adc.ctrl & (CLK_ENABLE | CLKSRC_AUX_MASK)) == (CLK_ENABLE | CLKSRC_ADC_PLL_USB) &&
+		 rp2040_clocks.adc.div == CLK_DIVBY1 )
+		failed |= clk_check(FC0_SRC_CLK_ADC, RP2040_CLK_USB_HZ, &khz, RP2040_CLKCHK_ADC);
+
+	return failed;
 }
@@ -0,0 +1,132 @@
+/* rp2040-crash.c - crash capture and reset reason
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-crash.h"
+#include "rp2040-watchdog.h"
+#include "rp2040-timer.h"
+#include "rp2040-sio.h"
+#include "rp2040-cm0.h"
+
+/* The exception frame must be entirely within SRAM, otherwise reading it would cause a fault
+ * in the fault handler, i.e. a lockup.
+*/
+#define CRASH_SRAM_START	0x20000000
+#define CRASH_SRAM_END		0x20042000
+#define CRASH_FRAMESIZE		32
+
+/* crash_entry() - select the stack that holds the exception frame
+ *
+ * Bit 2 of EXC_RETURN is set if the exception frame is on the process stack.
+*/
+static __attribute__((used, noreturn)) void crash_entry(const u32_t *msp, const u32_t *psp, u32_t exc_return)
+{
+	rp2040_crash_record(((exc_return & 0x4) != 0) ? psp : msp);
+}
+
+/* rp2040_crash_handler() - exception handler that records a crash and reboots
+ *
+ * Nothing is saved, so the handler doesn't use any stack before the frame has been found.
+*/
+__attribute__((naked)) void rp2040_crash_handler(void)
+{
+	__asm__ volatile
+	(	"	mrs		r0, msp\n"
+		"	mrs		r1, psp\n"
+		"	mov		r2, lr\n"
+		"	bl		crash_entry\n"
+	);
+}
+
+/* rp2040_crash_record() - record a crash in the watchdog scratch registers and reboot
+ *
+ * frame is the exception frame: r0, r1, r2, r3, r12, lr, pc, xpsr
+*/
+void rp2040_crash_record(const u32_t *frame)
+{
+	u32_t f = (u32_t)frame;
+	u32_t pc = RP2040_CRASH_NOFRAME;
+	u32_t lr = RP2040_CRASH_NOFRAME;
+	u32_t xpsr = 0;
+	u32_t ipsr;
+
+	(void)disable();
+
+	if ( (f & 0x3) == 0 && f >= CRASH_SRAM_START && f <= CRASH_SRAM_END - CRASH_FRAMESIZE )
+	{
+		lr = frame[5];
+		pc = frame[6];
+		xpsr = frame[7];
+	}
+
+	__asm__ volatile("mrs %0, ipsr" : "=r"(ipsr));
+
+	rp2040_watchdog.scratch[1] = pc;
+	rp2040_watchdog.scratch[2] = lr;
+	rp2040_watchdog.scratch[3] = (u32_t)(rp2040_read_time() >> 10);
+	rp2040_watchdog.scratch[0] = RP2040_CRASH_MAGIC | ((rp2040_sio.cpuid & 0x1) << 23) | ((ipsr & 0x3f) << 16) |
+								((xpsr >> 16) & 0xff00) | (xpsr & 0x3f);
+
+	rp2040_watchdog_reboot();
+}
+
+/* rp2040_crash_report() - print the reset reason and crash record
+ *
+ * The output is comma-separated, all numbers in hex:
+ *	RESET,<reason>
+ *	CRASH,<core>,<exception>,<pc>,<lr>,<xpsr>,<uptime>
+ *	MISSED,<task>,<time since check-in>
+ * The CRASH line is only printed if the last reset was caused by rp2040_crash_handler(), the MISSED
+ * line only if it was caused by a watchdog task that missed its deadline.
+*/
+void rp2040_crash_report(void (*putc)(char))
+{
+	const rp2040_crash_t *c = &rp2040_reset_info;
+
+	rp2040_puts(putc, "RESET,");
+	rp2040_putx32(putc, c->reason);
+	putc('\n');
+
+	if ( c->crashed )
+	{
+		rp2040_puts(putc, "CRASH,");
+		rp2040_putx32(putc, c->core);
+		putc(',');
+		rp2040_putx32(putc, c->exception);
+		putc(',');
+		rp2040_putx32(putc, c->pc);
+		putc(',');
+		rp2040_putx32(putc, c->lr);
+		putc(',');
+		rp2040_putx32(putc, c->xpsr);
+		putc(',');
+		rp2040_putx32(putc, c->uptime);
+		putc('\n');
+	}
+
+	if ( c->missed >= 0 )
+	{
+		rp2040_puts(putc, "MISSED,");
+		rp2040_putx32(putc, (u32_t)c->missed);
+		putc(',');
+		rp2040_putx32(putc, c->late);
+		putc('\n');
+	}
+}
@@ -0,0 +1,253 @@
+/* rp2040-edgecap.c - edge timestamp capture using PIO and DMA
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-pio.h"
+#include "rp2040-piodma.h"
+#include "rp2040-edgecap.h"
+#include "rp2040-clocks.h"
+#include "rp2040-sio.h"
+#include "rp2040-timer.h"
+
+static const u16_t edgecap_program[RP2040_EDGECAP_PROGLEN] = RP2040_EDGECAP_PROGRAM;
+
+/* The running capture on each PIO, for the clock change notifier
+*/
+static rp2040_edgecap_t *edgecap_active[2];
+static rp2040_clk_notifier_t edgecap_clk_notifier;
+
+/* edgecap_mul() - 32 x 32 -> 64 bit multiplication in 16-bit parts, without libgcc
+*/
+static void edgecap_mul(u32_t a, u32_t b, u32_t *hi, u32_t *lo)
+{
+	u32_t al = a & 0xffff, ah = a >> 16;
+	u32_t bl = b & 0xffff, bh = b >> 16;
+	u32_t ll = al * bl;
+	u32_t lh = al * bh;
+	u32_t hl = ah * bl;
+	u32_t mid = (ll >> 16) + (lh & 0xffff) + (hl & 0xffff);
+
+	*lo = (mid << 16) | (ll & 0xffff);
+	*hi = ah * bh + (lh >> 16) + (hl >> 16) + (mid >> 16);
+}
+
+/* edgecap_us_per_cyc() - the length of a cycle of hz in microseconds, as a 0.32 fixed-point fraction
+ *
+ * 2^32 * 1000000 / hz by long division, because the SIO divider only takes 32-bit dividends.
+ * hz must be more than 1 MHz. The error is less than 1 in 2^32 of a microsecond per cycle, so
+ * clk_sys frequencies that aren't whole MHz are converted exactly enough.
+*/
+static u32_t edgecap_us_per_cyc(u32_t hz)
+{
+	u32_t r = 1000000;
+	u32_t q = 0;
+
+	for ( int i = 0; i < 32; i++ )
+	{
+		r <<= 1;
+		q <<= 1;
+		if ( r >= hz )
+		{
+			r -= hz;
+			q |= 1;
+		}
+	}
+	return q;
+}
+
+/* edgecap_clk_notify() - clock change notifier: recalculate the cycle length after a change of clk_sys
+*/
+static void edgecap_clk_notify(rp2040_clk_notifier_t *n, int phase, u32_t old_hz, u32_t new_hz)
+{
+	if ( phase != RP2040_CLK_POST )
+		return;
+
+	for ( int p = 0; p < 2; p++ )
+	{
+		if ( edgecap_active[p] != 0 )
+			edgecap_active[p]->us_per_cyc = edgecap_us_per_cyc(new_hz);
+	}
+}
+
+/* rp2040_edgecap_init() - set up edge capture on up to four pins
+ *
+ * The capture uses:
+ *	- state machines 0 to npins-1 of pio
+ *	- RP2040_EDGECAP_PROGLEN instructions at offset in the PIO's instruction memory
+ *	- DMA channels dma_ch to dma_ch + 2*npins - 1
+ *	- npins ring buffers of nwords each, consecutively in buf
+ *
+ * The PIO and DMA must be out of reset. The pins only need their input enabled in the pads (the default).
+ * The cap structure is used by the DMA and the clock change notifier and must remain valid until
+ * rp2040_edgecap_stop() has been called.
+ *
+ * Returns 0 if OK, -1 if the parameters are out of range.
+*/
+int rp2040_edgecap_init(rp2040_edgecap_t *cap, rp2040_pio_t *pio, u32_t offset,
+						const u8_t *pins, int npins, int dma_ch, u32_t *buf, u32_t nwords)
+{
+	rp2040_piosm_cfg_t cfg;
+
+	if ( npins < 1 || npins > RP2040_EDGECAP_MAXPIN || offset + RP2040_EDGECAP_PROGLEN > 32 || nwords == 0 )
+		return -1;
+
+	cap->pio = pio;
+	cap->offset = offset;
+	cap->npins = npins;
+	cap->t0 = 0;
+	cap->us_per_cyc = edgecap_us_per_cyc(rp2040_clk_sys_hz());
+
+	edgecap_active[(pio == &rp2040_pio0) ? 0 : 1] = cap;
+	rp2040_clk_notifier_register(&edgecap_clk_notifier, edgecap_clk_notify);
+
+	for ( int i = 0; i < RP2040_EDGECAP_PROGLEN; i++ )
+	{
+		u16_t instr = edgecap_program[i];
+		if ( (instr & 0xe000) == PIO_JMP )
+			instr = (instr & ~0x1f) | ((instr + offset) & 0x1f);
+		pio->instr_mem[offset + i] = instr;
+	}
+
+	for ( int i = 0; i < npins; i++ )
+	{
+		rp2040_edgecap_chan_t *ch = &cap->chan[i];
+
+		ch->pin = pins[i];
+		ch->buf = &buf[i * nwords];
+		ch->nwords = nwords;
+		ch->rd = 0;
+		ch->prev = 0x7fffffff;
+		ch->us = 0;
+		ch->frac = 0;
+		ch->have_next = 0;
+
+		rp2040_edgecap_cfg(&cfg, pins[i], offset);
+		rp2040_piosm_apply(pio, i, &cfg, offset);
+		rp2040_piodma_ring(&ch->stream, pio, i, RP2040_PIODMA_RX, dma_ch + 2*i, dma_ch + 2*i + 1, ch->buf, nwords);
+	}
+
+	return 0;
+}
+
+/* rp2040_edgecap_start() - start the state machines together
+ *
+ * Event times are relative to the timer value read here, so they are aligned with
+ * rp2040_read_time() to within a microsecond.
+*/
+void rp2040_edgecap_start(rp2040_edgecap_t *cap)
+{
+	cap->t0 = rp2040_read_time();
+	rp2040_pio_enable(cap->pio, (1u << cap->npins) - 1);
+}
+
+/* edgecap_fetch() - decode the next event of a channel into ch->next, if there is one
+*/
+static boolean_t edgecap_fetch(rp2040_edgecap_t *cap, rp2040_edgecap_chan_t *ch)
+{
+	u32_t wr;
+	u32_t w;
+	u32_t d;
+	u32_t hi, lo;
+
+	if ( ch->have_next )
+		return 1;
+
+	wr = rp2040_piodma_position(&ch->stream);
+	if ( wr >= ch->nwords )
+		wr = 0;
+	if ( ch->rd == wr )
+		return 0;
+
+	w = ch->buf[ch->rd];
+	ch->rd++;
+	if ( ch->rd >= ch->nwords )
+		ch->rd = 0;
+
+	/* The event is 2*d cycles after the previous one. d is less than 2^31, so 2*d times the
+	 * length of a cycle (in 32.32 fixed-point microseconds) fits in 64 bits.
+	*/
+	d = rp2040_edgecap_delta(ch->prev, w);
+	ch->prev = w >> 1;
+
+	edgecap_mul(d, cap->us_per_cyc, &hi, &lo);
+	hi = (hi << 1) | (lo >> 31);
+	lo <<= 1;
+
+	ch->frac += lo;
+	if ( ch->frac < lo )
+		hi++;
+	ch->us += hi;
+
+	ch->next.time = cap->t0 + ch->us;
+	edgecap_mul(ch->frac, 1000, &ch->next.ns, &lo);
+	ch->next.pin = ch->pin;
+	ch->next.level = (u8_t)(w & 1);
+	ch->have_next = 1;
+	return 1;
+}
+
+/* rp2040_edgecap_read() - get the next edge event, in time order across all the pins
+ *
+ * Returns 1 if an event was stored in *ev, 0 if there are no new events.
+ *
+ * Events from different pins are only ordered correctly among the events that have already been
+ * captured, so an event on one pin might be returned before an earlier event on another pin that
+ * hasn't reached its ring buffer yet (a few clk_sys cycles).
+*/
+int rp2040_edgecap_read(rp2040_edgecap_t *cap, rp2040_edge_t *ev)
+{
+	rp2040_edgecap_chan_t *best = 0;
+
+	for ( int i = 0; i < cap->npins; i++ )
+	{
+		rp2040_edgecap_chan_t *ch = &cap->chan[i];
+
+		if ( edgecap_fetch(cap, ch) )
+		{
+			if ( best == 0 ||
+				 ch->next.time < best->next.time ||
+				 ( ch->next.time == best->next.time && ch->next.ns < best->next.ns ) )
+			{
+				best = ch;
+			}
+		}
+	}
+
+	if ( best == 0 )
+		return 0;
+
+	*ev = best->next;
+	best->have_next = 0;
+	return 1;
+}
+
+/* rp2040_edgecap_stop() - stop the state machines and the DMA
+*/
+void rp2040_edgecap_stop(rp2040_edgecap_t *cap)
+{
+	rp2040_pio_disable(cap->pio, (1u << cap->npins) - 1);
+
+	for ( int i = 0; i < cap->npins; i++ )
+	{
+		rp2040_piodma_stop(&cap->chan[i].stream);
+	}
+
+	edgecap_active[(cap->pio == &rp2040_pio0) ? 0 : 1] = 0;
+}
@@ -0,0 +1,94 @@
+/* rp2040-gpioirq.c - GPIO interrupt dispatcher
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-nvic.h"
+#include "rp2040-gpioirq.h"
+#include "rp2040-gpio.h"
+#include "rp2040-sio.h"
+#include "rp2040-timer.h"
+
+static rp2040_gpioirq_fn_t gpioirq_fn[RP2040_GPIOIRQ_NPIN];
+
+static void gpioirq_dispatch(void);
+
+/* rp2040_gpioirq_init() - install the GPIO interrupt dispatcher on the calling core
+ *
+ * prio is NVIC_PRIO_0 to NVIC_PRIO_3.
+*/
+void rp2040_gpioirq_init(u32_t prio)
+{
+	rp2040_nvic_disable(irq_io_bank0);
+	(void)rp2040_irq_set_handler(irq_io_bank0, gpioirq_dispatch);
+	rp2040_nvic_set_priority(irq_io_bank0, prio);
+	rp2040_nvic_unpend(irq_io_bank0);
+	rp2040_nvic_enable(irq_io_bank0);
+}
+
+/* rp2040_gpioirq_set() - set the interrupt events and function of a pin
+ *
+ * events is a combination of GPIO_IRQ_xxx; 0 disables the pin's interrupt. The interrupt goes to the
+ * calling core. Old edge events are cleared.
+*/
+void rp2040_gpioirq_set(int pin, u32_t events, rp2040_gpioirq_fn_t fn)
+{
+	u32_t core = rp2040_sio.cpuid & 0x1;
+	int w = pin >> 3;
+	u32_t shift = (u32_t)(pin & 0x7) * 4;
+	u32_t mask = 0xfu << shift;
+
+	rp2040_iobank0_w1c.proc_intctl[core ^ 0x1].inte[w] = mask;
+	rp2040_iobank0_w1c.proc_intctl[core].inte[w] = mask;
+
+	gpioirq_fn[pin] = fn;
+	__asm__ volatile("dmb" : : : "memory");		/* The old function might be running on the other core */
+
+	if ( events != 0 )
+	{
+		rp2040_iobank0.intr[w] = mask;
+		rp2040_iobank0_w1s.proc_intctl[core].inte[w] = (events & 0xf) << shift;
+	}
+}
+
+/* gpioirq_dispatch() - handler for IO_IRQ_BANK0
+*/
+RP2040_TIME_CRITICAL static void gpioirq_dispatch(void)
+{
+	u32_t time = rp2040_timer.time_lraw;
+	rp2040_io_intctl_t *ctl = &rp2040_iobank0.proc_intctl[rp2040_sio.cpuid & 0x1];
+
+	for ( int w = 0; w < 4; w++ )
+	{
+		u32_t s = ctl->ints[w];
+
+		while ( s != 0 )
+		{
+			u32_t shift = cxm_lowest_bit(s) & ~0x3u;
+			u32_t events = (s >> shift) & 0xf;
+			int pin = w * 8 + (int)(shift >> 2);
+			rp2040_gpioirq_fn_t fn = gpioirq_fn[pin];
+
+			s &= ~(0xfu << shift);
+			rp2040_iobank0.intr[w] = (events & GPIO_IRQ_EDGE) << shift;
+			if ( fn != 0 )		/* Disabled since ints was read */
+				fn(pin, events, time);
+		}
+	}
+}
@@ -0,0 +1,315 @@
+/* rp2040-irqprof.c - interrupt latency and execution-time profiler
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-nvic.h"
+#include "rp2040-irqprof.h"
+#include "rp2040-timer.h"
+#include "rp2040-clocks.h"
+#include "rp2040-sio.h"
+#include "rp2040-cm0.h"
+
+typedef struct irqprof_core_s
+{
+	rp2040_vector_t handler[nvic_nirq];		/* The real handlers of the attached IRQs */
+	u32_t ref[nvic_nirq];					/* Latency reference times (SysTick) */
+	volatile u8_t ref_valid[nvic_nirq];		/* Non-zero if ref[] is valid */
+	u32_t child;							/* Time spent in nested handlers; see irqprof_wrapper() */
+	u32_t depth;							/* Current nesting depth */
+	u32_t max_depth;
+	u32_t crit_start;						/* Start of the current critical section */
+	u32_t max_crit;
+	rp2040_irqstat_t stat[nvic_nirq];
+} irqprof_core_t;
+
+static irqprof_core_t irqprof[2];
+static u32_t irqprof_cyc_per_us;			/* For the TIMER latencies */
+static rp2040_clk_notifier_t irqprof_clk_notifier;
+
+static void irqprof_wrapper(void);
+
+static inline irqprof_core_t *irqprof_core(void)
+{
+	return &irqprof[rp2040_sio.cpuid & 0x1];
+}
+
+/* irqprof_record() - add a time to a histogram and update the maximum
+*/
+static void irqprof_record(u32_t *max, u16_t *hist, u32_t t)
+{
+	int b = rp2040_irqprof_bucket(t);
+
+	if ( hist[b] < 0xffff )
+		hist[b]++;
+	if ( t > *max )
+		*max = t;
+}
+
+/* irqprof_clk_notify() - clock change notifier: recalculate the cycles per microsecond
+ *
+ * A TIMER latency that spans the change is converted at the new frequency.
+*/
+static void irqprof_clk_notify(rp2040_clk_notifier_t *n, int phase, u32_t old_hz, u32_t new_hz)
+{
+	if ( phase == RP2040_CLK_POST )
+		irqprof_cyc_per_us = rp2040_udiv(new_hz, 1000000, 0);
+}
+
+/* rp2040_irqprof_init() - start SysTick and clear the statistics for the calling core
+*/
+void rp2040_irqprof_init(void)
+{
+	cxm_systick_start();
+	irqprof_cyc_per_us = rp2040_udiv(rp2040_clk_sys_hz(), 1000000, 0);
+	rp2040_clk_notifier_register(&irqprof_clk_notifier, irqprof_clk_notify);
+	rp2040_irqprof_reset();
+}
+
+/* rp2040_irqprof_reset() - clear the statistics for the calling core
+ *
+ * The attached handlers remain attached.
+*/
+void rp2040_irqprof_reset(void)
+{
+	irqprof_core_t *c = irqprof_core();
+	intstatus_t is = disable();
+
+	for ( int i = 0; i < nvic_nirq; i++ )
+	{
+		rp2040_irqstat_t *st = &c->stat[i];
+
+		st->count = 0;
+		st->n_lat = 0;
+		st->max_exec = 0;
+		st->max_lat = 0;
+		for ( int b = 0; b < RP2040_IRQPROF_NBUCKET; b++ )
+		{
+			st->exec[b] = 0;
+			st->lat[b] = 0;
+		}
+		c->ref_valid[i] = 0;
+	}
+	c->max_depth = 0;
+	c->max_crit = 0;
+
+	restore(is);
+}
+
+/* rp2040_irqprof_attach() - insert the profiling wrapper in front of an IRQ's handler on the calling core
+*/
+void rp2040_irqprof_attach(irqid_t irq)
+{
+	irqprof_core_t *c = irqprof_core();
+	boolean_t enabled = rp2040_nvic_is_enabled(irq);
+	rp2040_vector_t old;
+
+	rp2040_nvic_disable(irq);
+	old = rp2040_irq_set_handler(irq, irqprof_wrapper);
+	if ( old != irqprof_wrapper )
+		c->handler[irq] = old;
+	if ( enabled )
+		rp2040_nvic_enable(irq);
+}
+
+/* rp2040_irqprof_detach() - remove the profiling wrapper from an IRQ on the calling core
+*/
+void rp2040_irqprof_detach(irqid_t irq)
+{
+	irqprof_core_t *c = irqprof_core();
+	boolean_t enabled = rp2040_nvic_is_enabled(irq);
+	rp2040_vector_t old;
+
+	rp2040_nvic_disable(irq);
+	old = rp2040_irq_set_handler(irq, c->handler[irq]);
+	if ( old != irqprof_wrapper )
+		(void)rp2040_irq_set_handler(irq, old);		/* Wasn't attached */
+	if ( enabled )
+		rp2040_nvic_enable(irq);
+}
+
+/* rp2040_irqprof_ref() - record the reference time for the next entry latency of an IRQ
+*/
+void rp2040_irqprof_ref(irqid_t irq)
+{
+	irqprof_core_t *c = irqprof_core();
+
+	c->ref[irq] = cxm_systick_read();
+	c->ref_valid[irq] = 1;
+}
+
+/* rp2040_irqprof_get() - get a consistent copy of an IRQ's statistics
+*/
+void rp2040_irqprof_get(irqid_t irq, rp2040_irqstat_t *st)
+{
+	irqprof_core_t *c = irqprof_core();
+	intstatus_t is = disable();
+	*st = c->stat[irq];
+	restore(is);
+}
+
+u32_t rp2040_irqprof_max_crit(void)
+{
+	return irqprof_core()->max_crit;
+}
+
+u32_t rp2040_irqprof_max_depth(void)
+{
+	return irqprof_core()->max_depth;
+}
+
+/* rp2040_irqprof_crit_enter()/rp2040_irqprof_crit_exit() - measure a critical section
+ *
+ * Called from disable() and restore() when RP2040_IRQPROF is set. Interrupts are disabled
+ * during both calls, so there's no need for any locking.
+*/
+RP2040_TIME_CRITICAL void rp2040_irqprof_crit_enter(void)
+{
+	irqprof_core()->crit_start = cxm_systick_read();
+}
+
+RP2040_TIME_CRITICAL void rp2040_irqprof_crit_exit(void)
+{
+	irqprof_core_t *c = irqprof_core();
+	u32_t t = cxm_systick_elapsed(c->crit_start, cxm_systick_read());
+
+	if ( t > c->max_crit )
+		c->max_crit = t;
+}
+
+/* irqprof_wrapper() - the profiling handler for all attached IRQs
+ *
+ * The execution time of a handler excludes the time spent in nested handlers. Each wrapper adds its
+ * gross time to its parent's child time (c->child), which the parent subtracts from its own gross time.
+ * The nesting bookkeeping is done with interrupts disabled, directly with PRIMASK so that it doesn't
+ * count as a critical section.
+ *
+ * The latency of a TIMER IRQ is measured from the alarm time, in microseconds, unless there's a
+ * reference from rp2040_irqprof_ref().
+*/
+RP2040_TIME_CRITICAL static void irqprof_wrapper(void)
+{
+	u32_t irq = (cxm_get_ipsr() & 0x3f) - 16;
+	irqprof_core_t *c = irqprof_core();
+	rp2040_irqstat_t *st = &c->stat[irq];
+	u32_t t0, gross, parent_child;
+	u32_t lat = 0;
+	boolean_t have_lat = 0;
+	u32_t pm;
+
+	pm = cxm_get_primask();
+	cxm_set_primask(INTDISABLED);
+	t0 = cxm_systick_read();
+	parent_child = c->child;
+	c->child = 0;
+	c->depth++;
+	if ( c->depth > c->max_depth )
+		c->max_depth = c->depth;
+	cxm_set_primask(pm);
+
+	if ( c->ref_valid[irq] )
+	{
+		lat = cxm_systick_elapsed(c->ref[irq], t0);
+		c->ref_valid[irq] = 0;
+		have_lat = 1;
+	}
+	else if ( irq <= irq_timer3 )
+	{
+		u32_t us = rp2040_timer.time_lraw - rp2040_timer.alarm[irq];
+
+		if ( us < 100000 )
+			lat = us * irqprof_cyc_per_us;
+		else
+			lat = SYST_MASK;		/* Not from the alarm (e.g. forced), or very late */
+		have_lat = 1;
+	}
+
+	c->handler[irq]();
+
+	cxm_set_primask(INTDISABLED);
+	gross = cxm_systick_elapsed(t0, cxm_systick_read());
+	irqprof_record(&st->max_exec, st->exec, gross - c->child);
+	st->count++;
+	if ( have_lat )
+	{
+		st->n_lat++;
+		irqprof_record(&st->max_lat, st->lat, lat);
+	}
+	c->child = parent_child + gross;
+	c->depth--;
+	cxm_set_primask(pm);
+}
+
+static void irqprof_puthist(void (*putc)(char), const char *name, int irq, const u16_t *hist)
+{
+	rp2040_puts(putc, name);
+	rp2040_putdec(putc, (u32_t)irq);
+	for ( int b = 0; b < RP2040_IRQPROF_NBUCKET; b++ )
+	{
+		putc(',');
+		rp2040_putdec(putc, hist[b]);
+	}
+	putc('\n');
+}
+
+/* rp2040_irqprof_dump() - print the statistics for the calling core
+ *
+ * The output is comma-separated, one record per line, all times in CPU cycles:
+ *	IRQPROF,<core>,<max depth>,<max critical section>
+ *	IRQ,<irq>,<count>,<max exec>,<no. of latencies>,<max latency>
+ *	EXEC,<irq>,<bucket 0>,...		(histogram of execution times)
+ *	LAT,<irq>,<bucket 0>,...		(histogram of latencies, if there are any)
+ * The IRQ, EXEC and LAT lines are omitted for IRQs that haven't been called.
+*/
+void rp2040_irqprof_dump(void (*putc)(char))
+{
+	rp2040_irqstat_t st;
+
+	rp2040_puts(putc, "IRQPROF,");
+	rp2040_putdec(putc, rp2040_sio.cpuid & 0x1);
+	putc(',');
+	rp2040_putdec(putc, rp2040_irqprof_max_depth());
+	putc(',');
+	rp2040_putdec(putc, rp2040_irqprof_max_crit());
+	putc('\n');
+
+	for ( int i = 0; i < nvic_nirq; i++ )
+	{
+		rp2040_irqprof_get((irqid_t)i, &st);
+
+		if ( st.count != 0 )
+		{
+			rp2040_puts(putc, "IRQ,");
+			rp2040_putdec(putc, (u32_t)i);
+			putc(',');
+			rp2040_putdec(putc, st.count);
+			putc(',');
+			rp2040_putdec(putc, st.max_exec);
+			putc(',');
+			rp2040_putdec(putc, st.n_lat);
+			putc(',');
+			rp2040_putdec(putc, st.max_lat);
+			putc('\n');
+
+			irqprof_puthist(putc, "EXEC,", i, st.exec);
+			if ( st.n_lat != 0 )
+				irqprof_puthist(putc, "LAT,", i, st.lat);
+		}
+	}
+}
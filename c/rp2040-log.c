@@ -0,0 +1,159 @@
+/* rp2040-log.c - deferred binary logging
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-log.h"
+#include "rp2040-uart.h"
+
+#define LOG_MAXFRAME	(1 + 1 + 2 + 4 + 4 * RP2040_LOG_MAXARG + 1)
+
+rp2040_logring_t rp2040_logring[2];
+
+/* The drain's state: the frame that is being sent. Only one drain may run at a time.
+*/
+static u8_t log_frame[LOG_MAXFRAME];
+static int log_len;
+static int log_pos;
+static int log_core;
+static u32_t log_dropped[2];	/* No. of dropped records already reported */
+
+static void log_put32(u8_t *p, u32_t v)
+{
+	p[0] = (u8_t)v;
+	p[1] = (u8_t)(v >> 8);
+	p[2] = (u8_t)(v >> 16);
+	p[3] = (u8_t)(v >> 24);
+}
+
+/* log_encode() - build a frame from a header and its arguments
+*/
+static int log_encode(int core, u32_t id, u32_t n, u32_t ts, const u32_t *arg)
+{
+	u8_t *p = log_frame;
+	u8_t sum = 0;
+
+	*p++ = RP2040_LOG_SYNC;
+	*p++ = (u8_t)((core << 7) | n);
+	*p++ = (u8_t)id;
+	*p++ = (u8_t)(id >> 8);
+	log_put32(p, ts);
+	p += 4;
+	for ( u32_t i = 0; i < n; i++ )
+	{
+		log_put32(p, arg[i]);
+		p += 4;
+	}
+
+	for ( u8_t *q = &log_frame[1]; q < p; q++ )
+		sum ^= *q;
+	*p++ = sum;
+
+	return (int)(p - log_frame);
+}
+
+/* log_next() - take the next record from one of the rings and encode it
+ *
+ * The rings are taken in turn, so that a busy core can't hide the other one's records.
+ * A change in the dropped count is reported before the next record from that core.
+ * Returns the length of the frame, or 0 if there's nothing to send.
+*/
+static int log_next(void)
+{
+	for ( int k = 0; k < 2; k++ )
+	{
+		int core = log_core;
+		rp2040_logring_t *r = &rp2040_logring[core];
+		const u32_t m = RP2040_LOG_SIZE - 1;
+
+		log_core ^= 1;
+
+		u32_t d = r->dropped;
+		if ( d != log_dropped[core] )
+		{
+			u32_t n_dropped = d - log_dropped[core];
+			log_dropped[core] = d;
+			return log_encode(core, RP2040_LOG_DROPPED, 1, rp2040_timer.time_lraw, &n_dropped);
+		}
+
+		u32_t t = r->tail;
+		if ( r->head != t )
+		{
+			u32_t arg[RP2040_LOG_MAXARG];
+
+			__asm__ volatile("dmb" : : : "memory");		/* Read the record after the head */
+
+			u32_t hdr = r->buf[t & m];
+			u32_t n = (hdr >> 16) & 0xf;
+			u32_t ts = r->buf[(t + 1) & m];
+
+			for ( u32_t i = 0; i < n; i++ )
+				arg[i] = r->buf[(t + 2 + i) & m];
+
+			__asm__ volatile("dmb" : : : "memory");		/* Finish reading before releasing the space */
+			r->tail = t + n + 2;
+
+			return log_encode(core, hdr & 0xffff, n, ts, arg);
+		}
+	}
+	return 0;
+}
+
+/* rp2040_log_poll() - send log records to a UART without waiting
+ *
+ * Returns true if there is more to send.
+*/
+boolean_t rp2040_log_poll(rp2040_uart_t *uart)
+{
+	for (;;)
+	{
+		if ( log_pos >= log_len )
+		{
+			log_len = log_next();
+			log_pos = 0;
+			if ( log_len == 0 )
+				return 0;
+		}
+
+		while ( log_pos < log_len )
+		{
+			if ( !rp2040_uart_istx(uart) )
+				return 1;
+			uart->dr = log_frame[log_pos++];
+		}
+	}
+}
+
+/* rp2040_log_flush() - send all log records to a character sink
+ *
+ * The sink must send the bytes unchanged (e.g. no '\n' to "\r\n" translation).
+*/
+void rp2040_log_flush(void (*putc)(char))
+{
+	for (;;)
+	{
+		while ( log_pos < log_len )
+			putc((char)log_frame[log_pos++]);
+
+		log_len = log_next();
+		log_pos = 0;
+		if ( log_len == 0 )
+			return;
+	}
+}
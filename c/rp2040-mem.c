@@ -0,0 +1,183 @@
+/* rp2040-mem.c - fixed-block pools and bump arenas
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-mem.h"
+#include "rp2040-sio.h"
+#include "rp2040-cm0.h"
+
+/* rp2040_pool_init() - initialise a pool in the memory at mem
+ *
+ * The block size is rounded up to a multiple of 4 bytes, and mem must be 4-byte aligned.
+ * Returns the number of blocks.
+*/
+u32_t rp2040_pool_init(rp2040_pool_t *p, void *mem, u32_t mem_size, u32_t block_size, int lock)
+{
+	block_size = (block_size + 3) & ~0x3u;
+	if ( block_size == 0 )
+		block_size = 4;
+
+	p->base = mem;
+	p->block_size = block_size;
+	p->n_blocks = rp2040_udiv(mem_size, block_size, 0);
+	p->n_used = 0;
+	p->max_used = 0;
+	p->n_fail = 0;
+	p->lock = lock;
+
+	/* Build the free list, lowest address first. The first word of a free block is the link.
+	*/
+	p->free = 0;
+	for ( u32_t i = p->n_blocks; i > 0; i-- )
+	{
+		void **b = (void **)(p->base + (i - 1) * block_size);
+		*b = p->free;
+		p->free = b;
+	}
+
+	return p->n_blocks;
+}
+
+/* rp2040_pool_alloc() - allocate a block from a pool
+ *
+ * Returns 0 if the pool is empty.
+*/
+void *rp2040_pool_alloc(rp2040_pool_t *p)
+{
+	intstatus_t is = rp2040_spin_lock(p->lock);
+	void **b = p->free;
+
+	if ( b == 0 )
+		p->n_fail++;
+	else
+	{
+		p->free = *b;
+		p->n_used++;
+		if ( p->n_used > p->max_used )
+			p->max_used = p->n_used;
+	}
+
+	rp2040_spin_unlock(p->lock, is);
+	return b;
+}
+
+/* rp2040_pool_free() - return a block to its pool
+*/
+void rp2040_pool_free(rp2040_pool_t *p, void *b)
+{
+	intstatus_t is;
+
+	if ( b == 0 )
+		return;
+
+	is = rp2040_spin_lock(p->lock);
+	*(void **)b = p->free;
+	p->free = b;
+	p->n_used--;
+	rp2040_spin_unlock(p->lock, is);
+}
+
+/* rp2040_pool_clearstats() - reset the high watermark to the current usage and clear the failure count
+*/
+void rp2040_pool_clearstats(rp2040_pool_t *p)
+{
+	intstatus_t is = rp2040_spin_lock(p->lock);
+	p->max_used = p->n_used;
+	p->n_fail = 0;
+	rp2040_spin_unlock(p->lock, is);
+}
+
+/* rp2040_arena_init() - initialise an arena in the memory at mem
+*/
+void rp2040_arena_init(rp2040_arena_t *a, void *mem, u32_t mem_size, int lock)
+{
+	a->base = mem;
+	a->size = mem_size;
+	a->used = 0;
+	a->max_used = 0;
+	a->n_fail = 0;
+	a->lock = lock;
+}
+
+/* rp2040_arena_init_heap() - initialise an arena in the free RAM between the .bss and the stacks
+*/
+void rp2040_arena_init_heap(rp2040_arena_t *a, int lock)
+{
+	rp2040_arena_init(a, rp2040_heap_start, (u32_t)(rp2040_heap_end - rp2040_heap_start), lock);
+}
+
+/* rp2040_arena_alloc() - allocate size bytes from an arena
+ *
+ * The block is aligned to RP2040_ARENA_ALIGN bytes. Returns 0 if there isn't enough space.
+*/
+void *rp2040_arena_alloc(rp2040_arena_t *a, u32_t size)
+{
+	intstatus_t is = rp2040_spin_lock(a->lock);
+	u32_t start = (u32_t)a->base + a->used;
+	u32_t pad = (RP2040_ARENA_ALIGN - (start & (RP2040_ARENA_ALIGN - 1))) & (RP2040_ARENA_ALIGN - 1);
+	u8_t *b = 0;
+
+	if ( size <= a->size - a->used && pad <= a->size - a->used - size )
+	{
+		b = a->base + a->used + pad;
+		a->used += pad + size;
+		if ( a->used > a->max_used )
+			a->max_used = a->used;
+	}
+	else
+		a->n_fail++;
+
+	rp2040_spin_unlock(a->lock, is);
+	return b;
+}
+
+/* rp2040_arena_mark() - return the current allocation point, for rp2040_arena_release()
+*/
+u32_t rp2040_arena_mark(rp2040_arena_t *a)
+{
+	return a->used;
+}
+
+/* rp2040_arena_release() - free everything that was allocated after the mark was taken
+*/
+void rp2040_arena_release(rp2040_arena_t *a, u32_t mark)
+{
+	intstatus_t is = rp2040_spin_lock(a->lock);
+	if ( mark < a->used )
+		a->used = mark;
+	rp2040_spin_unlock(a->lock, is);
+}
+
+/* rp2040_arena_reset() - free everything in an arena
+*/
+void rp2040_arena_reset(rp2040_arena_t *a)
+{
+	rp2040_arena_release(a, 0);
+}
+
+/* rp2040_arena_clearstats() - reset the high watermark to the current usage and clear the failure count
+*/
+void rp2040_arena_clearstats(rp2040_arena_t *a)
+{
+	intstatus_t is = rp2040_spin_lock(a->lock);
+	a->max_used = a->used;
+	a->n_fail = 0;
+	rp2040_spin_unlock(a->lock, is);
+}
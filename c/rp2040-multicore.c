@@ -20,6 +20,7 @@
 #include "rp2040.h"
 #include "rp2040-types.h"
 #include "rp2040-sio.h"
+#include "rp2040-delay.h"
 
 /* Debugging. Remove later */
 #ifdef DEBUG
@@ -41,6 +42,12 @@
 
 #define START_SEQ_LEN	6
 
+/* Core 1 answers each word of the start sequence within a few microseconds, so this is generous
+*/
+#ifndef RP2040_CORE1_TIMEOUT_US
+#define RP2040_CORE1_TIMEOUT_US	100000
+#endif
+
 extern u32_t rp2040_stacktop1, rp2040_entry1;	/* Dummy types - these are linker symbols */
 
 static const u32_t start_seq[START_SEQ_LEN] =
@@ -54,12 +61,18 @@ static const u32_t start_seq[START_SEQ_LEN] =
  *
  * This code is based on the example from the RP2040 data sheet
  * Section 2.8.2. "Launching Code On Processor Core 1"
+ *
+ * Returns 0 if core 1 has started, -1 if it didn't respond within RP2040_CORE1_TIMEOUT_US.
 */
-void rp2040_start_core1(void)
+int rp2040_start_core1(void)
 {
 	u32_t cmd, resp;
+	u32_t deadline = rp2040_deadline(RP2040_CORE1_TIMEOUT_US);
 
 	do {
+		if ( rp2040_deadline_passed(deadline) )
+			return -1;
+
 		for ( int i = 0; i < START_SEQ_LEN; i++ )
 		{
 			cmd = start_seq[i];
@@ -80,22 +93,20 @@ void rp2040_start_core1(void)
 				__asm__ volatile("sev" : : : "memory");
 			}
 
-			while ( (rp2040_sio.fifo_st & SIO_FIFO_RDY) == 0 )
-			{
-				DBG_PUTC('b');
-				/* Wait until the tx fifo has space */
-			}
+			/* Wait until the tx fifo has space
+			*/
+			if ( rp2040_wait_reg(&rp2040_sio.fifo_st, SIO_FIFO_RDY, SIO_FIFO_RDY, RP2040_CORE1_TIMEOUT_US) != 0 )
+				return -1;
 
 			DBG_PUTC('\n');
 			rp2040_sio.fifo_wr = cmd;	/* Send the command */
 
 			__asm__ volatile("sev" : : : "memory");		/* Not shown in data sheet but appears to be needed */
 
-			while ( (rp2040_sio.fifo_st & SIO_FIFO_VLD) == 0 )
-			{
-				DBG_PUTC('c');
-				/* Wait for the response */
-			}
+			/* Wait for the response
+			*/
+			if ( rp2040_wait_reg(&rp2040_sio.fifo_st, SIO_FIFO_VLD, SIO_FIFO_VLD, RP2040_CORE1_TIMEOUT_US) != 0 )
+				return -1;
 
 			DBG_PUTC('\n');
 			resp = rp2040_sio.fifo_rd;	/* Read the response */
@@ -107,4 +118,6 @@ void rp2040_start_core1(void)
 			}
 		}
 	} while ( resp != cmd );
+
+	return 0;
 }
@@ -0,0 +1,187 @@
+/* rp2040-pio.c - PIO state machine configuration
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-pio.h"
+#include "rp2040-clocks.h"
+#include "rp2040-sio.h"
+
+/* The W1S and W1C aliases of a PIO, given the address of its plain register block
+*/
+#define PIO_W1S(pio)	((rp2040_pio_t *)((u32_t)(pio) + RP2040_OFFSET_W1S))
+#define PIO_W1C(pio)	((rp2040_pio_t *)((u32_t)(pio) + RP2040_OFFSET_W1C))
+
+/* FDEBUG sticky flags (TXSTALL, TXOVER, RXUNDER, RXSTALL) for a state machine
+*/
+#define PIO_FDEBUG_ALL(sm)	(0x01010101 << (sm))
+
+/* rp2040_piosm_cfg_freq() - set the clock divider to give a state machine frequency of hz
+ *
+ * The divider is clk_sys/hz in 16.8 fixed point, truncated.
+ * The integer part is calculated with the SIO divider. The 8-bit fraction is calculated from the
+ * remainder by shift and subtract, because remainder * 256 might not fit in 32 bits.
+ *
+ * Returns 0 if OK, -1 if the frequency can't be reached (divider < 1 or >= 65536).
+ * The configuration is unchanged in the error case.
+*/
+int rp2040_piosm_cfg_freq(rp2040_piosm_cfg_t *cfg, u32_t hz)
+{
+	u32_t rem;
+	u32_t div_int;
+	u32_t div_frac = 0;
+
+	if ( hz == 0 )
+		return -1;
+
+	div_int = rp2040_udiv(rp2040_clk_sys_hz(), hz, &rem);
+
+	if ( div_int < 1 || div_int > 0xffff )
+		return -1;
+
+	for ( int i = 0; i < 8; i++ )
+	{
+		rem = rem << 1;
+		div_frac = div_frac << 1;
+		if ( rem >= hz )
+		{
+			rem -= hz;
+			div_frac |= 1;
+		}
+	}
+
+	rp2040_piosm_cfg_clkdiv(cfg, div_int, div_frac);
+	return 0;
+}
+
+/* rp2040_piosm_apply() - write a configuration to a state machine
+ *
+ * The state machine is stopped and all four control registers are written while it is stopped.
+ * Then the FIFOs are flushed, the sticky FIFO debug flags are cleared, the state machine and
+ * its clock divider are restarted and the state machine is forced to jump to start_addr.
+ *
+ * The state machine is left disabled. Start it (and others, in sync) with rp2040_pio_enable().
+*/
+void rp2040_piosm_apply(rp2040_pio_t *pio, int sm, const rp2040_piosm_cfg_t *cfg, u32_t start_addr)
+{
+	rp2040_piosm_t *psm = &pio->sm[sm];
+
+	PIO_W1C(pio)->ctrl = PIO_SM_ENABLE(sm);
+
+	psm->clkdiv = cfg->clkdiv;
+	psm->execctrl = cfg->execctrl;
+	psm->pinctrl = cfg->pinctrl;
+
+	/* Changing FJOIN_RX flushes both FIFOs. Toggle it twice so that the FIFOs
+	 * are always empty, even if the join configuration hasn't changed.
+	*/
+	psm->shiftctrl = cfg->shiftctrl ^ PIO_FJOIN_RX;
+	psm->shiftctrl = cfg->shiftctrl;
+
+	pio->fdebug = PIO_FDEBUG_ALL(sm);		/* w1c */
+
+	/* Both restart bits are self-clearing.
+	*/
+	PIO_W1S(pio)->ctrl = PIO_SM_RESTART(sm) | PIO_CLKDIV_RESTART(sm);
+
+	psm->instr = PIO_JMP | PIO_JMP_ALWAYS | (start_addr & 0x1f);
+}
+
+/* rp2040_pio_enable() - enable one or more state machines of a PIO
+ *
+ * smmask has one bit for each state machine (bit 0 = SM0 etc.)
+ * The clock dividers are restarted in the same write, so all the state machines in the mask
+ * run in lock-step if they have the same divider.
+*/
+void rp2040_pio_enable(rp2040_pio_t *pio, u32_t smmask)
+{
+	smmask &= 0xf;
+	PIO_W1S(pio)->ctrl = (smmask << 8) | smmask;		/* CLKDIV_RESTART | SM_ENABLE */
+}
+
+/* rp2040_pio_disable() - disable one or more state machines of a PIO
+ *
+ * smmask has one bit for each state machine (bit 0 = SM0 etc.)
+*/
+void rp2040_pio_disable(rp2040_pio_t *pio, u32_t smmask)
+{
+	PIO_W1C(pio)->ctrl = smmask & 0xf;
+}
+
+/* State machine frequencies that are kept across clk_sys changes; 0 = not kept
+*/
+static u32_t pio_sm_hz[2][4];
+static rp2040_clk_notifier_t pio_clk_notifier;
+
+/* pio_set_clkdiv() - set a running state machine's clock divider for hz at the current clk_sys
+ *
+ * If hz can't be reached the nearest divider (1 or 65535) is used and the return value is -1.
+*/
+static int pio_set_clkdiv(rp2040_pio_t *pio, int sm, u32_t hz)
+{
+	rp2040_piosm_cfg_t cfg;
+	int result = rp2040_piosm_cfg_freq(&cfg, hz);
+
+	if ( result != 0 )
+	{
+		if ( hz >= rp2040_clk_sys_hz() )
+			rp2040_piosm_cfg_clkdiv(&cfg, 1, 0);
+		else
+			rp2040_piosm_cfg_clkdiv(&cfg, 0xffff, 0);
+	}
+	pio->sm[sm].clkdiv = cfg.clkdiv;
+	return result;
+}
+
+/* pio_clk_notify() - clock change notifier: recalculate the dividers after a change of clk_sys
+*/
+static void pio_clk_notify(rp2040_clk_notifier_t *n, int phase, u32_t old_hz, u32_t new_hz)
+{
+	if ( phase != RP2040_CLK_POST )
+		return;
+
+	for ( int sm = 0; sm < 4; sm++ )
+	{
+		if ( pio_sm_hz[0][sm] != 0 )
+			(void)pio_set_clkdiv(&rp2040_pio0, sm, pio_sm_hz[0][sm]);
+		if ( pio_sm_hz[1][sm] != 0 )
+			(void)pio_set_clkdiv(&rp2040_pio1, sm, pio_sm_hz[1][sm]);
+	}
+}
+
+/* rp2040_pio_sm_set_freq() - set a state machine's frequency and keep it when clk_sys changes
+ *
+ * The divider is written directly, so this can be used while the state machine is running, e.g. after
+ * rp2040_piosm_apply(). If clk_sys changes later (rp2040_clk_sys_set()), the divider is recalculated
+ * so that the state machine keeps running at hz, as nearly as the new clk_sys allows.
+ * hz == 0 stops the tracking and leaves the divider as it is.
+ *
+ * Returns 0 if OK, -1 if hz can't be reached at the current clk_sys (the nearest divider is used).
+*/
+int rp2040_pio_sm_set_freq(rp2040_pio_t *pio, int sm, u32_t hz)
+{
+	int p = (pio == &rp2040_pio0) ? 0 : 1;
+
+	pio_sm_hz[p][sm] = hz;
+	if ( hz == 0 )
+		return 0;
+
+	rp2040_clk_notifier_register(&pio_clk_notifier, pio_clk_notify);
+	return pio_set_clkdiv(pio, sm, hz);
+}
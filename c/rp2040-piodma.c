@@ -0,0 +1,181 @@
+/* rp2040-piodma.c - streaming between memory and PIO FIFOs using DMA
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-pio.h"
+#include "rp2040-dma.h"
+#include "rp2040-piodma.h"
+
+/* Control bits that are common to all the data channels. The error bits are w1c.
+*/
+#define PIODMA_CTRL		(DMA_READ_ERROR | DMA_WRITE_ERROR | DMA_RING_NONE | DMA_SIZE_WORD | DMA_CHANNEL_EN)
+
+/* piodma_data_channel() - set up a data channel without triggering it
+ *
+ * The FIFO end of the transfer is fixed; the memory end increments.
+*/
+static void piodma_data_channel(rp2040_pio_t *pio, int sm, int dir, int ch, u32_t addr, u32_t nwords, int chain)
+{
+	rp2040_dmac_t *c = &rp2040_dma.ch[ch];
+	u32_t ctrl = PIODMA_CTRL | DMA_TREQ_VAL(rp2040_pio_dreq(pio, sm, dir)) | DMA_CHAIN_VAL(chain);
+
+	if ( dir == RP2040_PIODMA_RX )
+	{
+		c->read_addr = (u32_t)&pio->rxf[sm];
+		c->write_addr = addr;
+		ctrl |= DMA_INCR_WRITE;
+	}
+	else
+	{
+		c->read_addr = addr;
+		c->write_addr = (u32_t)&pio->txf[sm];
+		ctrl |= DMA_INCR_READ;
+	}
+	c->trans_count = nwords;
+	c->al1_ctrl = ctrl;
+}
+
+/* rp2040_piodma_ring() - start a ring stream
+ *
+ * ch_data transfers the buffer to/from the FIFO. ch_ctl restarts ch_data at the beginning
+ * of the buffer each time it finishes.
+*/
+void rp2040_piodma_ring(rp2040_piodma_t *s, rp2040_pio_t *pio, int sm, int dir,
+						int ch_data, int ch_ctl, void *buf, u32_t nwords)
+{
+	rp2040_dmac_t *c = &rp2040_dma.ch[ch_ctl];
+
+	s->addr[0] = (u32_t)buf;
+	s->addr[1] = (u32_t)buf;
+	s->nwords = nwords;
+	s->ch[0] = (u8_t)ch_data;
+	s->ch[1] = (u8_t)ch_ctl;
+	s->mode = RP2040_PIODMA_RING;
+	s->dir = (u8_t)dir;
+
+	piodma_data_channel(pio, sm, dir, ch_data, s->addr[0], nwords, ch_ctl);
+
+	/* The control channel copies addr[0] to the data channel's address trigger register.
+	 * Chaining a channel to itself means "don't chain".
+	*/
+	c->read_addr = (u32_t)&s->addr[0];
+	if ( dir == RP2040_PIODMA_RX )
+		c->write_addr = (u32_t)&rp2040_dma.ch[ch_data].al2_write_addr_trig;
+	else
+		c->write_addr = (u32_t)&rp2040_dma.ch[ch_data].al3_read_addr_trig;
+	c->trans_count = 1;
+	c->al1_ctrl = PIODMA_CTRL | DMA_IRQ_QUIET | DMA_TREQ_VAL(TREQ_PERM) | DMA_CHAIN_VAL(ch_ctl);
+
+	/* Start by triggering the control channel. That loads the data channel's address and triggers it.
+	*/
+	rp2040_dma.multi_chan_trig = 1u << ch_ctl;
+}
+
+/* rp2040_piodma_double() - start a double-buffered stream
+ *
+ * Buffer 0 is transferred first. Each channel chains to the other.
+ * For TX, both buffers should be filled before calling this function.
+*/
+void rp2040_piodma_double(rp2040_piodma_t *s, rp2040_pio_t *pio, int sm, int dir,
+						int ch0, int ch1, void *buf0, void *buf1, u32_t nwords)
+{
+	s->addr[0] = (u32_t)buf0;
+	s->addr[1] = (u32_t)buf1;
+	s->nwords = nwords;
+	s->ch[0] = (u8_t)ch0;
+	s->ch[1] = (u8_t)ch1;
+	s->mode = RP2040_PIODMA_DOUBLE;
+	s->dir = (u8_t)dir;
+
+	/* Clear any stale completion flags before starting
+	*/
+	rp2040_dma.intcs[0].intr = (1u << ch0) | (1u << ch1);
+
+	piodma_data_channel(pio, sm, dir, ch1, s->addr[1], nwords, ch0);
+	piodma_data_channel(pio, sm, dir, ch0, s->addr[0], nwords, ch1);
+
+	rp2040_dma.multi_chan_trig = 1u << ch0;
+}
+
+/* rp2040_piodma_poll() - check for a completed buffer in a double-buffered stream
+ *
+ * Returns the index (0 or 1) of a buffer whose transfer has completed, or -1 if there is none.
+ * The channel's address is reset to the start of the buffer before returning, ready for when
+ * the other channel chains to it. The caller must refill (TX) or empty (RX) the buffer before the
+ * other buffer completes.
+ *
+ * If both buffers have completed since the last call, the caller is too slow. Buffer 0 is
+ * reported first in that case.
+ *
+ * Completion is detected using the raw interrupt status (INTR), so the DMA interrupts do not
+ * have to be enabled. Don't use this function if an interrupt handler also uses the same channels.
+*/
+int rp2040_piodma_poll(rp2040_piodma_t *s)
+{
+	if ( s->mode != RP2040_PIODMA_DOUBLE )
+		return -1;
+
+	for ( int i = 0; i < 2; i++ )
+	{
+		u32_t mask = 1u << s->ch[i];
+
+		if ( (rp2040_dma.intcs[0].intr & mask) != 0 )
+		{
+			rp2040_dma.intcs[0].intr = mask;		/* w1c */
+
+			/* Plain (non-trigger) address register. The transfer count reloads automatically
+			 * when the channel is triggered.
+			*/
+			if ( s->dir == RP2040_PIODMA_RX )
+				rp2040_dma.ch[s->ch[i]].write_addr = s->addr[i];
+			else
+				rp2040_dma.ch[s->ch[i]].read_addr = s->addr[i];
+			return i;
+		}
+	}
+	return -1;
+}
+
+/* rp2040_piodma_position() - the index of the next word to be transferred in a ring stream
+ *
+ * For a ring capture, the most recent sample is just before this position.
+*/
+u32_t rp2040_piodma_position(rp2040_piodma_t *s)
+{
+	return s->nwords - rp2040_dma.ch[s->ch[0]].trans_count;
+}
+
+/* rp2040_piodma_stop() - stop a stream
+ *
+ * The channels are disabled first to prevent them from chaining to each other, then aborted.
+*/
+void rp2040_piodma_stop(rp2040_piodma_t *s)
+{
+	u32_t mask = (1u << s->ch[0]) | (1u << s->ch[1]);
+
+	rp2040_dma_w1c.ch[s->ch[0]].al1_ctrl = DMA_CHANNEL_EN;
+	rp2040_dma_w1c.ch[s->ch[1]].al1_ctrl = DMA_CHANNEL_EN;
+
+	rp2040_dma.chan_abort = mask;
+	while ( (rp2040_dma.chan_abort & mask) != 0 )
+	{
+		/* Wait */
+	}
+}
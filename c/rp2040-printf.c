@@ -0,0 +1,343 @@
+/* rp2040-printf.c - compact formatted output
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-printf.h"
+#include "rp2040-sio.h"
+
+#define FMT_LEFT	0x01
+#define FMT_ZERO	0x02
+#define FMT_LONG	0x04		/* 64 bits */
+#define FMT_UPPER	0x08
+
+#define FMT_MAXDIG	20			/* 2^64 - 1 has 20 decimal digits */
+
+/* The output: a sink function or a buffer
+*/
+typedef struct fmt_out_s
+{
+	void (*putc)(char);
+	char *buf;
+	u32_t size;
+	u32_t n;
+} fmt_out_t;
+
+static void fmt_putc(fmt_out_t *o, char c)
+{
+	if ( o->putc != 0 )
+		o->putc(c);
+	else if ( o->n + 1 < o->size )
+		o->buf[o->n] = c;
+	o->n++;
+}
+
+static void fmt_pad(fmt_out_t *o, char c, int n)
+{
+	while ( n-- > 0 )
+		fmt_putc(o, c);
+}
+
+/* fmt_dec() - convert a 64-bit number to decimal
+ *
+ * The number is held as four 16-bit limbs, most significant first. Each pass divides it by 10000
+ * with the SIO divider and splits the remainder into four digits with a reciprocal multiplication.
+ * The digits are stored least significant first. Returns the number of digits.
+*/
+static int fmt_dec(char *str, u32_t hi, u32_t lo)
+{
+	u32_t limb[4] = { hi >> 16, hi & 0xffff, lo >> 16, lo & 0xffff };
+	int first = 0;
+	int n = 0;
+
+	for (;;)
+	{
+		while ( first < 4 && limb[first] == 0 )
+			first++;
+		if ( first >= 4 )
+			break;
+
+		u32_t r = 0;
+		for ( int i = first; i < 4; i++ )
+			limb[i] = rp2040_udiv((r << 16) | limb[i], 10000, &r);
+
+		for ( int i = 0; i < 4; i++ )
+		{
+			u32_t q = (r * 6554) >> 16;
+			str[n++] = (char)('0' + (r - q * 10));
+			r = q;
+		}
+	}
+
+	while ( n > 1 && str[n-1] == '0' )
+		n--;
+	if ( n == 0 )
+		str[n++] = '0';
+	return n;
+}
+
+/* fmt_hex() - convert a 64-bit number to hexadecimal, least significant digit first
+*/
+static int fmt_hex(char *str, u32_t hi, u32_t lo, int flags)
+{
+	const char *digits = (flags & FMT_UPPER) ? "0123456789ABCDEF" : "0123456789abcdef";
+	int n = 0;
+
+	do {
+		str[n++] = digits[lo & 0xf];
+		lo = (lo >> 4) | (hi << 28);
+		hi >>= 4;
+	} while ( (lo | hi) != 0 );
+
+	return n;
+}
+
+/* fmt_field() - print a converted field with its prefix and padding
+ *
+ * The body is in reverse order if rev is set (the digits of a number).
+*/
+static void fmt_field(fmt_out_t *o, const char *pfx, const char *body, int len, int rev, int width, int flags)
+{
+	int plen = 0;
+
+	while ( pfx[plen] != '\0' )
+		plen++;
+
+	int pad = width - len - plen;
+
+	if ( (flags & (FMT_LEFT | FMT_ZERO)) == 0 )
+		fmt_pad(o, ' ', pad);
+	while ( *pfx != '\0' )
+		fmt_putc(o, *pfx++);
+	if ( (flags & (FMT_LEFT | FMT_ZERO)) == FMT_ZERO )
+		fmt_pad(o, '0', pad);
+
+	if ( rev )
+	{
+		while ( len > 0 )
+			fmt_putc(o, body[--len]);
+	}
+	else
+	{
+		for ( int i = 0; i < len; i++ )
+			fmt_putc(o, body[i]);
+	}
+
+	if ( (flags & FMT_LEFT) != 0 )
+		fmt_pad(o, ' ', pad);
+}
+
+/* fmt_format() - the formatting engine
+*/
+static int fmt_format(fmt_out_t *o, const char *fmt, va_list ap)
+{
+	char str[FMT_MAXDIG];
+	char c;
+
+	while ( (c = *fmt++) != '\0' )
+	{
+		if ( c != '%' )
+		{
+			fmt_putc(o, c);
+			continue;
+		}
+
+		int flags = 0;
+		int width = 0;
+
+		for (;;)
+		{
+			c = *fmt++;
+			if ( c == '-' )
+				flags |= FMT_LEFT;
+			else if ( c == '0' )
+				flags |= FMT_ZERO;
+			else
+				break;
+		}
+
+		if ( c == '*' )
+		{
+			width = va_arg(ap, int);
+			if ( width < 0 )
+			{
+				flags |= FMT_LEFT;
+				width = -width;
+			}
+			c = *fmt++;
+		}
+		else
+		{
+			while ( c >= '0' && c <= '9' )
+			{
+				width = width * 10 + (c - '0');
+				c = *fmt++;
+			}
+		}
+
+		if ( c == 'l' )
+		{
+			c = *fmt++;
+			if ( c == 'l' )
+			{
+				flags |= FMT_LONG;
+				c = *fmt++;
+			}
+		}
+
+		u32_t hi = 0, lo = 0;
+		const char *pfx = "";
+
+		switch ( c )
+		{
+		case 'd':
+		case 'i':
+			if ( flags & FMT_LONG )
+			{
+				s64_t v = va_arg(ap, s64_t);
+				u64_t u = (u64_t)v;
+				if ( v < 0 )
+				{
+					pfx = "-";
+					u = 0 - u;
+				}
+				hi = (u32_t)(u >> 32);
+				lo = (u32_t)u;
+			}
+			else
+			{
+				int v = va_arg(ap, int);
+				lo = (u32_t)v;
+				if ( v < 0 )
+				{
+					pfx = "-";
+					lo = 0 - lo;
+				}
+			}
+			fmt_field(o, pfx, str, fmt_dec(str, hi, lo), 1, width, flags);
+			break;
+
+		case 'u':
+		case 'x':
+		case 'X':
+			if ( flags & FMT_LONG )
+			{
+				u64_t v = va_arg(ap, u64_t);
+				hi = (u32_t)(v >> 32);
+				lo = (u32_t)v;
+			}
+			else
+			{
+				lo = (u32_t)va_arg(ap, unsigned);
+			}
+			if ( c == 'u' )
+				fmt_field(o, pfx, str, fmt_dec(str, hi, lo), 1, width, flags);
+			else
+				fmt_field(o, pfx, str, fmt_hex(str, hi, lo, (c == 'X') ? FMT_UPPER : 0), 1, width, flags);
+			break;
+
+		case 'p':
+			lo = (u32_t)va_arg(ap, void *);
+			fmt_field(o, "0x", str, fmt_hex(str, 0, lo, 0), 1, 10, FMT_ZERO);
+			break;
+
+		case 'c':
+			str[0] = (char)va_arg(ap, int);
+			fmt_field(o, pfx, str, 1, 0, width, flags & FMT_LEFT);
+			break;
+
+		case 's':
+			{
+				const char *s = va_arg(ap, const char *);
+				int len = 0;
+
+				if ( s == 0 )
+					s = "(null)";
+				while ( s[len] != '\0' )
+					len++;
+				fmt_field(o, pfx, s, len, 0, width, flags & FMT_LEFT);
+			}
+			break;
+
+		case '%':
+			fmt_putc(o, '%');
+			break;
+
+		case '\0':
+			fmt--;		/* Stop at the end of the format */
+			break;
+
+		default:
+			fmt_putc(o, '%');
+			fmt_putc(o, c);
+			break;
+		}
+	}
+
+	return (int)o->n;
+}
+
+/* rp2040_vprintf() - formatted output to a character sink
+*/
+int rp2040_vprintf(void (*putc)(char), const char *fmt, va_list ap)
+{
+	fmt_out_t o = { putc, 0, 0, 0 };
+
+	return fmt_format(&o, fmt, ap);
+}
+
+/* rp2040_printf() - formatted output to a character sink
+*/
+int rp2040_printf(void (*putc)(char), const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	va_start(ap, fmt);
+	n = rp2040_vprintf(putc, fmt, ap);
+	va_end(ap);
+	return n;
+}
+
+/* rp2040_vsnprintf() - formatted output to a buffer
+ *
+ * At most size-1 characters are stored, followed by a '\0'.
+*/
+int rp2040_vsnprintf(char *buf, u32_t size, const char *fmt, va_list ap)
+{
+	fmt_out_t o = { 0, buf, size, 0 };
+	int n = fmt_format(&o, fmt, ap);
+
+	if ( size > 0 )
+		buf[(o.n < size) ? o.n : (size - 1)] = '\0';
+	return n;
+}
+
+/* rp2040_snprintf() - formatted output to a buffer
+*/
+int rp2040_snprintf(char *buf, u32_t size, const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	va_start(ap, fmt);
+	n = rp2040_vsnprintf(buf, size, fmt, ap);
+	va_end(ap);
+	return n;
+}
@@ -0,0 +1,135 @@
+/* rp2040-softirq.c - deferred work on software-triggered IRQs
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-nvic.h"
+#include "rp2040-softirq.h"
+#include "rp2040-sio.h"
+#include "rp2040-cm0.h"
+
+typedef struct softirq_queue_s
+{
+	rp2040_work_t *head;
+	rp2040_work_t *tail;
+} softirq_queue_t;
+
+static softirq_queue_t softirq_queue[2][RP2040_SOFTIRQ_N];
+
+static void softirq_dispatch(void);
+
+/* softirq_valid() - return true if irq is one of the soft IRQs
+*/
+static inline boolean_t softirq_valid(irqid_t irq)
+{
+	return (u32_t)irq - RP2040_SOFTIRQ_FIRST < RP2040_SOFTIRQ_N;
+}
+
+/* softirq_q() - the calling core's queue for a soft IRQ
+*/
+static inline softirq_queue_t *softirq_q(u32_t irq)
+{
+	return &softirq_queue[rp2040_sio.cpuid & 0x1][irq - RP2040_SOFTIRQ_FIRST];
+}
+
+/* rp2040_softirq_init() - set up a soft IRQ (irq_26 to irq_31) on the calling core
+ *
+ * prio is NVIC_PRIO_0 to NVIC_PRIO_3. Normally a soft IRQ has a lower priority (higher value) than
+ * the interrupts that post work to it.
+ *
+ * Returns 0 if OK, -1 if irq isn't a soft IRQ.
+*/
+int rp2040_softirq_init(irqid_t irq, u32_t prio)
+{
+	if ( !softirq_valid(irq) )
+		return -1;
+
+	softirq_queue_t *q = softirq_q(irq);
+
+	rp2040_nvic_disable(irq);
+	q->head = 0;
+	q->tail = 0;
+	(void)rp2040_irq_set_handler(irq, softirq_dispatch);
+	rp2040_nvic_set_priority(irq, prio);
+	rp2040_nvic_unpend(irq);
+	rp2040_nvic_enable(irq);
+	return 0;
+}
+
+/* rp2040_work_post() - queue a work item on a soft IRQ of the calling core
+ *
+ * Can be called from any interrupt handler or from thread mode.
+ * Returns 1 if the item was queued, 0 if it was already in a queue or irq isn't a soft IRQ.
+*/
+boolean_t rp2040_work_post(irqid_t irq, rp2040_work_t *w)
+{
+	if ( !softirq_valid(irq) )
+		return 0;
+
+	softirq_queue_t *q = softirq_q(irq);
+	boolean_t posted = 0;
+	intstatus_t is = disable();
+
+	if ( !w->queued )
+	{
+		w->queued = 1;
+		w->next = 0;
+		if ( q->tail == 0 )
+			q->head = w;
+		else
+			q->tail->next = w;
+		q->tail = w;
+		posted = 1;
+	}
+
+	rp2040_nvic_pend(irq);
+	restore(is);
+	return posted;
+}
+
+/* softirq_dispatch() - handler for all the soft IRQs
+ *
+ * The IRQ number comes from IPSR. Each item is removed from the queue before its function is called,
+ * so the function can post the item again.
+*/
+RP2040_TIME_CRITICAL static void softirq_dispatch(void)
+{
+	u32_t irq = (cxm_get_ipsr() & 0x3f) - 16;
+	softirq_queue_t *q = softirq_q(irq);
+
+	for (;;)
+	{
+		intstatus_t is = disable();
+		rp2040_work_t *w = q->head;
+
+		if ( w != 0 )
+		{
+			q->head = w->next;
+			if ( q->head == 0 )
+				q->tail = 0;
+			w->queued = 0;
+		}
+		restore(is);
+
+		if ( w == 0 )
+			break;
+
+		w->fn(w);
+	}
+}
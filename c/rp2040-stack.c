@@ -0,0 +1,49 @@
+/* rp2040-stack.c - stack high-water mark report
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-stack.h"
+#include "rp2040-sio.h"
+
+static void stack_putline(void (*putc)(char), const char *name, u32_t size, u32_t used)
+{
+	rp2040_puts(putc, "STACK,");
+	rp2040_puts(putc, name);
+	putc(',');
+	rp2040_putdec(putc, size);
+	putc(',');
+	rp2040_putdec(putc, used);
+	putc('\n');
+}
+
+/* rp2040_stack_report() - print the sizes and high-water marks of all the stacks
+ *
+ * The output is comma-separated, one record per line, all sizes in bytes:
+ *	STACK,<name>,<size>,<max used>
+ * The names are MSP0, PSP0, MSP1 and PSP1. Core 1's main stack is painted when core 1 starts, so
+ * its mark is meaningless before that.
+*/
+void rp2040_stack_report(void (*putc)(char))
+{
+	stack_putline(putc, "MSP0", rp2040_msp_size(0), rp2040_msp_used(0));
+	stack_putline(putc, "PSP0", rp2040_psp_size(0), rp2040_psp_used(0));
+	stack_putline(putc, "MSP1", rp2040_msp_size(1), rp2040_msp_used(1));
+	stack_putline(putc, "PSP1", rp2040_psp_size(1), rp2040_psp_used(1));
+}
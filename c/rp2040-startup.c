@@ -25,64 +25,166 @@
 #include "rp2040-timer.h"
 #include "rp2040-watchdog.h"
 #include "rp2040-cm0.h"
+#include "rp2040-nvic.h"
+#include "rp2040-dma.h"
+#include "rp2040-startup.h"
+#include "rp2040-stack.h"
+#include "rp2040-crash.h"
 
 #define SPSEL		0x02
 
 extern unsigned start_data, end_data, start_bss, end_bss, idata;
-extern unsigned rp2040_pstacktop;
-extern unsigned rp2040_stacktop;
+extern unsigned start_time_critical, end_time_critical, itime_critical;
 extern int main(void);
 
-/* init_vars() - initialise variables
+/* Boot profile. The times of the phases before the .bss is cleared are held in local variables
+ * until it is safe to store them.
+*/
+u32_t rp2040_boot_time[RP2040_BOOT_NPHASE];
+
+/* The reason for the last reset and the crash record, if any. See rp2040-crash.h
+*/
+rp2040_crash_t rp2040_reset_info;
+
+static inline u32_t boot_elapsed(u32_t t0)
+{
+	return rp2040_timer.time_lraw - t0;
+}
+
+/* Sources for the DMA fills. Must not be in the .bss.
+*/
+static const u32_t boot_zero = 0;
+#if RP2040_STACK_PAINT
+static const u32_t boot_paint = RP2040_STACK_PATTERN;
+#endif
+
+/* boot_dma_fill() - start a DMA channel filling memory with a 32-bit pattern
  *
- * Initialises all variables from the flash image (.data) or to zero (.bss)
+ * The fills run in the background; boot_dma_wait() waits for them to finish and puts the DMA
+ * back into reset, so that the application finds it in the same state as after a cold boot.
+ * Each channel chains to itself, i.e. not at all.
 */
-static void init_vars(void)
+static void boot_dma_fill(int ch, void *d, void *e, const u32_t *pattern)
 {
-#if 0	/* Using direct load-to-RAM, .data variables are initialised by the loader */
-	unsigned *s = &idata;
-	unsigned *d = &start_data;
+	rp2040_release(RESETS_dma);
+	rp2040_dma.ch[ch].read_addr = (u32_t)pattern;
+	rp2040_dma.ch[ch].write_addr = (u32_t)d;
+	rp2040_dma.ch[ch].trans_count = (u32_t)((u32_t *)e - (u32_t *)d);
+	rp2040_dma.ch[ch].ctrl_trig = DMA_TREQ_VAL(TREQ_PERM) | DMA_CHAIN_VAL(ch) | DMA_RING_NONE |
+								DMA_INCR_WRITE | DMA_SIZE_WORD | DMA_CHANNEL_EN;
+}
 
-	while ( d < &end_data )
+static void boot_dma_wait(void)
+{
+	while ( (rp2040_dma.ch[0].ctrl_trig & DMA_BUSY) != 0 || (rp2040_dma.ch[1].ctrl_trig & DMA_BUSY) != 0 )
 	{
-		*d++ = *s++;
+		/* Wait */
 	}
-#endif
+	rp2040_resets_w1s.reset = RESETS_dma;
+}
 
-	unsigned *b = &start_bss;
-	while ( b < &end_bss )
+/* init_section() - copy a section from its load address to its run address
+ *
+ * With direct load-to-RAM, the loader puts the sections where they run. The linker scripts set the
+ * load address equal to the run address in that case, so there's nothing to do.
+*/
+static void init_section(unsigned *d, unsigned *e, const unsigned *s)
+{
+	if ( d == s )
+		return;
+
+	while ( d < e )
 	{
-		*b++ = 0x00;
+		*d++ = *s++;
 	}
 }
 
+/* init_vars() - initialise variables
+ *
+ * Initialises all variables from the flash image (.data) or to zero (.bss), and copies
+ * the time-critical code to RAM.
+ *
+ * The .bss is cleared by DMA in the background while the PLLs start; see rp2040_kickstart().
+ * The process stacks of both cores are painted at the same time by a second channel. They are
+ * adjacent (see the linker scripts).
+*/
+static void init_vars(void)
+{
+	init_section(&start_time_critical, &end_time_critical, &itime_critical);
+	init_section(&start_data, &end_data, &idata);
+
+	boot_dma_fill(0, &start_bss, &end_bss, &boot_zero);
+#if RP2040_STACK_PAINT
+	boot_dma_fill(1, rp2040_pstackbase1, rp2040_pstacktop, &boot_paint);
+#endif
+}
+
 /* rp2040_kickstart() - entry point from the reset vector
  *
  * SP has been initialised, but that's all
 */
 void rp2040_kickstart(void)
 {
-	/* Set up the vector table
-    */
-#if 0
-    cxm_scr.vtor = (u32_t)&cxm_vectors[0];
-#endif
-
-	/* Initialise the the XOSC clock, the PLL (133MHz) and the USB PLL (48MHz)
-	 * The USB PLL is also needed for ADC
+	/* Initialise the the XOSC clock
+	 * If the XOSC fails to start, carry on with the clock that was there before rather than
+	 * hang here. The timer runs at 1 MHz only if the XOSC is running.
 	*/
-	rp2040_clock_init();
-	rp2040_pll_init();
-	rp2040_usbpll_init();
+	boolean_t xosc_ok = (rp2040_clock_init() == 0);
 
-	/* Disable the watchdog
+	/* Disable the watchdog. The application can start it again with rp2040_watchdog_start().
 	*/
 	rp2040_watchdog_disable();
 
-	/* Initialise variables
+	/* Initialise the tick generator and release the timer from reset, so that the rest of the
+	 * boot can be timed.
+	*/
+	rp2040_tick_init();
+	rp2040_release(RESETS_timer);
+	u32_t t0 = rp2040_timer.time_lraw;
+	u32_t t_pll = 0, t_usbpll = 0;
+
+	/* Initialise variables. The .bss is cleared by DMA while the PLLs start.
 	*/
 	init_vars();
 
+	/* Start the PLL (RP2040_CLK_SYS_HZ) and, if configured, the USB PLL (48MHz).
+	 * The USB PLL is needed for USB and ADC. Programs that use them without RP2040_USBPLL
+	 * can call rp2040_usbpll_init() themselves.
+	 * If a PLL fails to start, carry on with the clock that was there before.
+	*/
+	if ( xosc_ok )
+	{
+		(void)rp2040_pll_init();
+		t_pll = boot_elapsed(t0);
+#if RP2040_USBPLL
+		(void)rp2040_usbpll_init();
+#endif
+		t_usbpll = boot_elapsed(t0);
+	}
+
+	boot_dma_wait();
+	rp2040_boot_time[RP2040_BOOT_BSS] = boot_elapsed(t0);
+	rp2040_boot_time[RP2040_BOOT_PLL] = t_pll;
+	rp2040_boot_time[RP2040_BOOT_USBPLL] = t_usbpll;
+
+	/* Read back the crash record from the watchdog scratch registers.
+	*/
+	rp2040_crash_fetch(&rp2040_reset_info);
+
+	/* Check the clock frequencies. This corrects rp2040_clk_sys_freq if the PLL isn't as expected,
+	 * so it must be done after the variables have been initialised.
+	*/
+#if RP2040_CLK_VERIFY
+	rp2040_clk_failed = rp2040_clk_verify();
+#endif
+	rp2040_boot_time[RP2040_BOOT_VERIFY] = boot_elapsed(t0);
+
+	/* Set up the vector table in RAM. This must be done after the .bss is cleared.
+	*/
+#if RP2040_RAM_VECTORS
+	rp2040_ramvectors_init();
+#endif
+
 	/* Initialise the exception priorities
 	*/
 	cxm_scr.shpr[1] = 0x0;			/* SVC and [reserved x 3] all at highest priority */
@@ -93,19 +195,20 @@ void rp2040_kickstart(void)
 	*/
 	rp2040_release(RESETS_io_bank0);
 
-	/* Initialise the tick generator and release the timer from reset
-	*/
-	rp2040_tick_init();
-	rp2040_release(RESETS_timer);
-	
 	/* Initialise the interrupt controller
 	*/
-#if 0
 	rp2040_nvic_init();
+
+	rp2040_boot_time[RP2040_BOOT_MAIN] = boot_elapsed(t0);
+
+	/* Paint the unused part of the main stack. Interrupts aren't enabled yet.
+	*/
+#if RP2040_STACK_PAINT
+	rp2040_stack_paint_to_sp(rp2040_stackbase);
 #endif
 
 	/* Switch to the process stack pointer and simultaneously jump to main()
 	*/
-	rp2040_switch_to_psp((u32_t)&rp2040_pstacktop, (u32_t)&rp2040_stacktop,
+	rp2040_switch_to_psp((u32_t)rp2040_pstacktop, (u32_t)rp2040_stacktop,
 						(u32_t)(cxm_get_control() | SPSEL), (u32_t)&main);
 }
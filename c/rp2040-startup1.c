@@ -20,11 +20,11 @@
 #include "rp2040.h"
 #include "rp2040-types.h"
 #include "rp2040-cm0.h"
+#include "rp2040-nvic.h"
+#include "rp2040-stack.h"
 
 #define SPSEL		0x02
 
-extern unsigned rp2040_pstacktop1;
-extern unsigned rp2040_stacktop1;
 extern int main1(void);
 
 /* rp2040_kickstart1() - entry point from the boot code
@@ -34,10 +34,10 @@ extern int main1(void);
 */
 void rp2040_kickstart1(void)
 {
-	/* Set up the vector table
-    */
-#if 0
-    cxm_scr.vtor = (u32_t)&cxm_vectors[0];
+	/* Set up the vector table in RAM
+	*/
+#if RP2040_RAM_VECTORS
+	rp2040_ramvectors_init();
 #endif
 
 	/* Initialise the exception priorities
@@ -47,12 +47,16 @@ void rp2040_kickstart1(void)
 
 	/* Initialise the interrupt controller
 	*/
-#if 0
 	rp2040_nvic_init();
+
+	/* Paint the unused part of the main stack. The process stack was painted by core 0 at boot.
+	*/
+#if RP2040_STACK_PAINT
+	rp2040_stack_paint_to_sp(rp2040_stackbase1);
 #endif
 
 	/* Switch to the process stack pointer and simultaneously jump to main()
 	*/
-	rp2040_switch_to_psp((u32_t)&rp2040_pstacktop1, (u32_t)&rp2040_stacktop1,
+	rp2040_switch_to_psp((u32_t)rp2040_pstacktop1, (u32_t)rp2040_stacktop1,
 						(u32_t)(cxm_get_control() | SPSEL), (u32_t)&main1);
 }
@@ -21,6 +21,9 @@
 #include "rp2040-types.h"
 #include "rp2040-uart.h"
 #include "rp2040-resets.h"
+#include "rp2040-delay.h"
+#include "rp2040-clocks.h"
+#include "rp2040-sio.h"
 
 /* rp2040_uart_getc() - wait until there's a character available then return it.
 */
@@ -33,6 +36,18 @@ int rp2040_uart_getc(rp2040_uart_t *uart)
 	return (int)(uart->dr & UART_DATA);	/* Discard the error status bits */
 }
 
+/* rp2040_uart_getc_timeout() - wait until there's a character available then return it, with a timeout
+ *
+ * Returns -1 if no character arrives within timeout_us microseconds.
+*/
+int rp2040_uart_getc_timeout(rp2040_uart_t *uart, u32_t timeout_us)
+{
+	if ( rp2040_wait_reg(&uart->fr, UART_RXFE, 0, timeout_us) != 0 )
+		return -1;
+
+	return (int)(uart->dr & UART_DATA);	/* Discard the error status bits */
+}
+
 /* rp2040_uart_putc() - wait until there's room in the tx buffer, then put a character into it.
 */
 void rp2040_uart_putc(rp2040_uart_t *uart, int c)
@@ -48,18 +63,24 @@ void rp2040_uart_putc(rp2040_uart_t *uart, int c)
  *
  * Returns nonzero if the parameters aren't supported.
  *
- * Assumes peripheral clock of 12 MHz
+ * The baud rate divisors are for the current clk_peri frequency (rp2040_clk_peri_hz()).
  *
  * fmt has 3 characters:  nps (any extra characters are ignored)
  *	n = no of bits (5..8)
  *	p = parity: N (none), E (even), O (odd), M (mark), S (space)
  *	s = no of stop bits (1..2)
  *
- * To calculate the baud-rate dividers we need a __aeabi_uidiv functions from libgcc.a
- * There doesn't appear to be a usable libgcc.a with the devuan compiler.
- * Instead of calculating ibrd and fbrd we use a table lookup
+ * With a 12 MHz peripheral clock the dividers for the standard baud rates come from a table.
+ * Otherwise they are calculated with the SIO divider (there's no libgcc for __aeabi_uidiv).
+ *
+ * With RP2040_CLK_PERI_SYS, clk_peri follows clk_sys, so the UART registers a clock notifier that waits
+ * for the transmitter to finish before a frequency change and recalculates the dividers afterwards.
 */
-#define NBAUD	14	/* Set to 0 to use the calculation method */
+#define NBAUD	14	/* Set to 0 to always use the calculation method */
+
+#ifndef RP2040_UART_DRAIN_US
+#define RP2040_UART_DRAIN_US	100000		/* Max. time to wait for the tx FIFO to empty */
+#endif
 
 #if NBAUD != 0
 typedef struct
@@ -104,9 +125,81 @@ static const br_lookup_t br_table[NBAUD] =
 };
 #endif
 
+/* uart_divisors() - calculate the baud-rate dividers for the current clk_peri
+ *
+ * See rp2040 refman 4.2.7.1
+ * Differences: we treat 65535 as in-range. There's nothing in the refman to suggest otherwise.
+ * Returns 0 if OK, -1 if the divisors are out of range.
+*/
+static int uart_divisors(u32_t baud, u32_t *ibrd, u32_t *fbrd)
+{
+	u32_t clk = rp2040_clk_peri_hz();
+
+#if NBAUD != 0
+	if ( clk == 12000000 )
+	{
+		for ( int bri = 0; bri < NBAUD; bri++ )
+		{
+			if ( br_table[bri].baud == baud )
+			{
+				*ibrd = br_table[bri].ibrd;
+				*fbrd = br_table[bri].fbrd;
+				return 0;
+			}
+		}
+	}
+#endif
+
+	if ( baud == 0 )
+		return -1;
+
+	u32_t bdiv = rp2040_udiv(8 * clk, baud, 0);
+	*ibrd = bdiv >> 7;
+	if ( *ibrd == 0 || *ibrd > 65535 )
+		return -1;
+
+	*fbrd = ((bdiv & 0x7f) + 1) / 2;
+	return 0;
+}
+
+#if RP2040_CLK_PERI_SYS
+static u32_t uart_baud[2];		/* Baud rate of each initialised UART */
+static rp2040_clk_notifier_t uart_clk_notifier;
+
+/* uart_clk_notify() - clock change notifier
+ *
+ * Before the change: wait until the transmitter is idle, so that no character is sent with the wrong timing.
+ * After the change: set the new dividers. They take effect on the write to LCR_H.
+ * A character that is being received during the change is likely to be corrupted.
+*/
+static void uart_clk_notify(rp2040_clk_notifier_t *n, int phase, u32_t old_hz, u32_t new_hz)
+{
+	for ( int i = 0; i < 2; i++ )
+	{
+		rp2040_uart_t *uart = (i == 0) ? &rp2040_uart0 : &rp2040_uart1;
+		u32_t ibrd, fbrd;
+
+		if ( uart_baud[i] == 0 )
+			continue;
+
+		if ( phase == RP2040_CLK_PRE )
+		{
+			(void)rp2040_wait_reg(&uart->fr, UART_BUSY | UART_TXFE, UART_TXFE, RP2040_UART_DRAIN_US);
+		}
+		else if ( uart_divisors(uart_baud[i], &ibrd, &fbrd) == 0 )
+		{
+			uart->ibrd = ibrd;
+			uart->fbrd = fbrd;
+			uart->lcr_h = uart->lcr_h;
+		}
+	}
+}
+#endif
+
 int rp2040_uart_init(rp2040_uart_t *uart, unsigned baud, const char *fmt)
 {
 	u32_t rst;
+	u32_t ibrd, fbrd;
 
 	if ( uart == &rp2040_uart0 )
 	{
@@ -118,35 +211,12 @@ int rp2040_uart_init(rp2040_uart_t *uart, unsigned baud, const char *fmt)
 	}
 	else
 		return 1;
-	
-#if NBAUD == 0
-	/* Calculate the integer and fractional dividers. See rp2040 refman 4.2.7.1
-	 * Differences: we treat 65535 as in-range. There's nothing in the refman to suggest otherwise.
-	 * If the calculated divisors are out of range, we return an error and don't configure the UART
-	*/
-	u32_t bdiv = (8 * 12000000)/baud;
-	u32_t ibrd = bdiv >> 7;
-	if ( ibrd == 0 || ibrd > 65535 )
-	{
-		return 2;
-	}
-
-	u32_t fbrd = ((bdiv & 0x7f) + 1) / 2;
-#else
-	int bri;
-	for ( bri = 0; bri < NBAUD; bri++ )
-	{
-		if ( br_table[bri].baud == baud )
-			break;
-	}
 
-	if ( bri >= NBAUD )
+	/* If the calculated divisors are out of range, we return an error and don't configure the UART
+	*/
+	if ( uart_divisors(baud, &ibrd, &fbrd) != 0 )
 		return 2;
 
-	u32_t ibrd = br_table[bri].ibrd;
-	u32_t fbrd = br_table[bri].fbrd;
-#endif
-
 	if ( fmt[0] < '5' || fmt[0] > '8' )
 	{
 		return 3;
@@ -217,5 +287,10 @@ int rp2040_uart_init(rp2040_uart_t *uart, unsigned baud, const char *fmt)
 	*/
 	uart->cr = UART_UARTEN | UART_RXE | UART_TXE;
 
+#if RP2040_CLK_PERI_SYS
+	uart_baud[(uart == &rp2040_uart0) ? 0 : 1] = baud;
+	rp2040_clk_notifier_register(&uart_clk_notifier, uart_clk_notify);
+#endif
+
 	return 0;
 }
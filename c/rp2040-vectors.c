@@ -19,6 +19,9 @@
 */
 #include "rp2040.h"
 #include "rp2040-types.h"
+#include "rp2040-nvic.h"
+#include "rp2040-sio.h"
+#include "rp2040-cm0.h"
 
 extern void rp2040_stacktop(void);	/* This is a blatant lie! rp2040_stacktop is a symbol set in the linker script */
 extern void rp2040_kickstart(void);
@@ -26,8 +29,6 @@ extern void rp2040_kickstart(void);
 extern void app_unknowntrap(void);
 extern void app_unknown_irq(void);
 
-typedef void (*rp2040_vector_t)(void);
-
 /* Cortex-M0 doesn't provide memfault, busfault and usagefault traps
 */
 #ifndef APP_NMI
@@ -159,7 +160,7 @@ typedef void (*rp2040_vector_t)(void);
  *	- 16 are the armvx-m exception/reset vectors (including reset SP)
  *	- 32 are the NVIC vectors. NVC interrupts 26..31 have no periperal connected but can be triggered by software.
 */
-const rp2040_vector_t rp2040_hwvectors[16+32] =
+const rp2040_vector_t rp2040_hwvectors[RP2040_NVECTORS] =
 {	&rp2040_stacktop,
 	&rp2040_kickstart,
 	&APP_NMI,
@@ -210,6 +211,50 @@ const rp2040_vector_t rp2040_hwvectors[16+32] =
 	&APP_IRQ_31,			/* 31 */
 };
 
+#if RP2040_RAM_VECTORS
+/* RAM vector tables, one per core.
+ * VTOR needs 256-byte alignment on the M0+, so each table is padded to 64 entries.
+*/
+static rp2040_vector_t rp2040_ramvectors[2][64] __attribute__((aligned(256)));
+
+/* rp2040_ramvectors_init() - copy the vector table to the calling core's RAM table and switch to it
+ *
+ * Must be called after the .bss has been cleared.
+*/
+void rp2040_ramvectors_init(void)
+{
+	rp2040_vector_t *v = rp2040_ramvectors[rp2040_sio.cpuid & 0x1];
+
+	for ( int i = 0; i < RP2040_NVECTORS; i++ )
+	{
+		v[i] = rp2040_hwvectors[i];
+	}
+
+	__asm__ volatile("dsb");
+	cxm_scr.vtor = (u32_t)v;
+	__asm__ volatile("dsb");
+}
+
+/* rp2040_exc_set_handler() - set the handler for an exception (0..47) on the calling core
+ *
+ * Exception numbers 16 to 47 are IRQs 0 to 31; see also rp2040_irq_set_handler().
+ * Returns the previous handler, or 0 if exc is out of range.
+*/
+rp2040_vector_t rp2040_exc_set_handler(int exc, rp2040_vector_t fn)
+{
+	rp2040_vector_t *v = rp2040_ramvectors[rp2040_sio.cpuid & 0x1];
+	rp2040_vector_t old;
+
+	if ( exc < 2 || exc >= RP2040_NVECTORS )
+		return 0;
+
+	old = v[exc];
+	v[exc] = fn;
+	__asm__ volatile("dsb");	/* Make sure the new vector is in RAM before the next exception */
+	return old;
+}
+#endif
+
 #if 0
 void app_unknowntrap(void)
 {
@@ -0,0 +1,105 @@
+/* rp2040-watchdog.c - watchdog service
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-watchdog.h"
+#include "rp2040-timer.h"
+#include "rp2040-sio.h"
+
+rp2040_wdtask_t rp2040_wdtask[RP2040_WATCHDOG_MAXTASK];
+
+static int wd_ntask;
+static int wd_missed = -1;
+static u32_t wd_load;
+
+/* rp2040_watchdog_register() - register a task with the watchdog service
+ *
+ * period is the longest time between check-ins, in microseconds. The task counts as having checked
+ * in when it is registered.
+ * Returns the task's number for rp2040_watchdog_checkin(), or -1 if there's no room.
+*/
+int rp2040_watchdog_register(u32_t period)
+{
+	int t = -1;
+	intstatus_t is = rp2040_spin_lock(RP2040_SPINLOCK_WATCHDOG);
+
+	if ( wd_ntask < RP2040_WATCHDOG_MAXTASK )
+	{
+		t = wd_ntask;
+		rp2040_wdtask[t].period = period;
+		rp2040_wdtask[t].checkin = rp2040_timer.time_lraw;
+		__asm__ volatile("dmb" : : : "memory");		/* The service can be on the other core */
+		wd_ntask = t + 1;
+	}
+
+	rp2040_spin_unlock(RP2040_SPINLOCK_WATCHDOG, is);
+	return t;
+}
+
+/* rp2040_watchdog_start() - start the hardware watchdog
+ *
+ * timeout is in microseconds, at most RP2040_WATCHDOG_MAX_US. If pause_dbg is true the watchdog
+ * doesn't count while a core is halted by the debugger.
+*/
+void rp2040_watchdog_start(u32_t timeout, boolean_t pause_dbg)
+{
+	if ( timeout > RP2040_WATCHDOG_MAX_US )
+		timeout = RP2040_WATCHDOG_MAX_US;
+	wd_load = timeout * 2;
+
+	rp2040_watchdog_disable();
+	rp2040_psm.wdsel = RP2040_WATCHDOG_WDSEL;
+	rp2040_watchdog.load = wd_load;
+	rp2040_watchdog.ctrl = WATCHDOG_ENABLED |
+				(pause_dbg ? (WATCHDOG_PAUSE_DBG0 | WATCHDOG_PAUSE_DBG1 | WATCHDOG_PAUSE_JTAG) : 0);
+}
+
+/* rp2040_watchdog_service() - check the tasks and feed the watchdog
+ *
+ * Returns -1 if all the tasks are alive, otherwise the number of the first task that missed
+ * its deadline.
+*/
+int rp2040_watchdog_service(void)
+{
+	if ( wd_missed < 0 )
+	{
+		u32_t now = rp2040_timer.time_lraw;
+		int n = wd_ntask;
+
+		for ( int t = 0; t < n; t++ )
+		{
+			u32_t late = now - rp2040_wdtask[t].checkin;
+
+			/* A check-in on the other core after reading the time looks like a very late one.
+			*/
+			if ( late > rp2040_wdtask[t].period && late < 0x80000000 )
+			{
+				wd_missed = t;
+				rp2040_watchdog.scratch[1] = late;
+				rp2040_watchdog.scratch[0] = RP2040_WATCHDOG_MAGIC | (u32_t)t;
+				return t;
+			}
+		}
+
+		rp2040_watchdog.load = wd_load;
+	}
+
+	return wd_missed;
+}
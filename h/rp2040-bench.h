@@ -0,0 +1,77 @@
+/* rp2040-bench.h - cycle-counting benchmark harness
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RP2040_BENCH_H
+#define RP2040_BENCH_H	1
+
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-cm0.h"
+
+/* Benchmarks
+ *
+ * A benchmark is a function that is called n_warmup times without measurement (to settle caches, FIFOs
+ * etc.), then n_rep times with measurement. Before each call the optional setup function is called
+ * without measurement, e.g. to wait until a FIFO is empty. The result is the minimum, median and
+ * maximum number of CPU cycles per call, with the cost of an empty call subtracted.
+ *
+ * Each call is timed with SysTick. For calls that take longer than SysTick's range (2^24 cycles,
+ * 126 ms at 133 MHz) the time comes from the microsecond timer instead, so it's only accurate to
+ * one microsecond.
+ *
+ * Interrupts are disabled during each measured call unless RP2040_BENCH_IRQS is set in flags.
+ *
+ * rp2040_bench_report() prints one comma-separated line per benchmark:
+ *	BENCH,<name>,<n_rep>,<min>,<median>,<max>
+*/
+#ifndef RP2040_BENCH_MAXREP
+#define RP2040_BENCH_MAXREP		64
+#endif
+
+#define RP2040_BENCH_IRQS		0x01	/* Leave interrupts enabled during the measurement */
+
+typedef void (*rp2040_benchfunc_t)(void *arg);
+
+typedef struct rp2040_bench_s rp2040_bench_t;
+typedef struct rp2040_benchresult_s rp2040_benchresult_t;
+
+struct rp2040_bench_s
+{
+	const char *name;
+	rp2040_benchfunc_t fn;			/* Function to measure */
+	rp2040_benchfunc_t setup;		/* Called before each call of fn(), not measured. Can be 0. */
+	void *arg;						/* Parameter for fn() and setup() */
+	u16_t n_warmup;					/* No. of unmeasured calls */
+	u16_t n_rep;					/* No. of measured calls (1..RP2040_BENCH_MAXREP) */
+	u32_t flags;
+};
+
+struct rp2040_benchresult_s
+{
+	u32_t n;						/* No. of measured calls */
+	u32_t min;						/* Cycles per call */
+	u32_t median;
+	u32_t max;
+};
+
+extern void rp2040_bench_init(void);
+extern void rp2040_bench_run(const rp2040_bench_t *b, rp2040_benchresult_t *r);
+extern void rp2040_bench_report(const rp2040_bench_t *b, const rp2040_benchresult_t *r, void (*putc)(char));
+
+#endif
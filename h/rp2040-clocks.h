@@ -105,6 +105,39 @@ struct rp2040_clocks_s
 #define CLKSRC_ADC_GPIN0	0x80
 #define CLKSRC_ADC_GPIN1	0xa0
 
+#define CLKSRC_AUX_MASK		0xe0	/* The aux source field of usb, adc, peri etc. */
+
+/* Frequency counter (FC0)
+*/
+#define FC0_SRC_NULL		0x00
+#define FC0_SRC_PLL_SYS		0x01	/* pll_sys_clksrc_primary */
+#define FC0_SRC_PLL_USB		0x02	/* pll_usb_clksrc_primary */
+#define FC0_SRC_ROSC		0x03
+#define FC0_SRC_ROSC_PH		0x04
+#define FC0_SRC_XOSC		0x05
+#define FC0_SRC_GPIN0		0x06
+#define FC0_SRC_GPIN1		0x07
+#define FC0_SRC_CLK_REF		0x08
+#define FC0_SRC_CLK_SYS		0x09
+#define FC0_SRC_CLK_PERI	0x0a
+#define FC0_SRC_CLK_USB		0x0b
+#define FC0_SRC_CLK_ADC		0x0c
+#define FC0_SRC_CLK_RTC		0x0d
+
+#define FC0_PASS			0x00000001
+#define FC0_DONE			0x00000010
+#define FC0_RUNNING			0x00000100
+#define FC0_WAITING			0x00001000
+#define FC0_FAIL			0x00010000
+#define FC0_SLOW			0x00100000
+#define FC0_FAST			0x01000000
+#define FC0_DIED			0x10000000
+
+#define FC0_RESULT_KHZ		0x3fffffe0
+#define FC0_RESULT_FRAC		0x0000001f
+
+#define CLK_REF_SELECTED_XOSC	0x04	/* ref.selected is one-hot */
+
 
 /* Xosc
 */
@@ -174,8 +207,120 @@ struct rp2040_pll_s
 #define PLL_POSTDIV1		0x00070000	/* PRIM */
 #define PLL_POSTDIV2		0x00007000	/* PRIM */
 
-extern void rp2040_clock_init(void);
-extern void rp2040_pll_init(void);
-extern void rp2040_usbpll_init(void);
+/* Clock frequencies after rp2040_clock_init() and rp2040_pll_init()
+ *
+ * RP2040_CLK_SYS_HZ can be set on the compiler command line (e.g. -DRP2040_CLK_SYS_HZ=200000000); the
+ * PLL settings are calculated from it at compile time (see rp2040-pllcalc.h). A frequency that the
+ * PLL can't generate exactly is a compile-time error. Everything in the program, including the library
+ * modules, must be compiled with the same value.
+ *
+ * clk_peri (UART, SPI) comes from the XOSC unless RP2040_CLK_PERI_SYS is set, in which case it's
+ * the same as clk_sys. The UART calculates its baud rate divisors from RP2040_CLK_PERI_HZ.
+ * clk_usb and clk_adc come from the USB PLL at 48 MHz.
+*/
+#define RP2040_XOSC_HZ		12000000
+
+#ifndef RP2040_CLK_SYS_HZ
+#define RP2040_CLK_SYS_HZ	133000000
+#endif
+
+#ifndef RP2040_CLK_PERI_SYS
+#define RP2040_CLK_PERI_SYS	0
+#endif
+
+#if RP2040_CLK_PERI_SYS
+#define RP2040_CLK_PERI_HZ	RP2040_CLK_SYS_HZ
+#else
+#define RP2040_CLK_PERI_HZ	RP2040_XOSC_HZ
+#endif
+
+#define RP2040_CLK_USB_HZ	48000000
+
+#include "rp2040-pllcalc.h"
+
+#define RP2040_PLL_SYS			RP2040_PLL_SOLVE(RP2040_XOSC_HZ, RP2040_CLK_SYS_HZ)
+#if RP2040_PLL_SYS == 0
+#error "RP2040_CLK_SYS_HZ can't be generated by the system PLL"
+#endif
+#define RP2040_PLL_SYS_REFDIV	RP2040_PLL_REFDIV_OF(RP2040_PLL_SYS)
+#define RP2040_PLL_SYS_FBDIV	RP2040_PLL_FBDIV_OF(RP2040_XOSC_HZ, RP2040_CLK_SYS_HZ, RP2040_PLL_SYS)
+#define RP2040_PLL_SYS_POSTDIV1	RP2040_PLL_POSTDIV1_OF(RP2040_PLL_SYS)
+#define RP2040_PLL_SYS_POSTDIV2	RP2040_PLL_POSTDIV2_OF(RP2040_PLL_SYS)
+
+#define RP2040_PLL_USB			RP2040_PLL_SOLVE(RP2040_XOSC_HZ, RP2040_CLK_USB_HZ)
+#define RP2040_PLL_USB_REFDIV	RP2040_PLL_REFDIV_OF(RP2040_PLL_USB)
+#define RP2040_PLL_USB_FBDIV	RP2040_PLL_FBDIV_OF(RP2040_XOSC_HZ, RP2040_CLK_USB_HZ, RP2040_PLL_USB)
+#define RP2040_PLL_USB_POSTDIV1	RP2040_PLL_POSTDIV1_OF(RP2040_PLL_USB)
+#define RP2040_PLL_USB_POSTDIV2	RP2040_PLL_POSTDIV2_OF(RP2040_PLL_USB)
+
+/* Run-time frequency changes
+ *
+ * rp2040_clk_sys_set() changes clk_sys at run time. Drivers that depend on clk_sys register a notifier,
+ * which is called with RP2040_CLK_PRE before the change and with RP2040_CLK_POST afterwards.
+ * The notifiers are caller-allocated (typically static) and can't be removed.
+*/
+typedef struct rp2040_clk_notifier_s rp2040_clk_notifier_t;
+typedef void (*rp2040_clk_notifyfunc_t)(rp2040_clk_notifier_t *n, int phase, u32_t old_hz, u32_t new_hz);
+
+struct rp2040_clk_notifier_s
+{
+	rp2040_clk_notifier_t *next;		/* List link; private */
+	rp2040_clk_notifyfunc_t fn;
+};
+
+#define RP2040_CLK_PRE		0
+#define RP2040_CLK_POST		1
+
+extern u32_t rp2040_clk_sys_freq;
+
+/* Clock verification
+ *
+ * rp2040_fc0_measure_khz() measures a clock (FC0_SRC_xxx) with the frequency counter, against clk_ref.
+ * The measurement takes 2^RP2040_FC0_INTERVAL microseconds (default: about 64 us) and is accurate to
+ * about 0.1% for clocks above 20 MHz. It returns 0 if the clock isn't running, if clk_ref isn't running from the XOSC or if
+ * the counter doesn't finish in time.
+ *
+ * rp2040_clk_verify() measures clk_sys, clk_peri and (if they are enabled from the USB PLL) clk_usb and
+ * clk_adc, and returns a bit for each one that is missing or more than 1/64 away from its expected
+ * frequency. If clk_sys is wrong, rp2040_clk_sys_freq is set to the measured value so that the baud
+ * rate and clock divider calculations use the real frequency. rp2040_kickstart() calls it and stores
+ * the result in rp2040_clk_failed unless RP2040_CLK_VERIFY is 0.
+*/
+#ifndef RP2040_CLK_VERIFY
+#define RP2040_CLK_VERIFY	1
+#endif
+
+#define RP2040_CLKCHK_SYS	0x01
+#define RP2040_CLKCHK_PERI	0x02
+#define RP2040_CLKCHK_USB	0x04
+#define RP2040_CLKCHK_ADC	0x08
+
+extern u32_t rp2040_clk_failed;
+
+/* rp2040_clk_sys_hz() - the frequency of clk_sys (and therefore the PIO, DMA, processors etc.)
+*/
+static inline u32_t rp2040_clk_sys_hz(void)
+{
+	return rp2040_clk_sys_freq;
+}
+
+/* rp2040_clk_peri_hz() - the frequency of clk_peri (UART, SPI)
+*/
+static inline u32_t rp2040_clk_peri_hz(void)
+{
+#if RP2040_CLK_PERI_SYS
+	return rp2040_clk_sys_freq;
+#else
+	return RP2040_CLK_PERI_HZ;
+#endif
+}
+
+extern int rp2040_clock_init(void);
+extern int rp2040_pll_init(void);
+extern int rp2040_usbpll_init(void);
+extern int rp2040_clk_sys_set(u32_t hz);
+extern void rp2040_clk_notifier_register(rp2040_clk_notifier_t *n, rp2040_clk_notifyfunc_t fn);
+extern u32_t rp2040_fc0_measure_khz(u32_t src);
+extern u32_t rp2040_clk_verify(void);
 
 #endif
@@ -60,6 +60,36 @@ struct cxm_systick_s
 
 #define SYST_MASK			0x00ffffff		/* Max value mask */
 
+/* cxm_systick_start() - start SysTick as a free-running 24-bit down-counter at the CPU clock
+ *
+ * The SysTick exception is not enabled, so this can't be used together with a SysTick tick interrupt.
+ * SysTick is part of each core; this function starts the calling core's counter.
+*/
+static inline void cxm_systick_start(void)
+{
+	cxm_systick.stcsr = 0;
+	cxm_systick.strvr = SYST_MASK;
+	cxm_systick.stcvr = 0;			/* Any write clears the counter; it reloads on the next cycle */
+	cxm_systick.stcsr = SYST_CLKSRC | SYST_ENABLE;
+}
+
+/* cxm_systick_read() - read the current SysTick value
+*/
+static inline u32_t cxm_systick_read(void)
+{
+	return cxm_systick.stcvr;
+}
+
+/* cxm_systick_elapsed() - the number of CPU cycles between two values returned by cxm_systick_read()
+ *
+ * SysTick counts down and wraps at 24 bits, so the result is only correct if the interval is less than
+ * 2^24 cycles (126 ms at 133 MHz).
+*/
+static inline u32_t cxm_systick_elapsed(u32_t start, u32_t end)
+{
+	return (start - end) & SYST_MASK;
+}
+
 /* NVIC has its own header file, but the base address is defined here.
 */
 #define NVIC_BASE			0xe000e100
@@ -215,22 +245,58 @@ static inline u32_t cxm_get_sp(void)
 	return sp;
 }
 
+/* cxm_lowest_bit() - return the number of the lowest bit that is set in a non-zero word
+ *
+ * The M0+ has no CLZ instruction, and __builtin_ctz() calls libgcc, so this uses a de Bruijn
+ * sequence: the top 5 bits of (0x077cb531 * (1 << n)) are different for each n.
+*/
+static inline u32_t cxm_lowest_bit(u32_t v)
+{
+	static const u8_t debruijn[32] =
+	{	0,  1, 28,  2, 29, 14, 24,  3, 30, 22, 20, 15, 25, 17,  4,  8,
+		31, 27, 13, 23, 21, 19, 16,  7, 26, 12, 18,  6, 11,  5, 10,  9
+	};
+
+	return debruijn[((v & (0 - v)) * 0x077cb531) >> 27];
+}
+
 /* Interrupt status, locking and unlocking
+ *
+ * With RP2040_IRQPROF (default 0) the outermost disable()/restore() pair reports the length of the
+ * critical section to the interrupt profiler (see rp2040-irqprof.h). Everything that is linked
+ * into the program must be compiled with the same setting.
 */
 typedef u8_t intstatus_t;
 #define INTENABLED	0x0		/* PRIMASK value to enable interrupts */
 #define INTDISABLED	0x1		/* PRIMASK value to disable interrupts */
 
+#ifndef RP2040_IRQPROF
+#define RP2040_IRQPROF	0
+#endif
+
+#if RP2040_IRQPROF
+extern void rp2040_irqprof_crit_enter(void);
+extern void rp2040_irqprof_crit_exit(void);
+#endif
+
 static inline intstatus_t disable(void)
 {
 	intstatus_t old = (intstatus_t)cxm_get_primask();
 	cxm_set_primask(INTDISABLED);
+#if RP2040_IRQPROF
+	if ( old == INTENABLED )
+		rp2040_irqprof_crit_enter();
+#endif
 	return old;
 }
 
 static inline intstatus_t restore(intstatus_t x)
 {
 	intstatus_t old = (intstatus_t)cxm_get_primask();
+#if RP2040_IRQPROF
+	if ( old == INTDISABLED && x == INTENABLED )
+		rp2040_irqprof_crit_exit();
+#endif
 	cxm_set_primask((u32_t)x);
 	return old;
 }
@@ -0,0 +1,101 @@
+/* rp2040-crash.h - crash capture and reset reason
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RP2040_CRASH_H
+#define RP2040_CRASH_H	1
+
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-watchdog.h"
+
+/* Crash capture
+ *
+ * rp2040_crash_handler() is an exception handler that records where the fault happened in the
+ * watchdog scratch registers and reboots the chip with the watchdog. Use it for the HardFault vector
+ * (-DAPP_HARDFAULT=rp2040_crash_handler, or rp2040_exc_set_handler() with RAM vectors); it works
+ * for the other unexpected exceptions too. The reboot doesn't restart the oscillators, so the
+ * program is running again a few milliseconds later.
+ *
+ * rp2040_kickstart() reads the record back into rp2040_reset_info and clears it, so it's only
+ * reported once. After a power-on or RUN pin reset there is no record. The record of a task that
+ * missed its deadline (see the watchdog service in rp2040-watchdog.h) is read back in the same way.
+ *
+ * The record uses scratch[0] to scratch[3]. The boot ROM uses scratch[4] to scratch[7].
+ *	scratch[0]	magic (31:24), core (23), exception number (21:16), xPSR (31:24) (15:8),
+ *				xPSR exception number, i.e. what was interrupted (5:0)
+ *	scratch[1]	stacked PC
+ *	scratch[2]	stacked LR
+ *	scratch[3]	uptime in units of 1024 us
+ * If the stack pointer at the time of the fault wasn't in SRAM, PC and LR are RP2040_CRASH_NOFRAME
+ * and the xPSR is 0.
+*/
+#define RP2040_CRASH_MAGIC		0xc5000000
+#define RP2040_CRASH_NOFRAME	0xffffffff
+
+typedef struct rp2040_crash_s rp2040_crash_t;
+
+struct rp2040_crash_s
+{
+	u32_t reason;			/* WATCHDOG_REASON_xxx; 0 after power-on */
+	boolean_t crashed;		/* The remaining fields are valid */
+	u32_t core;				/* Core that faulted */
+	u32_t exception;		/* Exception that caught the fault, e.g. 3 for HardFault */
+	u32_t pc;				/* Address of the faulting instruction */
+	u32_t lr;
+	u32_t xpsr;
+	u32_t uptime;			/* Time of the crash since the timer started, in units of 1024 us */
+	int missed;				/* Watchdog task that missed its deadline, or -1 */
+	u32_t late;				/* Time between the task's last check-in and the miss, in us */
+};
+
+extern rp2040_crash_t rp2040_reset_info;
+
+/* rp2040_crash_fetch() - read and clear the reset reason and crash record
+*/
+static inline void rp2040_crash_fetch(rp2040_crash_t *c)
+{
+	u32_t s0 = rp2040_watchdog.scratch[0];
+
+	c->reason = rp2040_watchdog.reason;
+	c->crashed = (c->reason & WATCHDOG_REASON_FORCE) != 0 && (s0 & 0xff000000) == RP2040_CRASH_MAGIC;
+
+	if ( c->crashed )
+	{
+		c->core = (s0 >> 23) & 0x1;
+		c->exception = (s0 >> 16) & 0x3f;
+		c->xpsr = ((s0 & 0xff00) << 16) | (s0 & 0x3f);
+		c->pc = rp2040_watchdog.scratch[1];
+		c->lr = rp2040_watchdog.scratch[2];
+		c->uptime = rp2040_watchdog.scratch[3];
+	}
+
+	c->missed = -1;
+	if ( (c->reason & WATCHDOG_REASON_TIMER) != 0 && (s0 & 0xff000000) == RP2040_WATCHDOG_MAGIC )
+	{
+		c->missed = (int)(s0 & 0xff);
+		c->late = rp2040_watchdog.scratch[1];
+	}
+	rp2040_watchdog.scratch[0] = 0;
+}
+
+extern void rp2040_crash_handler(void);
+extern void rp2040_crash_record(const u32_t *frame) __attribute__((noreturn));
+extern void rp2040_crash_report(void (*putc)(char));
+
+#endif
@@ -0,0 +1,114 @@
+/* rp2040-delay.h - busy-wait delays and timeouts
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RP2040_DELAY_H
+#define RP2040_DELAY_H	1
+
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-timer.h"
+
+/* Delays and timeouts
+ *
+ * The microsecond functions use the TIMER, which counts at 1 MHz from clk_ref (via the watchdog tick
+ * generator), so they don't depend on clk_sys or on the compiler's optimisation. The timer is started by
+ * rp2040_kickstart() as soon as the XOSC is running, before the PLLs are started. The 32-bit
+ * microsecond count wraps after about 71 minutes; delays and timeouts must be less than half of that.
+ *
+ * Before the timer is running (i.e. in the clock initialisation) use the cycle-counting functions. They
+ * count CPU cycles with a loop in assembly language, so they don't depend on the optimisation either,
+ * but their duration in time does depend on the CPU clock. The loop takes 4 cycles per iteration when
+ * running from RAM; from flash it can take longer.
+*/
+
+/* rp2040_busy_wait_cycles() - wait for (at least) n CPU cycles
+*/
+static inline void rp2040_busy_wait_cycles(u32_t n)
+{
+	u32_t i = (n + 3) >> 2;
+
+	if ( i != 0 )
+	{
+		__asm__ volatile(
+			"1:	nop\n"
+			"	sub	%[i], #1\n"
+			"	bne	1b\n"
+			: [i] "+l" (i) : : "cc");
+	}
+}
+
+/* rp2040_deadline() - return the timer value that is us microseconds in the future
+*/
+static inline u32_t rp2040_deadline(u32_t us)
+{
+	return rp2040_timer.time_lraw + us;
+}
+
+/* rp2040_deadline_passed() - return true if the deadline has been reached
+*/
+static inline boolean_t rp2040_deadline_passed(u32_t deadline)
+{
+	return (s32_t)(rp2040_timer.time_lraw - deadline) >= 0;
+}
+
+/* rp2040_busy_wait_us() - wait for (at least) us microseconds
+*/
+static inline void rp2040_busy_wait_us(u32_t us)
+{
+	u32_t deadline = rp2040_deadline(us + 1);	/* +1 because the current microsecond has partly gone */
+
+	while ( !rp2040_deadline_passed(deadline) )
+	{
+		/* Wait */
+	}
+}
+
+/* rp2040_wait_reg() - wait until (*reg & mask) == value or until the timeout expires
+ *
+ * Returns 0 if the condition was met, -1 on timeout. The condition is checked once more after the
+ * timeout has expired, so a pre-emption at the wrong moment doesn't cause a false timeout.
+*/
+static inline int rp2040_wait_reg(const reg32_t *reg, u32_t mask, u32_t value, u32_t timeout_us)
+{
+	u32_t deadline = rp2040_deadline(timeout_us + 1);
+
+	while ( (*reg & mask) != value )
+	{
+		if ( rp2040_deadline_passed(deadline) )
+			return ( (*reg & mask) == value ) ? 0 : -1;
+	}
+	return 0;
+}
+
+/* rp2040_wait_reg_cycles() - like rp2040_wait_reg() but with the timeout in CPU cycles
+ *
+ * For use when the timer isn't running. The register is checked about every 16 cycles.
+*/
+static inline int rp2040_wait_reg_cycles(const reg32_t *reg, u32_t mask, u32_t value, u32_t timeout_cycles)
+{
+	for ( u32_t n = (timeout_cycles >> 4) + 1; n > 0; n-- )
+	{
+		if ( (*reg & mask) == value )
+			return 0;
+		rp2040_busy_wait_cycles(16);
+	}
+	return ( (*reg & mask) == value ) ? 0 : -1;
+}
+
+#endif
@@ -0,0 +1,155 @@
+/* rp2040-edgecap.h - edge timestamp capture using PIO and DMA
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RP2040_EDGECAP_H
+#define RP2040_EDGECAP_H	1
+
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-pio.h"
+#include "rp2040-piodma.h"
+
+/* Edge capture
+ *
+ * Each pin is watched by its own PIO state machine running the program below. The state machine
+ * decrements X once every two clk_sys cycles. When the pin changes, it pushes a word containing
+ * the low 31 bits of X and the new pin level:
+ *
+ *	bits 31..1	X (31 bits)
+ *	bit 0		new level (1 = rising edge, 0 = falling edge)
+ *
+ * A ring-mode PIO DMA stream (rp2040-piodma.h) copies the words into a ring buffer per pin, so
+ * the capture runs without any CPU involvement. rp2040_edgecap_read() decodes the words from all
+ * the pins in time order.
+ *
+ * Resolution is 2 clk_sys cycles (15 ns at 133 MHz). After an edge, the pin is not sampled again
+ * for 4 cycles, so pulses shorter than that might be missed (both edges). The sustained edge rate per
+ * pin is limited by the DMA and the size of the ring buffer: the CPU must read the events before the
+ * ring buffer wraps. There must be at least one edge on each pin every 2^31 counts (32 s at 133 MHz)
+ * or the decoded times will be out by a multiple of that.
+ *
+ *	0	start:		set y, 1			; Constant 1 for the level bit
+ *	1				mov x, ~null		; Counter starts at 0xffffffff
+ *	2	low:		jmp pin rise
+ *	3				jmp x-- low
+ *	4				jmp low				; X wrapped
+ *	5	rise:		in x, 31
+ *	6				in y, 1				; Autopush
+ *	7				jmp x-- high
+ *	8	high:		jmp pin hdec
+ *	9				in x, 31
+ *	10				in null, 1			; Autopush
+ *	11				jmp x-- low
+ *	12				jmp low				; X wrapped
+ *	13	hdec:		jmp x-- high
+ *	14				jmp high			; X wrapped
+ *
+ * Timing: the sample (JMP PIN) that sees the n'th edge (n = 0, 1, ...) after X has been decremented
+ * d times since the start happens at cycle 2 + 2 * (d + n) after the state machine is enabled: each
+ * edge path costs one count. So the time between two successive events is 2 * (delta + 1) cycles,
+ * where delta is the difference of the captured counts (modulo 2^31). The same formula gives the time of
+ * the first event if the previous count is taken to be 0x7fffffff.
+ * The wrap paths add one cycle every 2^32 counts (64 s at 133 MHz).
+ *
+ * If a pin is high when the capture starts, the first event is a rising edge at time 0.
+ *
+ * The counts are converted to times with the frequency of clk_sys, which is updated by a clock change
+ * notifier when rp2040_clk_sys_set() changes it. The state machines run at clk_sys, so the conversion
+ * is only exact when the whole interval between two events on a pin was at one frequency. Events that
+ * are still in the ring buffers when clk_sys changes, and the first event on each pin after the change,
+ * are converted at the new frequency; their times are out by up to the difference in frequency times
+ * the interval, and the error carries over to the later events. Read all the events before changing
+ * clk_sys and expect an offset on each pin afterwards, or restart the capture.
+ *
+ * Jump addresses in the program are relative to 0. rp2040_edgecap_init() relocates them.
+*/
+#define RP2040_EDGECAP_PROGRAM	\
+{	0xe041,	0xa02b,	0x00c5,	0x0042,	0x0002,	0x403f,	0x4041,	0x0048,	\
+	0x00cd,	0x403f,	0x4061,	0x0042,	0x0002,	0x0048,	0x0008	\
+}
+#define RP2040_EDGECAP_PROGLEN	15
+
+#define RP2040_EDGECAP_MAXPIN	4		/* One state machine per pin */
+
+typedef struct rp2040_edge_s rp2040_edge_t;
+typedef struct rp2040_edgecap_chan_s rp2040_edgecap_chan_t;
+typedef struct rp2040_edgecap_s rp2040_edgecap_t;
+
+/* A decoded edge event
+*/
+struct rp2040_edge_s
+{
+	u64_t time;			/* Time of the edge in rp2040_read_time() units (microseconds) */
+	u32_t ns;			/* Sub-microsecond part of the time, in nanoseconds */
+	u8_t pin;			/* GPIO number */
+	u8_t level;			/* New level of the pin: 1 = rising edge, 0 = falling edge */
+};
+
+struct rp2040_edgecap_chan_s
+{
+	rp2040_piodma_t stream;	/* DMA ring */
+	u32_t *buf;				/* Ring buffer */
+	u32_t nwords;			/* Size of the ring buffer */
+	u32_t rd;				/* Index of the next word to decode */
+	u32_t prev;				/* Count from the previous event */
+	u64_t us;				/* Time of the previous event, in microseconds since the start */
+	u32_t frac;				/* ... plus this fraction of a microsecond (0.32 fixed point) */
+	boolean_t have_next;	/* next contains a decoded event that hasn't been returned yet */
+	rp2040_edge_t next;
+	u8_t pin;
+};
+
+struct rp2040_edgecap_s
+{
+	rp2040_pio_t *pio;
+	u64_t t0;				/* rp2040_read_time() when the capture was started */
+	u32_t us_per_cyc;		/* Length of a clk_sys cycle in microseconds (0.32 fixed point) */
+	u32_t offset;			/* Program location in instr_mem */
+	int npins;
+	rp2040_edgecap_chan_t chan[RP2040_EDGECAP_MAXPIN];
+};
+
+/* rp2040_edgecap_cfg() - state machine configuration for watching a pin
+ *
+ * Full speed, 8-deep RX FIFO, ISR shifts left with autopush at 32 bits.
+*/
+static inline void rp2040_edgecap_cfg(rp2040_piosm_cfg_t *cfg, u32_t pin, u32_t offset)
+{
+	rp2040_piosm_cfg_init(cfg);
+	rp2040_piosm_cfg_jmp_pin(cfg, pin);
+	rp2040_piosm_cfg_in_shift(cfg, 0, 1, 32);
+	rp2040_piosm_cfg_fifo_join(cfg, PIO_FJOIN_RX);
+	rp2040_piosm_cfg_wrap(cfg, offset, offset + RP2040_EDGECAP_PROGLEN - 1);
+}
+
+/* rp2040_edgecap_delta() - the number of clk_sys cycles between the event with count prev
+ * and the event in word w, divided by 2
+*/
+static inline u32_t rp2040_edgecap_delta(u32_t prev, u32_t w)
+{
+	return ((prev - (w >> 1)) & 0x7fffffff) + 1;
+}
+
+extern int rp2040_edgecap_init(rp2040_edgecap_t *cap, rp2040_pio_t *pio, u32_t offset,
+								const u8_t *pins, int npins, int dma_ch, u32_t *buf, u32_t nwords);
+extern void rp2040_edgecap_start(rp2040_edgecap_t *cap);
+extern int rp2040_edgecap_read(rp2040_edgecap_t *cap, rp2040_edge_t *ev);
+extern void rp2040_edgecap_stop(rp2040_edgecap_t *cap);
+
+#endif
@@ -0,0 +1,66 @@
+/* rp2040-gpioirq.h - GPIO interrupt dispatcher
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RP2040_GPIOIRQ_H
+#define RP2040_GPIOIRQ_H	1
+
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-nvic.h"
+
+/* GPIO interrupts
+ *
+ * rp2040_gpioirq_init() installs a dispatcher for IO_IRQ_BANK0 on the calling core.
+ * rp2040_gpioirq_set() selects the events of a pin that cause an interrupt and the function to call.
+ * The pin's interrupt goes to the core that calls rp2040_gpioirq_set(), which must have called
+ * rp2040_gpioirq_init(); it's disabled on the other core.
+ *
+ * The dispatcher reads the time once on entry, then takes the pins from the core's ints registers
+ * (8 pins per register, 4 event bits per pin) using a de Bruijn bit scan, so the cost depends on the
+ * number of active pins, not on the number of pins that are enabled. The edge events of a pin are
+ * cleared before its function is called, so an edge that occurs during the call isn't lost.
+ * A level event stays active as long as the level; the function must remove the cause or
+ * disable the pin's interrupt.
+ *
+ * The function is called with the pin number, the events (GPIO_IRQ_xxx, more than one if several
+ * occurred) and the time (rp2040_timer.time_lraw) at which the dispatcher started.
+ *
+ * Requires RP2040_RAM_VECTORS, because the dispatcher is installed with rp2040_irq_set_handler().
+*/
+#define GPIO_IRQ_LEVEL_LOW	0x1
+#define GPIO_IRQ_LEVEL_HIGH	0x2
+#define GPIO_IRQ_EDGE_FALL	0x4
+#define GPIO_IRQ_EDGE_RISE	0x8
+#define GPIO_IRQ_EDGE		(GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE)
+
+#define RP2040_GPIOIRQ_NPIN	30
+
+typedef void (*rp2040_gpioirq_fn_t)(int pin, u32_t events, u32_t time);
+
+extern void rp2040_gpioirq_init(u32_t prio);
+extern void rp2040_gpioirq_set(int pin, u32_t events, rp2040_gpioirq_fn_t fn);
+
+/* rp2040_gpioirq_disable() - disable all interrupts from a pin
+*/
+static inline void rp2040_gpioirq_disable(int pin)
+{
+	rp2040_gpioirq_set(pin, 0, 0);
+}
+
+#endif
@@ -0,0 +1,97 @@
+/* rp2040-irqprof.h - interrupt latency and execution-time profiler
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RP2040_IRQPROF_H
+#define RP2040_IRQPROF_H	1
+
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-nvic.h"
+#include "rp2040-cm0.h"
+
+/* Interrupt profiler
+ *
+ * rp2040_irqprof_attach() replaces an IRQ's handler in the calling core's RAM vector table with a
+ * wrapper that measures the handler. All times are in CPU cycles, measured with SysTick, which
+ * rp2040_irqprof_init() starts as a free-running counter. For each IRQ the profiler records:
+ *	- the number of calls
+ *	- the execution time of the handler, excluding the time spent in nested (pre-empting) handlers
+ *	- the entry latency, if there's a reference time (see below)
+ *	- the maximum and a histogram of each time
+ * It also records the maximum nesting depth and, with RP2040_IRQPROF, the length of the longest
+ * critical section (outermost disable() to restore()).
+ *
+ * Entry latency is the time from the event that requests the IRQ to the start of the wrapper. It
+ * includes the hardware exception entry, any time that interrupts were disabled and any time that a
+ * handler of the same or higher priority was running. The reference time comes from:
+ *	- rp2040_irqprof_ref(), called just before software triggers the IRQ (e.g. rp2040_nvic_pend())
+ *	  or just before an event that is known to cause it
+ *	- for the TIMER IRQs, the alarm register. The timer counts in microseconds, so the latency is only
+ *	  accurate to about 1 us.
+ *
+ * Histogram bucket 0 counts times of 0 or 1 cycle; bucket n counts times in the range 2^n to 2^(n+1)-1.
+ * The last bucket counts everything beyond. The counts saturate at 0xffff.
+ *
+ * SysTick wraps at 2^24 cycles, so times longer than 126 ms at 133 MHz are reported modulo 2^24.
+ * The profiler is per core: each core that uses it must call rp2040_irqprof_init().
+ *
+ * Requires RP2040_RAM_VECTORS. The wrapper's own overhead is counted in the latencies of the IRQs that
+ * it delays, but not in the execution times.
+*/
+#ifndef RP2040_IRQPROF_NBUCKET
+#define RP2040_IRQPROF_NBUCKET	16
+#endif
+
+typedef struct rp2040_irqstat_s rp2040_irqstat_t;
+
+struct rp2040_irqstat_s
+{
+	u32_t count;							/* No. of calls */
+	u32_t n_lat;							/* No. of calls with a latency reference */
+	u32_t max_exec;							/* Longest execution time */
+	u32_t max_lat;							/* Longest entry latency */
+	u16_t exec[RP2040_IRQPROF_NBUCKET];		/* Histogram of execution times */
+	u16_t lat[RP2040_IRQPROF_NBUCKET];		/* Histogram of entry latencies */
+};
+
+/* rp2040_irqprof_bucket() - the histogram bucket for a time
+*/
+static inline int rp2040_irqprof_bucket(u32_t t)
+{
+	int b = 0;
+
+	while ( t > 1 && b < (RP2040_IRQPROF_NBUCKET-1) )
+	{
+		t >>= 1;
+		b++;
+	}
+	return b;
+}
+
+extern void rp2040_irqprof_init(void);
+extern void rp2040_irqprof_reset(void);
+extern void rp2040_irqprof_attach(irqid_t irq);
+extern void rp2040_irqprof_detach(irqid_t irq);
+extern void rp2040_irqprof_ref(irqid_t irq);
+extern void rp2040_irqprof_get(irqid_t irq, rp2040_irqstat_t *st);
+extern u32_t rp2040_irqprof_max_crit(void);
+extern u32_t rp2040_irqprof_max_depth(void);
+extern void rp2040_irqprof_dump(void (*putc)(char));
+
+#endif
@@ -0,0 +1,136 @@
+/* rp2040-log.h - deferred binary logging
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RP2040_LOG_H
+#define RP2040_LOG_H	1
+
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-cm0.h"
+#include "rp2040-sio.h"
+#include "rp2040-timer.h"
+#include "rp2040-uart.h"
+
+/* Binary log
+ *
+ * RP2040_LOG0(fmt) .. RP2040_LOG4(fmt, a, b, c, d) record a message without formatting it. The format
+ * string is placed in the .rp2040_log section, which the linker scripts put at address 0 in the ELF file
+ * without loading it, so the strings cost no memory on the target. The address of the string is the
+ * message ID. A record is the ID, the number of arguments, the microsecond timer and the arguments
+ * (each 32 bits), appended to the calling core's ring buffer. Interrupts are disabled for the few stores,
+ * so the macros can be used anywhere, including interrupt handlers; the cores don't share anything.
+ * If a ring is full the record is dropped and counted.
+ *
+ * rp2040_log_poll() sends records to a UART, as much as fits in the tx FIFO without waiting. Call it
+ * from the idle loop of one core. rp2040_log_flush() sends everything to a character sink and waits.
+ * host/logdecode.c turns the output back into text using the strings from the program's ELF file.
+ *
+ * The format strings use the conversions of rp2040_printf() except 'll'. A %s argument must point to a
+ * string constant in the program (it's read from the ELF file).
+ *
+ * Wire format of a record (little-endian):
+ *	0xa5, (core << 7) | n_args, id (2 bytes), timestamp (4 bytes), args (4 * n_args bytes), checksum
+ * The checksum is the XOR of all the bytes after the 0xa5. The decoder copies any bytes that aren't part of
+ * a record to its output, so text (which never contains 0xa5) and log records can share a UART.
+ * ID 0xffff with one argument reports the number of records that were dropped.
+ *
+ * With RP2040_LOG_ENABLE set to 0 the macros generate no code.
+*/
+#ifndef RP2040_LOG_ENABLE
+#define RP2040_LOG_ENABLE	1
+#endif
+
+#ifndef RP2040_LOG_SIZE
+#define RP2040_LOG_SIZE		256		/* Words per core; must be a power of 2 */
+#endif
+
+#define RP2040_LOG_MAXARG	4
+#define RP2040_LOG_SYNC		0xa5
+#define RP2040_LOG_DROPPED	0xffff
+
+typedef struct rp2040_logring_s rp2040_logring_t;
+
+struct rp2040_logring_s
+{
+	volatile u32_t head;			/* Written only by the owning core */
+	volatile u32_t tail;			/* Written only by the drain */
+	volatile u32_t dropped;			/* No. of records that didn't fit */
+	u32_t buf[RP2040_LOG_SIZE];
+};
+
+extern rp2040_logring_t rp2040_logring[2];
+
+/* rp2040_log_put() - append a record to the calling core's ring
+ *
+ * Only the first n of a0..a3 are stored.
+*/
+static inline void rp2040_log_put(u32_t id, u32_t n, u32_t a0, u32_t a1, u32_t a2, u32_t a3)
+{
+	rp2040_logring_t *r = &rp2040_logring[rp2040_sio.cpuid & 0x1];
+	const u32_t m = RP2040_LOG_SIZE - 1;
+	intstatus_t is = disable();
+	u32_t h = r->head;
+
+	if ( RP2040_LOG_SIZE - (h - r->tail) < n + 2 )
+	{
+		r->dropped++;
+	}
+	else
+	{
+		r->buf[h & m] = id | (n << 16);
+		r->buf[(h + 1) & m] = rp2040_timer.time_lraw;
+		if ( n > 0 ) r->buf[(h + 2) & m] = a0;
+		if ( n > 1 ) r->buf[(h + 3) & m] = a1;
+		if ( n > 2 ) r->buf[(h + 4) & m] = a2;
+		if ( n > 3 ) r->buf[(h + 5) & m] = a3;
+		__asm__ volatile("dmb" : : : "memory");		/* The drain can be on the other core */
+		r->head = h + n + 2;
+	}
+
+	restore(is);
+}
+
+#if RP2040_LOG_ENABLE
+
+#define RP2040_LOG_ID(fmt) \
+	({	static const char rp2040_log_fmt[] __attribute__((section(".rp2040_log"), used)) = fmt; \
+		(u32_t)rp2040_log_fmt; })
+
+#define RP2040_LOG0(fmt)				rp2040_log_put(RP2040_LOG_ID(fmt), 0, 0, 0, 0, 0)
+#define RP2040_LOG1(fmt, a)				rp2040_log_put(RP2040_LOG_ID(fmt), 1, (u32_t)(a), 0, 0, 0)
+#define RP2040_LOG2(fmt, a, b)			rp2040_log_put(RP2040_LOG_ID(fmt), 2, (u32_t)(a), (u32_t)(b), 0, 0)
+#define RP2040_LOG3(fmt, a, b, c)		rp2040_log_put(RP2040_LOG_ID(fmt), 3, (u32_t)(a), (u32_t)(b), \
+																		(u32_t)(c), 0)
+#define RP2040_LOG4(fmt, a, b, c, d)	rp2040_log_put(RP2040_LOG_ID(fmt), 4, (u32_t)(a), (u32_t)(b), \
+																		(u32_t)(c), (u32_t)(d))
+
+#else
+
+#define RP2040_LOG0(fmt)				do { } while (0)
+#define RP2040_LOG1(fmt, a)				do { } while (0)
+#define RP2040_LOG2(fmt, a, b)			do { } while (0)
+#define RP2040_LOG3(fmt, a, b, c)		do { } while (0)
+#define RP2040_LOG4(fmt, a, b, c, d)	do { } while (0)
+
+#endif
+
+extern boolean_t rp2040_log_poll(rp2040_uart_t *uart);
+extern void rp2040_log_flush(void (*putc)(char));
+
+#endif
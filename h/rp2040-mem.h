@@ -0,0 +1,95 @@
+/* rp2040-mem.h - fixed-block pools and bump arenas
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RP2040_MEM_H
+#define RP2040_MEM_H	1
+
+#include "rp2040.h"
+#include "rp2040-types.h"
+
+/* Memory allocation without a heap
+ *
+ * A pool hands out blocks of one fixed size from a caller-supplied array. Allocation and freeing
+ * take the first block from, or put a block back on, a free list, so both take constant time and
+ * there's no fragmentation.
+ *
+ * An arena hands out blocks of any size from a caller-supplied memory region by advancing a pointer.
+ * Blocks can't be freed one by one; instead the whole arena is reset, or released back to a mark
+ * that was taken earlier (e.g. at the start of processing a message).
+ *
+ * All the functions can be called from thread mode and interrupt handlers on either core. Each pool
+ * or arena is protected by a hardware spinlock (usually RP2040_SPINLOCK_MEM) with interrupts disabled,
+ * for a few tens of cycles at most.
+ *
+ * Each pool and arena keeps statistics: the current and maximum usage (high watermark) and the
+ * number of failed allocations. They can be read at any time; rp2040_pool_clearstats() and
+ * rp2040_arena_clearstats() reset the maximum and the failure count.
+ *
+ * rp2040_heap_start and rp2040_heap_end are set by the linker scripts: the RAM between the end of the
+ * .bss and the bottom of the process stacks. rp2040_arena_init_heap() uses it for an arena.
+*/
+typedef struct rp2040_pool_s rp2040_pool_t;
+typedef struct rp2040_arena_s rp2040_arena_t;
+
+struct rp2040_pool_s
+{
+	void *free;					/* Free list; private */
+	u8_t *base;					/* The array of blocks */
+	u32_t block_size;			/* Size of each block in bytes (multiple of 4) */
+	u32_t n_blocks;				/* Number of blocks */
+	u32_t n_used;				/* Number of blocks allocated */
+	u32_t max_used;				/* High watermark of n_used */
+	u32_t n_fail;				/* Number of failed allocations */
+	int lock;					/* Spinlock number */
+};
+
+struct rp2040_arena_s
+{
+	u8_t *base;					/* Start of the region */
+	u32_t size;					/* Size of the region in bytes */
+	u32_t used;					/* Number of bytes allocated, including alignment */
+	u32_t max_used;				/* High watermark of used */
+	u32_t n_fail;				/* Number of failed allocations */
+	int lock;					/* Spinlock number */
+};
+
+/* RP2040_POOL_MEM() - the number of u32_t needed for a pool of n blocks of size bytes
+ *
+ * Example: static u32_t msg_mem[RP2040_POOL_MEM(sizeof(msg_t), 16)];
+*/
+#define RP2040_POOL_MEM(size, n)	((((size) + 3) / 4) * (n))
+
+#define RP2040_ARENA_ALIGN			8		/* Alignment of arena blocks */
+
+extern u8_t rp2040_heap_start[], rp2040_heap_end[];	/* Set in the linker script */
+
+extern u32_t rp2040_pool_init(rp2040_pool_t *p, void *mem, u32_t mem_size, u32_t block_size, int lock);
+extern void *rp2040_pool_alloc(rp2040_pool_t *p);
+extern void rp2040_pool_free(rp2040_pool_t *p, void *b);
+extern void rp2040_pool_clearstats(rp2040_pool_t *p);
+
+extern void rp2040_arena_init(rp2040_arena_t *a, void *mem, u32_t mem_size, int lock);
+extern void rp2040_arena_init_heap(rp2040_arena_t *a, int lock);
+extern void *rp2040_arena_alloc(rp2040_arena_t *a, u32_t size);
+extern u32_t rp2040_arena_mark(rp2040_arena_t *a);
+extern void rp2040_arena_release(rp2040_arena_t *a, u32_t mark);
+extern void rp2040_arena_reset(rp2040_arena_t *a);
+extern void rp2040_arena_clearstats(rp2040_arena_t *a);
+
+#endif
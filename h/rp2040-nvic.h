@@ -22,6 +22,7 @@
 
 #include "rp2040.h"
 #include "rp2040-types.h"
+#include "rp2040-cm0.h"
 
 /* Interrupt priorities
  * These values must be shifted left by 0, 8, 16 or 24 bits depending on irqid % 4
@@ -91,4 +92,120 @@ struct nvic_s
 #define NVIC_BASE			0xe000e100
 #define rp2040_nvic			((nvic_t *)NVIC_BASE)[0]
 
+/* NVIC functions
+ *
+ * The NVIC is part of each core, so these functions affect the calling core only.
+ *
+ * Priorities: the M0+ implements 2 bits of priority (NVIC_PRIO_0 to NVIC_PRIO_3). There is no priority
+ * grouping (no PRIGROUP field in AIRCR on ARMv6-M) and no BASEPRI: every priority level is a pre-emption
+ * level. An IRQ pre-empts the running handler if and only if its priority is numerically lower (i.e.
+ * more urgent). IRQs at the same priority don't pre-empt each other; if several are pending, the lowest
+ * IRQ number runs first. So to give a fast, high-rate ISR precedence over a slow one, give the fast one
+ * a lower NVIC_PRIO_x value.
+ *
+ * IRQs 26 to 31 have no hardware source. Use rp2040_nvic_pend() to trigger them from software,
+ * e.g. for deferred work at a low priority.
+*/
+
+/* rp2040_nvic_init() - disable all IRQs, clear all pending IRQs and set all priorities to the lowest
+*/
+static inline void rp2040_nvic_init(void)
+{
+	rp2040_nvic.icer[0] = 0xffffffff;
+	rp2040_nvic.icpr[0] = 0xffffffff;
+
+	for ( int i = 0; i < nvic_nirq/4; i++ )
+	{
+		rp2040_nvic.ipr[i] = 0xc0c0c0c0;		/* NVIC_PRIO_3 in all four bytes */
+	}
+}
+
+static inline void rp2040_nvic_enable(irqid_t irq)
+{
+	rp2040_nvic.iser[0] = 0x1u << irq;
+}
+
+static inline void rp2040_nvic_disable(irqid_t irq)
+{
+	rp2040_nvic.icer[0] = 0x1u << irq;
+}
+
+/* rp2040_nvic_pend() - set an IRQ's pending flag (software trigger)
+*/
+static inline void rp2040_nvic_pend(irqid_t irq)
+{
+	rp2040_nvic.ispr[0] = 0x1u << irq;
+}
+
+/* rp2040_nvic_unpend() - clear an IRQ's pending flag
+ *
+ * For a level-sensitive peripheral IRQ, the flag is set again if the peripheral is still requesting.
+*/
+static inline void rp2040_nvic_unpend(irqid_t irq)
+{
+	rp2040_nvic.icpr[0] = 0x1u << irq;
+}
+
+static inline boolean_t rp2040_nvic_is_enabled(irqid_t irq)
+{
+	return (rp2040_nvic.iser[0] & (0x1u << irq)) != 0;
+}
+
+static inline boolean_t rp2040_nvic_is_pending(irqid_t irq)
+{
+	return (rp2040_nvic.ispr[0] & (0x1u << irq)) != 0;
+}
+
+/* rp2040_nvic_set_priority() - set an IRQ's priority (NVIC_PRIO_0 to NVIC_PRIO_3)
+ *
+ * The IPR registers only support 32-bit access on the M0+, so this is a read-modify-write
+ * with interrupts disabled.
+*/
+static inline void rp2040_nvic_set_priority(irqid_t irq, u32_t prio)
+{
+	u32_t shift = ((u32_t)irq & 0x3) * 8;
+	intstatus_t is = disable();
+	rp2040_nvic.ipr[irq/4] = (rp2040_nvic.ipr[irq/4] & ~(0xffu << shift)) | ((prio & 0xc0) << shift);
+	restore(is);
+}
+
+static inline u32_t rp2040_nvic_get_priority(irqid_t irq)
+{
+	return (rp2040_nvic.ipr[irq/4] >> (((u32_t)irq & 0x3) * 8)) & 0xc0;
+}
+
+/* Vector tables
+ *
+ * rp2040_hwvectors[] is the const table that is filled at compile time from the APP_xxx macros.
+ * With RP2040_RAM_VECTORS (the default), the startup code of each core copies it to a RAM table of
+ * its own and points VTOR at that. Handlers can then be changed at run time with
+ * rp2040_irq_set_handler() and rp2040_exc_set_handler(), independently on each core.
+ * The RAM tables also avoid fetching vectors from flash (XIP) on exception entry.
+ *
+ * The RAM tables are in .bss, so they cost 512 bytes (two 256-byte aligned tables).
+*/
+#ifndef RP2040_RAM_VECTORS
+#define RP2040_RAM_VECTORS	1
+#endif
+
+#define RP2040_NVECTORS		(16+32)		/* 16 exceptions + 32 IRQs */
+
+typedef void (*rp2040_vector_t)(void);
+
+extern const rp2040_vector_t rp2040_hwvectors[RP2040_NVECTORS];
+
+#if RP2040_RAM_VECTORS
+extern void rp2040_ramvectors_init(void);
+extern rp2040_vector_t rp2040_exc_set_handler(int exc, rp2040_vector_t fn);
+
+/* rp2040_irq_set_handler() - set the handler for an IRQ on the calling core
+ *
+ * Returns the previous handler. The IRQ should be disabled in the NVIC while the handler is changed.
+*/
+static inline rp2040_vector_t rp2040_irq_set_handler(irqid_t irq, rp2040_vector_t fn)
+{
+	return rp2040_exc_set_handler(16 + (int)irq, fn);
+}
+#endif
+
 #endif
@@ -109,5 +109,191 @@ struct rp2040_pio_s
 #define PIO_IRQ			0xc000
 #define PIO_SET			0xe000
 
+/* CTRL register. Each field has one bit per state machine.
+*/
+#define PIO_CLKDIV_RESTART(sm)	(0x100 << (sm))
+#define PIO_SM_RESTART(sm)		(0x010 << (sm))
+#define PIO_SM_ENABLE(sm)		(0x001 << (sm))
+
+/* FSTAT register. Each field has one bit per state machine.
+*/
+#define PIO_FSTAT_TXEMPTY(sm)	(0x01000000 << (sm))
+#define PIO_FSTAT_TXFULL(sm)	(0x00010000 << (sm))
+#define PIO_FSTAT_RXEMPTY(sm)	(0x00000100 << (sm))
+#define PIO_FSTAT_RXFULL(sm)	(0x00000001 << (sm))
+
+/* CLKDIV register (SMx_CLKDIV). The divider is INT + FRAC/256; INT == 0 means 65536
+*/
+#define PIO_CLKDIV_INT			0xffff0000
+#define PIO_CLKDIV_FRAC			0x0000ff00
+
+/* EXECCTRL register (SMx_EXECCTRL)
+*/
+#define PIO_EXEC_STALLED		0x80000000	/* (RO) Instruction written to SMx_INSTR is stalled */
+#define PIO_SIDE_EN				0x40000000	/* MSB of side-set field is an enable bit (side-set is optional) */
+#define PIO_SIDE_PINDIR			0x20000000	/* Side-set affects pin directions instead of values */
+#define PIO_JMP_PIN				0x1f000000	/* GPIO for JMP PIN */
+#define PIO_OUT_EN_SEL			0x00f80000	/* Data bit for inline output enable */
+#define PIO_INLINE_OUT_EN		0x00040000	/* Use a bit of OUT data as an auxiliary write enable */
+#define PIO_OUT_STICKY			0x00020000	/* Continuously assert the most recent OUT/SET to the pins */
+#define PIO_WRAP_TOP			0x0001f000	/* After this address, wrap to WRAP_BOTTOM */
+#define PIO_WRAP_BOTTOM			0x00000f80	/* Wrap target */
+#define PIO_STATUS_SEL			0x00000010	/* 0 = TX FIFO level, 1 = RX FIFO level for MOV x, STATUS */
+#define PIO_STATUS_N			0x0000000f	/* FIFO level threshold for MOV x, STATUS */
+
+/* SHIFTCTRL register (SMx_SHIFTCTRL)
+*/
+#define PIO_FJOIN_RX			0x80000000	/* RX FIFO steals the TX FIFO's storage: 8-deep RX, no TX */
+#define PIO_FJOIN_TX			0x40000000	/* TX FIFO steals the RX FIFO's storage: 8-deep TX, no RX */
+#define PIO_PULL_THRESH			0x3e000000	/* Autopull threshold. 0 means 32 */
+#define PIO_PUSH_THRESH			0x01f00000	/* Autopush threshold. 0 means 32 */
+#define PIO_OUT_SHIFTDIR		0x00080000	/* 1 = shift OSR right */
+#define PIO_IN_SHIFTDIR			0x00040000	/* 1 = shift ISR right */
+#define PIO_AUTOPULL			0x00020000	/* Pull automatically when the OSR reaches PULL_THRESH */
+#define PIO_AUTOPUSH			0x00010000	/* Push automatically when the ISR reaches PUSH_THRESH */
+
+/* PINCTRL register (SMx_PINCTRL)
+*/
+#define PIO_SIDESET_COUNT		0xe0000000	/* No. of side-set bits, including the enable bit */
+#define PIO_SET_COUNT			0x1c000000	/* No. of pins asserted by SET (0..5) */
+#define PIO_OUT_COUNT			0x03f00000	/* No. of pins asserted by OUT (0..32) */
+#define PIO_IN_BASE				0x000f8000	/* First pin for IN, WAIT and MOV x, PINS */
+#define PIO_SIDESET_BASE		0x00007c00	/* First pin for side-set */
+#define PIO_SET_BASE			0x000003e0	/* First pin for SET */
+#define PIO_OUT_BASE			0x0000001f	/* First pin for OUT */
+
+/* State machine configuration
+ *
+ * A configuration is built in RAM with the rp2040_piosm_cfg_xxx() functions and then written to
+ * a state machine in one go with rp2040_piosm_apply(). Start with rp2040_piosm_cfg_init(), which
+ * sets the same values as a hardware reset.
+ *
+ * Pin numbers are GPIO numbers. Wrap addresses are absolute instr_mem addresses (i.e. the
+ * offset of the program has already been added).
+*/
+typedef struct rp2040_piosm_cfg_s rp2040_piosm_cfg_t;
+
+struct rp2040_piosm_cfg_s
+{
+	u32_t clkdiv;
+	u32_t execctrl;
+	u32_t shiftctrl;
+	u32_t pinctrl;
+};
+
+/* FIFO join options for rp2040_piosm_cfg_fifo_join()
+*/
+#define PIO_FJOIN_NONE			0
+
+static inline void rp2040_piosm_cfg_init(rp2040_piosm_cfg_t *cfg)
+{
+	cfg->clkdiv = 0x00010000;		/* Divide by 1 */
+	cfg->execctrl = 0x0001f000;		/* Wrap from 31 to 0 */
+	cfg->shiftctrl = 0x000c0000;	/* Shift right, no autopush/autopull, thresholds 32 */
+	cfg->pinctrl = 0x14000000;		/* SET_COUNT = 5, everything else 0 */
+}
+
+/* rp2040_piosm_cfg_field() - set the field given by mask in a configuration register to val
+ *
+ * mask & -mask is the field's lowest bit, so the multiplication shifts val into place. This avoids
+ * __builtin_ctz(), which calls libgcc on the M0+ when mask isn't a compile-time constant.
+*/
+static inline void rp2040_piosm_cfg_field(u32_t *reg, u32_t mask, u32_t val)
+{
+	*reg = (*reg & ~mask) | ((val * (mask & (0 - mask))) & mask);
+}
+
+static inline void rp2040_piosm_cfg_wrap(rp2040_piosm_cfg_t *cfg, u32_t bottom, u32_t top)
+{
+	rp2040_piosm_cfg_field(&cfg->execctrl, PIO_WRAP_BOTTOM, bottom);
+	rp2040_piosm_cfg_field(&cfg->execctrl, PIO_WRAP_TOP, top);
+}
+
+static inline void rp2040_piosm_cfg_out_pins(rp2040_piosm_cfg_t *cfg, u32_t base, u32_t count)
+{
+	rp2040_piosm_cfg_field(&cfg->pinctrl, PIO_OUT_BASE, base);
+	rp2040_piosm_cfg_field(&cfg->pinctrl, PIO_OUT_COUNT, count);
+}
+
+static inline void rp2040_piosm_cfg_set_pins(rp2040_piosm_cfg_t *cfg, u32_t base, u32_t count)
+{
+	rp2040_piosm_cfg_field(&cfg->pinctrl, PIO_SET_BASE, base);
+	rp2040_piosm_cfg_field(&cfg->pinctrl, PIO_SET_COUNT, count);
+}
+
+static inline void rp2040_piosm_cfg_in_pins(rp2040_piosm_cfg_t *cfg, u32_t base)
+{
+	rp2040_piosm_cfg_field(&cfg->pinctrl, PIO_IN_BASE, base);
+}
+
+/* rp2040_piosm_cfg_sideset() - configure side-set
+ *
+ * nbits is the number of side-set data bits, as in ".side_set nbits [opt] [pindirs]".
+ * If the side-set is optional, the enable bit is added to the count.
+*/
+static inline void rp2040_piosm_cfg_sideset(rp2040_piosm_cfg_t *cfg, u32_t base, u32_t nbits,
+												boolean_t opt, boolean_t pindirs)
+{
+	rp2040_piosm_cfg_field(&cfg->pinctrl, PIO_SIDESET_BASE, base);
+	rp2040_piosm_cfg_field(&cfg->pinctrl, PIO_SIDESET_COUNT, opt ? nbits + 1 : nbits);
+	cfg->execctrl &= ~(PIO_SIDE_EN | PIO_SIDE_PINDIR);
+	if ( opt )
+		cfg->execctrl |= PIO_SIDE_EN;
+	if ( pindirs )
+		cfg->execctrl |= PIO_SIDE_PINDIR;
+}
+
+static inline void rp2040_piosm_cfg_jmp_pin(rp2040_piosm_cfg_t *cfg, u32_t pin)
+{
+	rp2040_piosm_cfg_field(&cfg->execctrl, PIO_JMP_PIN, pin);
+}
+
+/* rp2040_piosm_cfg_out_shift() - OSR shift direction, autopull and threshold (1..32)
+*/
+static inline void rp2040_piosm_cfg_out_shift(rp2040_piosm_cfg_t *cfg, boolean_t right, boolean_t autopull,
+												u32_t thresh)
+{
+	cfg->shiftctrl &= ~(PIO_OUT_SHIFTDIR | PIO_AUTOPULL);
+	if ( right )
+		cfg->shiftctrl |= PIO_OUT_SHIFTDIR;
+	if ( autopull )
+		cfg->shiftctrl |= PIO_AUTOPULL;
+	rp2040_piosm_cfg_field(&cfg->shiftctrl, PIO_PULL_THRESH, thresh & 0x1f);
+}
+
+/* rp2040_piosm_cfg_in_shift() - ISR shift direction, autopush and threshold (1..32)
+*/
+static inline void rp2040_piosm_cfg_in_shift(rp2040_piosm_cfg_t *cfg, boolean_t right, boolean_t autopush,
+												u32_t thresh)
+{
+	cfg->shiftctrl &= ~(PIO_IN_SHIFTDIR | PIO_AUTOPUSH);
+	if ( right )
+		cfg->shiftctrl |= PIO_IN_SHIFTDIR;
+	if ( autopush )
+		cfg->shiftctrl |= PIO_AUTOPUSH;
+	rp2040_piosm_cfg_field(&cfg->shiftctrl, PIO_PUSH_THRESH, thresh & 0x1f);
+}
+
+/* rp2040_piosm_cfg_fifo_join() - join the FIFOs
+ *
+ * join is PIO_FJOIN_NONE, PIO_FJOIN_TX (8-deep TX FIFO, no RX) or PIO_FJOIN_RX (8-deep RX, no TX)
+*/
+static inline void rp2040_piosm_cfg_fifo_join(rp2040_piosm_cfg_t *cfg, u32_t join)
+{
+	cfg->shiftctrl = (cfg->shiftctrl & ~(PIO_FJOIN_TX | PIO_FJOIN_RX)) | join;
+}
+
+/* rp2040_piosm_cfg_clkdiv() - set the clock divider directly (div_int + div_frac/256)
+*/
+static inline void rp2040_piosm_cfg_clkdiv(rp2040_piosm_cfg_t *cfg, u32_t div_int, u32_t div_frac)
+{
+	cfg->clkdiv = ((div_int << 16) & PIO_CLKDIV_INT) | ((div_frac << 8) & PIO_CLKDIV_FRAC);
+}
+
+extern int rp2040_piosm_cfg_freq(rp2040_piosm_cfg_t *cfg, u32_t hz);
+extern void rp2040_piosm_apply(rp2040_pio_t *pio, int sm, const rp2040_piosm_cfg_t *cfg, u32_t start_addr);
+extern void rp2040_pio_enable(rp2040_pio_t *pio, u32_t smmask);
+extern void rp2040_pio_disable(rp2040_pio_t *pio, u32_t smmask);
+extern int rp2040_pio_sm_set_freq(rp2040_pio_t *pio, int sm, u32_t hz);
 
 #endif
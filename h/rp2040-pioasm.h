@@ -0,0 +1,303 @@
+/* rp2040-pioasm.h - compile-time PIO assembler (C++ only)
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RP2040_PIOASM_H
+#define RP2040_PIOASM_H	1
+
+#ifndef __cplusplus
+#error "rp2040-pioasm.h needs a C++14 (or later) compiler"
+#endif
+
+extern "C" {
+#include "rp2040-types.h"
+#include "rp2040-pio.h"
+}
+
+/* This file lets you write a PIO program directly in a C++ source file. Everything is evaluated
+ * by the compiler, so there's no need for pioasm and there's no run-time cost: the result
+ * is an array of opcodes in .rodata, exactly as if you had pasted in the output of pioasm.
+ *
+ * The operands of each instruction are template parameters so that an out-of-range operand
+ * gives a static_assert error at compile time.
+ *
+ * Example (the "squarewave" program from the RP2040 datasheet):
+ *
+ *	using namespace rp2040_pioasm;
+ *	typedef encoder<> enc;
+ *
+ *	constexpr auto squarewave = assemble<enc>(
+ *		set<set_dst::pindirs, 1>(),
+ *		enc::delay<31>(set<set_dst::pins, 1>()),
+ *		enc::delay<30>(set<set_dst::pins, 0>()),
+ *		jmp<cond::always, 1>()
+ *	);
+ *
+ * The encoder<> type parameters are the side-set configuration (.side_set n [opt] [pindirs]).
+ * The side-set configuration determines how many bits are left for the delay field, so
+ * side-set values and delays must be added with the encoder that belongs to the program.
+ *
+ * Jump addresses are relative to the start of the program. They are relocated when the
+ * program is loaded (rp2040_pioasm::load()) or at compile time (rp2040_pioasm::relocate<>()).
+*/
+namespace rp2040_pioasm {
+
+typedef u16_t instr_t;
+
+/* Operand encodings. The names follow the pioasm syntax.
+*/
+enum class cond : u16_t
+{	always = 0, not_x = 1, x_dec = 2, not_y = 3, y_dec = 4, x_ne_y = 5, pin = 6, not_osre = 7
+};
+
+enum class wait_src : u16_t
+{	gpio = 0, pin = 1, irq = 2
+};
+
+enum class in_src : u16_t
+{	pins = 0, x = 1, y = 2, null = 3, isr = 6, osr = 7
+};
+
+enum class out_dst : u16_t
+{	pins = 0, x = 1, y = 2, null = 3, pindirs = 4, pc = 5, isr = 6, exec = 7
+};
+
+enum class mov_dst : u16_t
+{	pins = 0, x = 1, y = 2, exec = 4, pc = 5, isr = 6, osr = 7
+};
+
+enum class mov_op : u16_t
+{	none = 0, invert = 1, bitrev = 2
+};
+
+enum class mov_src : u16_t
+{	pins = 0, x = 1, y = 2, null = 3, status = 5, isr = 6, osr = 7
+};
+
+enum class irq_mode : u16_t
+{	set = 0x00, wait = 0x20, clear = 0x40
+};
+
+enum class set_dst : u16_t
+{	pins = 0, x = 1, y = 2, pindirs = 4
+};
+
+/* Instructions. Each function returns the opcode with the side-set/delay field set to zero.
+*/
+template <cond C, unsigned ADDR>
+constexpr instr_t jmp(void)
+{
+	static_assert(ADDR < 32, "jmp: address out of range (0..31)");
+	return instr_t(PIO_JMP | (u16_t(C) << 5) | ADDR);
+}
+
+template <unsigned POL, wait_src S, unsigned INDEX, bool REL = false>
+constexpr instr_t wait(void)
+{
+	static_assert(POL < 2, "wait: polarity must be 0 or 1");
+	static_assert(INDEX < 32, "wait: index out of range (0..31)");
+	static_assert(S != wait_src::irq || INDEX < 8, "wait: irq number out of range (0..7)");
+	static_assert(!REL || S == wait_src::irq, "wait: rel is only valid for irq");
+	return instr_t(PIO_WAIT | (POL << 7) | (u16_t(S) << 5) | (REL ? 0x10 : 0) | INDEX);
+}
+
+template <in_src S, unsigned BITS>
+constexpr instr_t in(void)
+{
+	static_assert(BITS >= 1 && BITS <= 32, "in: bit count out of range (1..32)");
+	return instr_t(PIO_IN | (u16_t(S) << 5) | (BITS & 0x1f));
+}
+
+template <out_dst D, unsigned BITS>
+constexpr instr_t out(void)
+{
+	static_assert(BITS >= 1 && BITS <= 32, "out: bit count out of range (1..32)");
+	return instr_t(PIO_OUT | (u16_t(D) << 5) | (BITS & 0x1f));
+}
+
+template <bool IFFULL = false, bool BLOCK = true>
+constexpr instr_t push(void)
+{
+	return instr_t(PIO_PUSH | (IFFULL ? 0x40 : 0) | (BLOCK ? 0x20 : 0));
+}
+
+template <bool IFEMPTY = false, bool BLOCK = true>
+constexpr instr_t pull(void)
+{
+	return instr_t(PIO_PULL | (IFEMPTY ? 0x40 : 0) | (BLOCK ? 0x20 : 0));
+}
+
+template <mov_dst D, mov_src S, mov_op OP = mov_op::none>
+constexpr instr_t mov(void)
+{
+	return instr_t(PIO_MOV | (u16_t(D) << 5) | (u16_t(OP) << 3) | u16_t(S));
+}
+
+template <irq_mode M, unsigned INDEX, bool REL = false>
+constexpr instr_t irq(void)
+{
+	static_assert(INDEX < 8, "irq: irq number out of range (0..7)");
+	return instr_t(PIO_IRQ | u16_t(M) | (REL ? 0x10 : 0) | INDEX);
+}
+
+template <set_dst D, unsigned VALUE>
+constexpr instr_t set(void)
+{
+	static_assert(VALUE < 32, "set: value out of range (0..31)");
+	return instr_t(PIO_SET | (u16_t(D) << 5) | VALUE);
+}
+
+/* nop is assembled as "mov y, y", the same as pioasm
+*/
+constexpr instr_t nop(void)
+{
+	return mov<mov_dst::y, mov_src::y>();
+}
+
+/* encoder<> - side-set and delay encoding for a program
+ *
+ * Bits 12..8 of every instruction are shared between the side-set value and the delay.
+ * The side-set value (plus the enable bit if side-set is optional) occupies the top bits.
+*/
+template <unsigned SIDESET_BITS = 0, bool SIDESET_OPT = false, bool SIDESET_PINDIRS = false>
+struct encoder
+{
+	static constexpr unsigned sideset_bits = SIDESET_BITS;
+	static constexpr bool sideset_opt = SIDESET_OPT;
+	static constexpr bool sideset_pindirs = SIDESET_PINDIRS;
+
+	/* Total width of the side-set field, including the enable bit
+	*/
+	static constexpr unsigned sideset_field = SIDESET_BITS + (SIDESET_OPT ? 1 : 0);
+	static_assert(sideset_field <= 5, "side_set: too many bits (max 5, including opt)");
+
+	static constexpr unsigned max_delay = (1u << (5 - sideset_field)) - 1;
+
+	template <unsigned D>
+	static constexpr instr_t delay(instr_t i)
+	{
+		static_assert(D <= max_delay, "delay out of range for this side-set configuration");
+		return instr_t(i | (D << 8));
+	}
+
+	template <unsigned S, unsigned D = 0>
+	static constexpr instr_t side(instr_t i)
+	{
+		static_assert(SIDESET_BITS > 0, "side: program has no side-set");
+		static_assert(S < (1u << SIDESET_BITS), "side: value out of range");
+		static_assert(D <= max_delay, "delay out of range for this side-set configuration");
+		return instr_t(i | (SIDESET_OPT ? 0x1000 : 0) | (S << (13 - sideset_field)) | (D << 8));
+	}
+};
+
+/* program<N> - an assembled program
+ *
+ * The wrap and wrap_target addresses are relative to the start of the program.
+*/
+template <unsigned N>
+struct program
+{
+	static_assert(N >= 1 && N <= 32, "program: length out of range (1..32)");
+
+	instr_t instr[N];
+	u8_t wrap_target;
+	u8_t wrap;
+	u8_t sideset_bits;		/* Includes the enable bit if side-set is optional */
+	u8_t sideset_flags;		/* Bit 1 = SIDE_EN, bit 0 = SIDE_PINDIR (EXECCTRL bits 30 and 29) */
+
+	static constexpr unsigned length = N;
+
+	/* execctrl() - the EXECCTRL bits for the wrap range and side-set options, for a given load offset
+	*/
+	constexpr u32_t execctrl(unsigned offset) const
+	{
+		return ((u32_t)(wrap + offset) << 12) | ((u32_t)(wrap_target + offset) << 7) |
+				((u32_t)sideset_flags << 29);
+	}
+
+	/* pinctrl() - the SIDESET_COUNT bits of PINCTRL
+	*/
+	constexpr u32_t pinctrl(void) const
+	{
+		return (u32_t)sideset_bits << 29;
+	}
+};
+
+/* assemble() - build a program from a list of instructions.
+ *
+ * ENC is the encoder<> that was used for the side-set and delay fields.
+ * Without WRAP_TARGET and WRAP the program wraps from the last instruction to the first.
+*/
+template <typename ENC, unsigned WRAP_TARGET, unsigned WRAP, typename... I>
+constexpr program<sizeof...(I)> assemble(I... instrs)
+{
+	static_assert(sizeof...(I) >= 1 && sizeof...(I) <= 32, "program: length out of range (1..32)");
+	static_assert(WRAP < sizeof...(I), "wrap: address is outside the program");
+	static_assert(WRAP_TARGET <= WRAP, "wrap_target: must not be after wrap");
+	return program<sizeof...(I)>
+	{	{ instr_t(instrs)... },
+		u8_t(WRAP_TARGET),
+		u8_t(WRAP),
+		u8_t(ENC::sideset_field),
+		u8_t((ENC::sideset_opt ? 0x2 : 0) | (ENC::sideset_pindirs ? 0x1 : 0))
+	};
+}
+
+template <typename ENC, typename... I>
+constexpr program<sizeof...(I)> assemble(I... instrs)
+{
+	return assemble<ENC, 0, sizeof...(I) - 1>(instrs...);
+}
+
+/* relocate_one() - relocate a single instruction. Only JMP has an absolute address.
+*/
+constexpr instr_t relocate_one(instr_t i, unsigned offset)
+{
+	return ( (i & 0xe000) == PIO_JMP ) ? instr_t((i & ~0x1fu) | ((i + offset) & 0x1f)) : i;
+}
+
+/* relocate<>() - relocate a program to a fixed offset at compile time.
+ *
+ * The wrap addresses are left relative, so execctrl() still needs the same offset.
+*/
+template <unsigned OFFSET, unsigned N>
+constexpr program<N> relocate(const program<N> &p)
+{
+	static_assert(OFFSET + N <= 32, "relocate: program doesn't fit at this offset");
+	program<N> r = p;
+	for ( unsigned i = 0; i < N; i++ )
+	{
+		r.instr[i] = relocate_one(p.instr[i], OFFSET);
+	}
+	return r;
+}
+
+/* load() - copy a program into a PIO's instruction memory at the given offset, relocating the jumps.
+*/
+template <unsigned N>
+inline void load(rp2040_pio_t *pio, const program<N> &p, unsigned offset)
+{
+	for ( unsigned i = 0; i < N; i++ )
+	{
+		pio->instr_mem[offset + i] = relocate_one(p.instr[i], offset);
+	}
+}
+
+}	/* namespace rp2040_pioasm */
+
+#endif
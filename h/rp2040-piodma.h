@@ -0,0 +1,85 @@
+/* rp2040-piodma.h - streaming between memory and PIO FIFOs using DMA
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RP2040_PIODMA_H
+#define RP2040_PIODMA_H	1
+
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-pio.h"
+#include "rp2040-dma.h"
+
+/* A PIO DMA stream connects a state machine's TX FIFO (memory to PIO) or RX FIFO (PIO to memory)
+ * to a buffer in memory. The DMA is paced by the state machine's DREQ, so the CPU doesn't have to do
+ * anything while the stream is running. Two modes are provided:
+ *
+ *	Ring:	One data channel and one control channel. The data channel transfers the buffer then
+ *			chains to the control channel, which writes the buffer address back into the data channel's
+ *			address trigger register. The buffer is repeated (TX) or overwritten (RX) endlessly.
+ *			Use this for a repetitive waveform or for a continuous logic-analyser capture that gets
+ *			stopped when something interesting happens.
+ *
+ *	Double:	Two data channels, each with its own buffer, chained to each other. While one channel is
+ *			transferring, the CPU fills (TX) or empties (RX) the other buffer. rp2040_piodma_poll()
+ *			reports each buffer as it completes.
+ *
+ * In both modes the gap between the end of one transfer and the start of the next is a few clk_sys
+ * cycles, which the FIFO (8 words deep if joined) absorbs.
+ *
+ * The rp2040_piodma_t structure is used by the DMA in ring mode, so it must remain valid (i.e. not
+ * be a local variable of a function that returns) until the stream has been stopped.
+ *
+ * The DMA controller must have been released from reset before starting a stream.
+*/
+typedef struct rp2040_piodma_s rp2040_piodma_t;
+
+struct rp2040_piodma_s
+{
+	u32_t addr[2];		/* Buffer address(es). The control channel reads addr[0] in ring mode */
+	u32_t nwords;		/* Length of each buffer in 32-bit words */
+	u8_t ch[2];			/* Ring: data channel, control channel. Double: channels for buffer 0, buffer 1 */
+	u8_t mode;			/* RP2040_PIODMA_RING or RP2040_PIODMA_DOUBLE */
+	u8_t dir;			/* RP2040_PIODMA_TX or RP2040_PIODMA_RX */
+};
+
+#define RP2040_PIODMA_RING		0
+#define RP2040_PIODMA_DOUBLE	1
+
+#define RP2040_PIODMA_TX		0		/* Memory to TX FIFO */
+#define RP2040_PIODMA_RX		1		/* RX FIFO to memory */
+
+/* rp2040_pio_dreq() - the DREQ number for a state machine's TX or RX FIFO
+*/
+static inline u32_t rp2040_pio_dreq(rp2040_pio_t *pio, int sm, int dir)
+{
+	u32_t dreq = (u32_t)sm + ((dir == RP2040_PIODMA_RX) ? DREQ_PIO0_RX0 : DREQ_PIO0_TX0);
+	if ( pio == &rp2040_pio1 )
+		dreq += DREQ_PIO1_TX0;
+	return dreq;
+}
+
+extern void rp2040_piodma_ring(rp2040_piodma_t *s, rp2040_pio_t *pio, int sm, int dir,
+								int ch_data, int ch_ctl, void *buf, u32_t nwords);
+extern void rp2040_piodma_double(rp2040_piodma_t *s, rp2040_pio_t *pio, int sm, int dir,
+								int ch0, int ch1, void *buf0, void *buf1, u32_t nwords);
+extern int rp2040_piodma_poll(rp2040_piodma_t *s);
+extern u32_t rp2040_piodma_position(rp2040_piodma_t *s);
+extern void rp2040_piodma_stop(rp2040_piodma_t *s);
+
+#endif
@@ -0,0 +1,118 @@
+/* rp2040-pllcalc.h - compile-time PLL parameter solver
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RP2040_PLLCALC_H
+#define RP2040_PLLCALC_H	1
+
+/* PLL parameter solver
+ *
+ * RP2040_PLL_SOLVE(ref, f) finds PLL settings that produce exactly f Hz from a reference of ref Hz:
+ *	VCO = ref / REFDIV * FBDIV			must be in the range 750 MHz to 1600 MHz
+ *	f   = VCO / (POSTDIV1 * POSTDIV2)	POSTDIV1 and POSTDIV2 are 1..7
+ *	ref / REFDIV						must be at least 5 MHz, so REFDIV is 1 or 2 for a 12 MHz crystal
+ *
+ * REFDIV 1 is tried before REFDIV 2. For each REFDIV the candidates are tried in order of decreasing
+ * VCO frequency (lower jitter), with POSTDIV1 >= POSTDIV2 (lower power). The result is encoded as REFDIV*100 + POSTDIV1*10 + POSTDIV2,
+ * or 0 if there is no solution. The result is a constant expression that can be used in #if, so that
+ * an unreachable frequency can be reported with #error; see rp2040-clocks.h.
+ *
+ * The products are calculated with 64 bits (1ULL), which is OK in #if and is folded by the compiler
+ * in C code, so there are no run-time library calls.
+*/
+#define RP2040_PLL_VCO_MIN		750000000
+#define RP2040_PLL_VCO_MAX		1600000000
+
+#define RP2040_PLL_VCO(f, p1, p2)	((f) * 1ULL * (p1) * (p2))
+
+#define RP2040_PLL_OK(ref, f, r, p1, p2) \
+	(	RP2040_PLL_VCO(f, p1, p2) >= RP2040_PLL_VCO_MIN && \
+		RP2040_PLL_VCO(f, p1, p2) <= RP2040_PLL_VCO_MAX && \
+		(RP2040_PLL_VCO(f, p1, p2) * (r)) % (ref) == 0 )
+
+#define RP2040_PLL_TRY(ref, f, r, p1, p2, next) \
+	( RP2040_PLL_OK(ref, f, r, p1, p2) ? ((r) * 100 + (p1) * 10 + (p2)) : (next) )
+
+#define RP2040_PLL_SOLVE(ref, f) \
+	RP2040_PLL_TRY(ref, f, 1, 7, 7, \
+	RP2040_PLL_TRY(ref, f, 1, 7, 6, \
+	RP2040_PLL_TRY(ref, f, 1, 6, 6, \
+	RP2040_PLL_TRY(ref, f, 1, 7, 5, \
+	RP2040_PLL_TRY(ref, f, 1, 6, 5, \
+	RP2040_PLL_TRY(ref, f, 1, 7, 4, \
+	RP2040_PLL_TRY(ref, f, 1, 5, 5, \
+	RP2040_PLL_TRY(ref, f, 1, 6, 4, \
+	RP2040_PLL_TRY(ref, f, 1, 7, 3, \
+	RP2040_PLL_TRY(ref, f, 1, 5, 4, \
+	RP2040_PLL_TRY(ref, f, 1, 6, 3, \
+	RP2040_PLL_TRY(ref, f, 1, 4, 4, \
+	RP2040_PLL_TRY(ref, f, 1, 5, 3, \
+	RP2040_PLL_TRY(ref, f, 1, 7, 2, \
+	RP2040_PLL_TRY(ref, f, 1, 6, 2, \
+	RP2040_PLL_TRY(ref, f, 1, 4, 3, \
+	RP2040_PLL_TRY(ref, f, 1, 5, 2, \
+	RP2040_PLL_TRY(ref, f, 1, 3, 3, \
+	RP2040_PLL_TRY(ref, f, 1, 4, 2, \
+	RP2040_PLL_TRY(ref, f, 1, 7, 1, \
+	RP2040_PLL_TRY(ref, f, 1, 6, 1, \
+	RP2040_PLL_TRY(ref, f, 1, 3, 2, \
+	RP2040_PLL_TRY(ref, f, 1, 5, 1, \
+	RP2040_PLL_TRY(ref, f, 1, 4, 1, \
+	RP2040_PLL_TRY(ref, f, 1, 2, 2, \
+	RP2040_PLL_TRY(ref, f, 1, 3, 1, \
+	RP2040_PLL_TRY(ref, f, 1, 2, 1, \
+	RP2040_PLL_TRY(ref, f, 1, 1, 1, \
+	RP2040_PLL_TRY(ref, f, 2, 7, 7, \
+	RP2040_PLL_TRY(ref, f, 2, 7, 6, \
+	RP2040_PLL_TRY(ref, f, 2, 6, 6, \
+	RP2040_PLL_TRY(ref, f, 2, 7, 5, \
+	RP2040_PLL_TRY(ref, f, 2, 6, 5, \
+	RP2040_PLL_TRY(ref, f, 2, 7, 4, \
+	RP2040_PLL_TRY(ref, f, 2, 5, 5, \
+	RP2040_PLL_TRY(ref, f, 2, 6, 4, \
+	RP2040_PLL_TRY(ref, f, 2, 7, 3, \
+	RP2040_PLL_TRY(ref, f, 2, 5, 4, \
+	RP2040_PLL_TRY(ref, f, 2, 6, 3, \
+	RP2040_PLL_TRY(ref, f, 2, 4, 4, \
+	RP2040_PLL_TRY(ref, f, 2, 5, 3, \
+	RP2040_PLL_TRY(ref, f, 2, 7, 2, \
+	RP2040_PLL_TRY(ref, f, 2, 6, 2, \
+	RP2040_PLL_TRY(ref, f, 2, 4, 3, \
+	RP2040_PLL_TRY(ref, f, 2, 5, 2, \
+	RP2040_PLL_TRY(ref, f, 2, 3, 3, \
+	RP2040_PLL_TRY(ref, f, 2, 4, 2, \
+	RP2040_PLL_TRY(ref, f, 2, 7, 1, \
+	RP2040_PLL_TRY(ref, f, 2, 6, 1, \
+	RP2040_PLL_TRY(ref, f, 2, 3, 2, \
+	RP2040_PLL_TRY(ref, f, 2, 5, 1, \
+	RP2040_PLL_TRY(ref, f, 2, 4, 1, \
+	RP2040_PLL_TRY(ref, f, 2, 2, 2, \
+	RP2040_PLL_TRY(ref, f, 2, 3, 1, \
+	RP2040_PLL_TRY(ref, f, 2, 2, 1, \
+	RP2040_PLL_TRY(ref, f, 2, 1, 1, \
+	0))))))))))))))))))))))))))))))))))))))))))))))))))))))))
+
+/* Decode the result of RP2040_PLL_SOLVE()
+*/
+#define RP2040_PLL_REFDIV_OF(s)			((s) / 100)
+#define RP2040_PLL_POSTDIV1_OF(s)		(((s) / 10) % 10)
+#define RP2040_PLL_POSTDIV2_OF(s)		((s) % 10)
+#define RP2040_PLL_FBDIV_OF(ref, f, s) \
+	(RP2040_PLL_VCO(f, RP2040_PLL_POSTDIV1_OF(s), RP2040_PLL_POSTDIV2_OF(s)) * RP2040_PLL_REFDIV_OF(s) / (ref))
+
+#endif
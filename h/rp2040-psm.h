@@ -0,0 +1,66 @@
+/* rp2040-psm.h - power-on state machine
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RP2040_PSM_H
+#define RP2040_PSM_H		1
+
+#include "rp2040.h"
+#include "rp2040-types.h"
+
+typedef struct rp2040_psm_s rp2040_psm_t;
+
+/* The power-on state machine sequences the resets of the core components.
+ * The wdsel register selects the components that are reset when the watchdog fires.
+*/
+struct rp2040_psm_s
+{
+	reg32_t	frce_on;		/* 0x00 - force a component out of reset */
+	reg32_t	frce_off;		/* 0x04 - force a component into reset */
+	reg32_t	wdsel;			/* 0x08 - components reset by the watchdog */
+	reg32_t	done;			/* 0x0c - components that are out of reset */
+};
+
+#define PSM_BASE			0x40010000
+#define rp2040_psm			(((rp2040_psm_t *)(PSM_BASE+RP2040_OFFSET_REG))[0])
+#define rp2040_psm_xor		(((rp2040_psm_t *)(PSM_BASE+RP2040_OFFSET_XOR))[0])
+#define rp2040_psm_w1s		(((rp2040_psm_t *)(PSM_BASE+RP2040_OFFSET_W1S))[0])
+#define rp2040_psm_w1c		(((rp2040_psm_t *)(PSM_BASE+RP2040_OFFSET_W1C))[0])
+
+/* Bits in the PSM registers
+*/
+#define PSM_proc1			0x00010000
+#define PSM_proc0			0x00008000
+#define PSM_sio				0x00004000
+#define PSM_vreg_and_chip_reset	0x00002000
+#define PSM_xip				0x00001000
+#define PSM_sram5			0x00000800
+#define PSM_sram4			0x00000400
+#define PSM_sram3			0x00000200
+#define PSM_sram2			0x00000100
+#define PSM_sram1			0x00000080
+#define PSM_sram0			0x00000040
+#define PSM_rom				0x00000020
+#define PSM_busfabric		0x00000010
+#define PSM_resets			0x00000008
+#define PSM_clocks			0x00000004
+#define PSM_xosc			0x00000002
+#define PSM_rosc			0x00000001
+#define PSM_all				0x0001ffff
+
+#endif
@@ -22,6 +22,7 @@
 
 #include "rp2040-types.h"
 #include "rp2040-gpio.h"
+#include "rp2040-cm0.h"
 
 /* RP2040 SIO - single-cycle I/O block
  *
@@ -97,6 +98,141 @@ typedef struct rp2040_sio_s
 #define SIO_FIFO_RDY	0x00000002	/* Tx FIFO is not full */
 #define SIO_FIFO_VLD	0x00000001	/* Rx FIFO is not empty */
 
+/* Divider status
+*/
+#define SIO_DIV_DIRTY	0x00000002	/* Dividend or divisor written since the quotient was last read */
+#define SIO_DIV_READY	0x00000001	/* Result is ready */
+
+/* rp2040_udiv() - unsigned 32-bit division using the SIO hardware divider
+ *
+ * There's no division instruction on the M0+ and this library doesn't link libgcc, so
+ * use this function wherever a division by a variable is needed.
+ *
+ * The divider is per-core but has no save/restore in the interrupt handlers, so interrupts
+ * are disabled for the ~8 cycles of the calculation.
+ * If rem is not 0, the remainder is stored there.
+*/
+static inline u32_t rp2040_udiv(u32_t dividend, u32_t divisor, u32_t *rem)
+{
+	intstatus_t is = disable();
+	rp2040_sio.div_udividend = dividend;
+	rp2040_sio.div_udivisor = divisor;
+	while ( (rp2040_sio.div_csr & SIO_DIV_READY) == 0 )
+	{
+		/* Wait */
+	}
+	u32_t r = rp2040_sio.div_remainder;		/* Read remainder first: reading quotient clears DIRTY */
+	u32_t q = rp2040_sio.div_quotient;
+	restore(is);
+
+	if ( rem != 0 )
+		*rem = r;
+	return q;
+}
+
+/* Output to a character sink
+ *
+ * Plain string and number printers for the reports (rp2040_irqprof_dump(), rp2040_bench_report()
+ * etc.) that don't need the whole of rp2040_printf(). putc is the same void (*putc)(char) sink.
+*/
+
+/* rp2040_puts() - print a string
+*/
+static inline void rp2040_puts(void (*putc)(char), const char *s)
+{
+	while ( *s != '\0' )
+		putc(*s++);
+}
+
+/* rp2040_putdec() - print an unsigned decimal number
+*/
+static inline void rp2040_putdec(void (*putc)(char), u32_t v)
+{
+	char str[10];
+	int n = 0;
+
+	do {
+		u32_t r;
+		v = rp2040_udiv(v, 10, &r);
+		str[n++] = (char)('0' + r);
+	} while ( v != 0 );
+
+	while ( n > 0 )
+		putc(str[--n]);
+}
+
+/* rp2040_putx32() - print a number as 8 hexadecimal digits
+*/
+static inline void rp2040_putx32(void (*putc)(char), u32_t v)
+{
+	for ( int i = 28; i >= 0; i -= 4 )
+		putc("0123456789abcdef"[(v >> i) & 0xf]);
+}
+
+/* Hardware spinlocks
+ *
+ * There are 32 spinlocks. Reading spinlock[n] claims the lock and returns non-zero if it was free;
+ * writing any value releases it. The library uses the ones listed here; the others are free for
+ * the application.
+*/
+#define RP2040_SPINLOCK_MEM		16		/* rp2040-mem.c: pools and arenas */
+#define RP2040_SPINLOCK_WATCHDOG	17		/* rp2040-watchdog.c: task registration */
+
+/* rp2040_spin_lock() - disable interrupts on the calling core and claim a spinlock
+ *
+ * Returns the previous interrupt status, for rp2040_spin_unlock(). Hold the lock for as short
+ * a time as possible: the other core spins until it's released.
+*/
+static inline intstatus_t rp2040_spin_lock(int n)
+{
+	intstatus_t is = disable();
+	while ( rp2040_sio.spinlock[n] == 0 )
+	{
+		/* Wait */
+	}
+	__asm__ volatile("dmb" : : : "memory");
+	return is;
+}
+
+/* rp2040_spin_unlock() - release a spinlock and restore the interrupt status
+*/
+static inline void rp2040_spin_unlock(int n, intstatus_t is)
+{
+	__asm__ volatile("dmb" : : : "memory");
+	rp2040_sio.spinlock[n] = 0;
+	restore(is);
+}
+
+/* GPIO pins
+ *
+ * The functions with a mask operate on all the pins whose bits are set, with a single store to the
+ * SIO (plus one write per pin to select the function in rp2040_pins_init()).
+*/
+
+/* rp2040_pins_init() - initialise a set of GPIO pins for input or output
+ *
+ * The outputs are initially low.
+*/
+static inline void rp2040_pins_init(u32_t mask, boolean_t output)
+{
+	/* Disable the SIO outputs and turn off.
+	*/
+	rp2040_sio.gpio_oe.w1c = mask;
+	rp2040_sio.gpio_out.w1c = mask;
+
+	/* Select SIO function for the pins.
+	*/
+	for ( u32_t m = mask; m != 0; m &= m - 1 )
+	{
+		rp2040_iobank0.gpio[cxm_lowest_bit(m)].ctrl = FUNCSEL_SIO;
+	}
+
+	if ( output )
+	{
+		rp2040_sio.gpio_oe.w1s = mask;
+	}
+}
+
 /* rp2040_pin_init() - initialise a GPIO pin for input or output
 */
 static inline void rp2040_pin_init(int pin, boolean_t output)
@@ -118,7 +254,97 @@ static inline void rp2040_pin_init(int pin, boolean_t output)
 	}
 }
 
-extern void rp2040_start_core1(void);
+/* rp2040_pins_set()/_clr()/_toggle() - drive a set of pins high, low or to the opposite level
+*/
+static inline void rp2040_pins_set(u32_t mask)
+{
+	rp2040_sio.gpio_out.w1s = mask;
+}
+
+static inline void rp2040_pins_clr(u32_t mask)
+{
+	rp2040_sio.gpio_out.w1c = mask;
+}
+
+static inline void rp2040_pins_toggle(u32_t mask)
+{
+	rp2040_sio.gpio_out.xor = mask;
+}
+
+/* rp2040_pins_read() - return the input levels of all the pins
+*/
+static inline u32_t rp2040_pins_read(void)
+{
+	return rp2040_sio.gpio_in;
+}
+
+/* rp2040_pins_put() - drive a set of pins to the levels given by the corresponding bits of value
+ *
+ * The pins change together in a single store to the xor register, so there are no intermediate
+ * states. The other pins aren't affected, even if they are changed by an interrupt handler or
+ * the other core between the read and the store.
+*/
+static inline void rp2040_pins_put(u32_t mask, u32_t value)
+{
+	rp2040_sio.gpio_out.xor = (rp2040_sio.gpio_out.val ^ value) & mask;
+}
+
+/* rp2040_pins_output()/_input() - enable or disable the outputs of a set of pins
+*/
+static inline void rp2040_pins_output(u32_t mask)
+{
+	rp2040_sio.gpio_oe.w1s = mask;
+}
+
+static inline void rp2040_pins_input(u32_t mask)
+{
+	rp2040_sio.gpio_oe.w1c = mask;
+}
+
+/* Parallel bus
+ *
+ * A group of contiguous pins that carry an N-bit value, e.g. the data lines of a parallel
+ * LCD or a latch. The value's bit 0 is on the first pin.
+*/
+typedef struct rp2040_bus_s
+{
+	u32_t shift;			/* First pin */
+	u32_t mask;				/* Pins of the bus */
+} rp2040_bus_t;
+
+/* rp2040_bus_init() - initialise a bus of width pins starting at first, and its pins
+ *
+ * Returns 0 if OK, -1 if the bus doesn't fit in GPIO0 to GPIO29. The bus is not initialised in
+ * that case.
+*/
+static inline int rp2040_bus_init(rp2040_bus_t *bus, int first, int width, boolean_t output)
+{
+	if ( first < 0 || width < 1 || width > 30 - first )
+		return -1;
+
+	bus->shift = (u32_t)first;
+	bus->mask = (0xffffffffu >> (32 - width)) << first;
+	rp2040_pins_init(bus->mask, output);
+	return 0;
+}
+
+/* rp2040_bus_write() - drive a value onto a bus
+ *
+ * All the pins change at the same time. Bits of the value above the width of the bus are ignored.
+*/
+static inline void rp2040_bus_write(const rp2040_bus_t *bus, u32_t value)
+{
+	rp2040_pins_put(bus->mask, value << bus->shift);
+}
+
+/* rp2040_bus_read() - return the value on a bus
+*/
+static inline u32_t rp2040_bus_read(const rp2040_bus_t *bus)
+{
+	return (rp2040_sio.gpio_in & bus->mask) >> bus->shift;
+}
+
+extern int rp2040_start_core1(void);
 
 #endif
 
@@ -0,0 +1,69 @@
+/* rp2040-softirq.h - deferred work on software-triggered IRQs
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RP2040_SOFTIRQ_H
+#define RP2040_SOFTIRQ_H	1
+
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-nvic.h"
+
+/* Deferred work ("bottom halves")
+ *
+ * IRQs 26 to 31 have no hardware source. Each one can be set up as a soft IRQ with a priority of its own.
+ * An interrupt handler does the minimum work needed to silence its device, then posts a work item to a
+ * soft IRQ with rp2040_work_post(). The work function runs when no higher-priority handler is active,
+ * so the latency of the high-priority IRQs is bounded by the short top halves rather than by the
+ * complete processing.
+ *
+ * Work items are caller-allocated (typically static), so posting never fails for lack of memory.
+ * A work item that is already queued is not queued again: the work function must process everything
+ * that has accumulated since it was posted. Work items run in the order in which they were posted.
+ *
+ * The NVIC is per core, so the queues are per core too: work posted on a core runs on that core.
+ * Each core must call rp2040_softirq_init() for each soft IRQ that it uses.
+ *
+ * Requires RP2040_RAM_VECTORS, because the dispatcher is installed with rp2040_irq_set_handler().
+*/
+typedef struct rp2040_work_s rp2040_work_t;
+typedef void (*rp2040_workfunc_t)(rp2040_work_t *w);
+
+struct rp2040_work_s
+{
+	rp2040_work_t *next;		/* Queue link; private */
+	rp2040_workfunc_t fn;		/* Function to call */
+	volatile u8_t queued;		/* Non-zero while the item is in a queue; private */
+};
+
+#define RP2040_SOFTIRQ_FIRST	irq_26
+#define RP2040_SOFTIRQ_N		6
+
+/* rp2040_work_init() - initialise a work item
+*/
+static inline void rp2040_work_init(rp2040_work_t *w, rp2040_workfunc_t fn)
+{
+	w->next = 0;
+	w->fn = fn;
+	w->queued = 0;
+}
+
+extern int rp2040_softirq_init(irqid_t irq, u32_t prio);
+extern boolean_t rp2040_work_post(irqid_t irq, rp2040_work_t *w);
+
+#endif
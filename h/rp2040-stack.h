@@ -0,0 +1,122 @@
+/* rp2040-stack.h - stack painting and high-water marks
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RP2040_STACK_H
+#define RP2040_STACK_H	1
+
+#include "rp2040.h"
+#include "rp2040-types.h"
+#include "rp2040-cm0.h"
+
+/* Stack painting
+ *
+ * Each core has a main stack (MSP: exceptions and interrupts) and a process stack (PSP: main() or main1()).
+ * The linker scripts define the limits of each stack: rp2040_stackbase <= MSP < rp2040_stacktop, etc.
+ *
+ * With RP2040_STACK_PAINT (default 1), rp2040_kickstart() fills the process stacks of both cores with
+ * RP2040_STACK_PATTERN by DMA while the PLLs start, and fills its own main stack up to the current SP
+ * just before calling main(). rp2040_kickstart1() does the same for core 1's main stack. The high-water
+ * mark of a stack is then the distance from the top to the lowest word that no longer holds the pattern.
+ * The main stack's mark includes the stack used during the boot.
+ *
+ * A thread's stack can be painted with rp2040_stack_paint() before the thread starts and checked with
+ * rp2040_stack_used().
+ *
+ * The mark is a lower bound: a function that reserves stack space without writing to it isn't seen.
+ * See host/stackrep.c for a static worst-case analysis.
+*/
+#ifndef RP2040_STACK_PAINT
+#define RP2040_STACK_PAINT		1
+#endif
+
+#define RP2040_STACK_PATTERN	0xdeadbeef
+
+extern u32_t rp2040_stackbase[], rp2040_stacktop[];			/* Core 0 main stack */
+extern u32_t rp2040_pstackbase[], rp2040_pstacktop[];		/* Core 0 process stack */
+extern u32_t rp2040_stackbase1[], rp2040_stacktop1[];		/* Core 1 main stack */
+extern u32_t rp2040_pstackbase1[], rp2040_pstacktop1[];		/* Core 1 process stack */
+
+/* rp2040_stack_paint() - fill a stack that isn't in use with the pattern
+*/
+static inline void rp2040_stack_paint(u32_t *base, u32_t *top)
+{
+	while ( base < top )
+		*base++ = RP2040_STACK_PATTERN;
+}
+
+/* rp2040_stack_paint_to_sp() - fill the current stack with the pattern, from base up to the SP
+ *
+ * Everything below the SP is free, so the caller's stack is safe. Interrupts must be disabled.
+ * The loop doesn't call rp2040_stack_paint(): without optimisation that would be a call, and its
+ * frame would be below the SP.
+*/
+static inline void rp2040_stack_paint_to_sp(u32_t *base)
+{
+	/* Cast via uintptr_t so that the header is also clean on 64-bit hosts. __UINTPTR_TYPE__ is the
+	 * compiler's own definition, which doesn't need the C library's headers.
+	*/
+	u32_t *sp = (u32_t *)(__UINTPTR_TYPE__)cxm_get_sp();
+
+	while ( base < sp )
+		*base++ = RP2040_STACK_PATTERN;
+}
+
+/* rp2040_stack_used() - return the high-water mark of a painted stack in bytes
+*/
+static inline u32_t rp2040_stack_used(const u32_t *base, const u32_t *top)
+{
+	const u32_t *p = base;
+
+	while ( p < top && *p == RP2040_STACK_PATTERN )
+		p++;
+
+	return (u32_t)(top - p) * sizeof(u32_t);
+}
+
+/* rp2040_msp_size(), rp2040_psp_size() - return the size of a core's main or process stack in bytes
+*/
+static inline u32_t rp2040_msp_size(int core)
+{
+	return (core == 0) ? (u32_t)((u8_t *)rp2040_stacktop - (u8_t *)rp2040_stackbase)
+					   : (u32_t)((u8_t *)rp2040_stacktop1 - (u8_t *)rp2040_stackbase1);
+}
+
+static inline u32_t rp2040_psp_size(int core)
+{
+	return (core == 0) ? (u32_t)((u8_t *)rp2040_pstacktop - (u8_t *)rp2040_pstackbase)
+					   : (u32_t)((u8_t *)rp2040_pstacktop1 - (u8_t *)rp2040_pstackbase1);
+}
+
+/* rp2040_msp_used(), rp2040_psp_used() - return the high-water mark of a core's main or process stack
+*/
+static inline u32_t rp2040_msp_used(int core)
+{
+	return (core == 0) ? rp2040_stack_used(rp2040_stackbase, rp2040_stacktop)
+					   : rp2040_stack_used(rp2040_stackbase1, rp2040_stacktop1);
+}
+
+static inline u32_t rp2040_psp_used(int core)
+{
+	return (core == 0) ? rp2040_stack_used(rp2040_pstackbase, rp2040_pstacktop)
+					   : rp2040_stack_used(rp2040_pstackbase1, rp2040_pstacktop1);
+}
+
+extern void rp2040_stack_report(void (*putc)(char));
+
+#endif
@@ -0,0 +1,59 @@
+/* rp2040-startup.h - startup and boot profile
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RP2040_STARTUP_H
+#define RP2040_STARTUP_H	1
+
+#include "rp2040.h"
+#include "rp2040-types.h"
+
+/* USB PLL
+ *
+ * rp2040_kickstart() only starts the USB PLL (clk_usb and clk_adc) if RP2040_USBPLL is set.
+ * Programs that use USB or the ADC either define it or call rp2040_usbpll_init() themselves.
+*/
+#ifndef RP2040_USBPLL
+#define RP2040_USBPLL	0
+#endif
+
+/* Boot profile
+ *
+ * rp2040_kickstart() records the time in microseconds at the end of each phase of the boot,
+ * measured from the moment that the timer starts (i.e. just after the XOSC is stable). The time
+ * spent in the boot ROM and waiting for the XOSC isn't included. If the XOSC fails to start,
+ * the times are meaningless.
+ *
+ * The .bss is cleared by DMA while the PLLs start, so RP2040_BOOT_BSS is usually the same as
+ * RP2040_BOOT_USBPLL.
+ *
+ * The clock check before RP2040_BOOT_VERIFY measures two clocks (four with RP2040_USBPLL), each for
+ * 2^RP2040_FC0_INTERVAL us (64 us by default) plus the frequency counter's start-up.
+*/
+#define RP2040_BOOT_PLL		0	/* System PLL locked and selected */
+#define RP2040_BOOT_USBPLL	1	/* USB PLL locked (if RP2040_USBPLL) */
+#define RP2040_BOOT_BSS		2	/* .bss cleared */
+#define RP2040_BOOT_VERIFY	3	/* Clock frequencies checked (if RP2040_CLK_VERIFY) */
+#define RP2040_BOOT_MAIN	4	/* About to call main() */
+#define RP2040_BOOT_NPHASE	5
+
+extern u32_t rp2040_boot_time[RP2040_BOOT_NPHASE];
+
+extern void rp2040_kickstart(void);
+
+#endif
@@ -22,6 +22,8 @@
 
 #include "rp2040.h"
 #include "rp2040-types.h"
+#include "rp2040-psm.h"
+#include "rp2040-timer.h"
 
 typedef struct rp2040_watchdog_s rp2040_watchdog_t;
 
@@ -51,6 +53,15 @@ struct rp2040_watchdog_s
 
 #define WATCHDOG_TRIGGER	0x80000000
 #define WATCHDOG_ENABLED	0x40000000
+#define WATCHDOG_PAUSE_DBG1	0x04000000	/* Pause while core 1 is halted by the debugger */
+#define WATCHDOG_PAUSE_DBG0	0x02000000	/* Pause while core 0 is halted by the debugger */
+#define WATCHDOG_PAUSE_JTAG	0x01000000	/* Pause while JTAG is active */
+#define WATCHDOG_TIME		0x00ffffff	/* Remaining count (read only) */
+
+/* Bits in the reason register. Both are 0 after a power-on or RUN pin reset.
+*/
+#define WATCHDOG_REASON_FORCE	0x00000002	/* Triggered by software */
+#define WATCHDOG_REASON_TIMER	0x00000001	/* The watchdog timer expired */
 
 static inline void rp2040_watchdog_disable(void)
 {
@@ -59,6 +70,71 @@ static inline void rp2040_watchdog_disable(void)
 	rp2040_watchdog_w1c.ctrl = WATCHDOG_ENABLED;
 }
 
+/* The components that the watchdog resets: everything except the oscillators, so the reboot doesn't
+ * wait for the XOSC to start. The scratch registers survive.
+*/
+#define RP2040_WATCHDOG_WDSEL	(PSM_all & ~(PSM_rosc | PSM_xosc))
+
+/* rp2040_watchdog_reboot() - reset the chip immediately
+*/
+static inline void rp2040_watchdog_reboot(void)
+{
+	rp2040_psm.wdsel = RP2040_WATCHDOG_WDSEL;
+	rp2040_watchdog_w1s.ctrl = WATCHDOG_TRIGGER;
+
+	for (;;)
+	{
+		/* Wait */
+	}
+}
+
+/* Watchdog service
+ *
+ * Each task that must be supervised registers with rp2040_watchdog_register(), giving the longest
+ * time between check-ins in microseconds, and then calls rp2040_watchdog_checkin() at least that
+ * often. The tasks can be on either core. rp2040_watchdog_start() starts the hardware watchdog.
+ * rp2040_watchdog_service() must then be called regularly (more often than the watchdog timeout)
+ * by one core, e.g. from its idle loop or a timer interrupt. It feeds the watchdog only if every task
+ * has checked in within its period, so a stalled task or core results in a reset even if the
+ * idle loop still runs.
+ *
+ * When a task misses its deadline the service records the task's number and how long ago it
+ * last checked in in the scratch registers, stops feeding the watchdog and returns the task's number
+ * from then on. rp2040_kickstart() reads the record back into rp2040_reset_info (see rp2040-crash.h).
+ *	scratch[0]	RP2040_WATCHDOG_MAGIC | task
+ *	scratch[1]	time since the last check-in, in us
+ *
+ * The counter decrements twice per microsecond tick (erratum RP2040-E1), so the timeout
+ * is at most RP2040_WATCHDOG_MAX_US.
+*/
+#ifndef RP2040_WATCHDOG_MAXTASK
+#define RP2040_WATCHDOG_MAXTASK	8
+#endif
+
+#define RP2040_WATCHDOG_MAX_US	(WATCHDOG_TIME / 2)
+#define RP2040_WATCHDOG_MAGIC	0xd1000000
+
+typedef struct rp2040_wdtask_s rp2040_wdtask_t;
+
+struct rp2040_wdtask_s
+{
+	volatile u32_t checkin;		/* Time of the last check-in */
+	u32_t period;				/* Longest allowed time between check-ins */
+};
+
+extern rp2040_wdtask_t rp2040_wdtask[RP2040_WATCHDOG_MAXTASK];
+
+/* rp2040_watchdog_checkin() - report that a task is still alive
+*/
+static inline void rp2040_watchdog_checkin(int task)
+{
+	rp2040_wdtask[task].checkin = rp2040_timer.time_lraw;
+}
+
+extern int rp2040_watchdog_register(u32_t period);
+extern void rp2040_watchdog_start(u32_t timeout, boolean_t pause_dbg);
+extern int rp2040_watchdog_service(void);
+
 static inline void rp2040_tick_init(void)
 {
 	rp2040_watchdog.tick = 0;					/* Clear out the old stuff */
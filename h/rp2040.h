@@ -67,5 +67,21 @@ struct rp2040_intcs_s
 	reg32_t ints;	/* 0x0c Interrupt status after mask and force */
 };
 
+/* Functions marked with RP2040_TIME_CRITICAL are placed in the .time_critical section. When the program
+ * runs from flash (ld/rp2040-flash.ldscript) they are copied to RAM at startup, so they don't suffer
+ * from XIP cache misses. Use it for interrupt handlers and other code with tight timing.
+ * They must not be called before init_vars() has run.
+*/
+#define RP2040_TIME_CRITICAL	__attribute__((section(".time_critical")))
+
+/* RP2040_SRAM_BANK(n) places a variable in a single SRAM bank (see the linker scripts):
+ *	n = 0..3: the top 8 KiB of SRAMn, through the non-striped alias. For large DMA buffers, so that
+ *			  the DMA doesn't compete with the processors for the striped RAM.
+ *	n = 4, 5: the 4 KiB scratch banks, below core 0's and core 1's main stacks. For data that is
+ *			  used by that core's interrupt handlers.
+ * These sections are not initialised at startup, so the variables must not have initialisers.
+*/
+#define RP2040_SRAM_BANK(n)		__attribute__((section(".sram" #n)))
+
 
 #endif
@@ -0,0 +1,124 @@
+/* boot2crc.c - pad the second-stage boot loader and add the boot ROM checksum
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Intended to be compiled on the host system (gcc).
+ *
+ * Usage: boot2crc <input.bin> <output.S>
+ *	Reads the raw boot2 code (at most 252 bytes), pads it with zeros to 252 bytes and writes an assembler
+ *	file containing the 256-byte .boot2 section, with the CRC32 in the last 4 bytes.
+ *
+ * Usage: boot2crc -t
+ *	Checks the CRC function with the standard check value and prints "Pass".
+ *
+ * The boot ROM's CRC32 is the big-endian (MSB-first) variant with polynomial 0x04c11db7, initial value
+ * 0xffffffff and no final inversion (CRC-32/MPEG-2). It covers the first 252 bytes.
+*/
+#include <stdio.h>
+#include <string.h>
+#include "host-types.h"
+
+#define BOOT2_SIZE		256
+#define BOOT2_CODESIZE	(BOOT2_SIZE - 4)
+
+/* crc32_mpeg2() - calculate the CRC
+*/
+static u32_t crc32_mpeg2(const u8_t *data, int len)
+{
+	u32_t crc = 0xffffffff;
+
+	for ( int i = 0; i < len; i++ )
+	{
+		crc ^= (u32_t)data[i] << 24;
+		for ( int b = 0; b < 8; b++ )
+			crc = (crc & 0x80000000) ? ((crc << 1) ^ 0x04c11db7) : (crc << 1);
+	}
+	return crc;
+}
+
+static int self_test(void)
+{
+	const char *check = "123456789";
+	u32_t crc = crc32_mpeg2((const u8_t *)check, (int)strlen(check));
+
+	if ( crc != 0x0376e6e7 )
+	{
+		printf("Fail: crc32_mpeg2(\"%s\") = 0x%08x, expected 0x0376e6e7\n", check, crc);
+		return 1;
+	}
+	printf("Pass\n");
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	u8_t image[BOOT2_SIZE];
+	FILE *f;
+	size_t n;
+	u32_t crc;
+
+	if ( argc == 2 && strcmp(argv[1], "-t") == 0 )
+		return self_test();
+
+	if ( argc != 3 )
+	{
+		fprintf(stderr, "Usage: boot2crc <input.bin> <output.S>\n       boot2crc -t\n");
+		return 1;
+	}
+
+	f = fopen(argv[1], "rb");
+	if ( f == NULL )
+	{
+		fprintf(stderr, "boot2crc: can't open %s\n", argv[1]);
+		return 1;
+	}
+	memset(image, 0, sizeof(image));
+	n = fread(image, 1, sizeof(image), f);
+	fclose(f);
+
+	if ( n > BOOT2_CODESIZE )
+	{
+		fprintf(stderr, "boot2crc: %s is too big (%u bytes, max %u)\n", argv[1], (unsigned)n, BOOT2_CODESIZE);
+		return 1;
+	}
+
+	crc = crc32_mpeg2(image, BOOT2_CODESIZE);
+	image[BOOT2_CODESIZE+0] = (u8_t)(crc);
+	image[BOOT2_CODESIZE+1] = (u8_t)(crc >> 8);
+	image[BOOT2_CODESIZE+2] = (u8_t)(crc >> 16);
+	image[BOOT2_CODESIZE+3] = (u8_t)(crc >> 24);
+
+	f = fopen(argv[2], "w");
+	if ( f == NULL )
+	{
+		fprintf(stderr, "boot2crc: can't create %s\n", argv[2]);
+		return 1;
+	}
+
+	fprintf(f, "/* Generated by boot2crc from %s - do not edit\n*/\n", argv[1]);
+	fprintf(f, "\t.section\t.boot2, \"ax\"\n");
+	for ( int i = 0; i < BOOT2_SIZE; i += 16 )
+	{
+		fprintf(f, "\t.byte\t");
+		for ( int j = 0; j < 16; j++ )
+			fprintf(f, "0x%02x%s", image[i+j], (j == 15) ? "\n" : ", ");
+	}
+	fclose(f);
+	return 0;
+}
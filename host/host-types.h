@@ -0,0 +1,45 @@
+/* host-types.h - rp2040-types.h replacement for programs that run on the host
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef HOST_TYPES_H
+#define HOST_TYPES_H	1
+
+/* Inhibit inclusion of rp2040-types.h and define our own for the host. Assumes a 64-bit host.
+ * Include this file before any of the files from h/
+*/
+#define RP2040_TYPES_H		1
+
+typedef unsigned char u8_t;
+typedef unsigned short u16_t;
+typedef unsigned int u32_t;
+typedef unsigned long u64_t;
+
+typedef signed char s8_t;
+typedef signed short s16_t;
+typedef signed int s32_t;
+typedef signed long s64_t;
+
+typedef volatile u8_t reg8_t;
+typedef volatile u16_t reg16_t;
+typedef volatile u32_t reg32_t;
+typedef volatile u64_t reg64_t;
+
+typedef int boolean_t;
+
+#endif
@@ -0,0 +1,401 @@
+/* logdecode.c - decoder for the binary log
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Intended to be compiled on the host system (gcc).
+ *
+ * Usage: logdecode <program.elf> [<capture>]
+ *	Reads the output of rp2040_log_poll() or rp2040_log_flush() (see rp2040-log.h) from the capture file
+ *	or from stdin (e.g. a serial port) and prints one line per record:
+ *		<core> <timestamp in microseconds>: <formatted message>
+ *	The format strings come from the .rp2040_log section of the ELF file, the strings for %s from its
+ *	loaded sections. Bytes that aren't part of a record (e.g. text from dh_puts()) are copied as they are.
+ *
+ * Usage: logdecode -t
+ *	Decodes a built-in example and prints "Pass".
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host-types.h"
+
+#define LOG_SYNC		0xa5
+#define LOG_DROPPED		0xffff
+#define LOG_MAXARG		4
+#define LOG_MAXFRAME	(1 + 1 + 2 + 4 + 4 * LOG_MAXARG + 1)
+#define MAXSECT			64
+
+/* The parts of the ELF file that are needed
+*/
+typedef struct sect_s
+{
+	u32_t addr;
+	u32_t size;
+	const u8_t *data;
+} sect_t;
+
+static const u8_t *log_strings;
+static u32_t log_size;
+static sect_t sect[MAXSECT];
+static int n_sect;
+
+static u32_t get16(const u8_t *p)
+{
+	return (u32_t)p[0] | ((u32_t)p[1] << 8);
+}
+
+static u32_t get32(const u8_t *p)
+{
+	return get16(p) | (get16(p + 2) << 16);
+}
+
+/* read_elf() - find the log strings and the loaded sections in a 32-bit little-endian ELF file
+*/
+static int read_elf(const u8_t *elf, size_t len)
+{
+	if ( len < 0x34 || memcmp(elf, "\177ELF", 4) != 0 || elf[4] != 1 || elf[5] != 1 )
+		return -1;
+
+	u32_t shoff = get32(elf + 0x20);
+	u32_t shentsize = get16(elf + 0x2e);
+	u32_t shnum = get16(elf + 0x30);
+	u32_t shstrndx = get16(elf + 0x32);
+
+	if ( shoff + shnum * shentsize > len || shstrndx >= shnum )
+		return -1;
+
+	const u8_t *shstr = elf + get32(elf + shoff + shstrndx * shentsize + 16);
+
+	for ( u32_t i = 0; i < shnum; i++ )
+	{
+		const u8_t *sh = elf + shoff + i * shentsize;
+		const char *name = (const char *)shstr + get32(sh);
+		u32_t type = get32(sh + 4);
+		u32_t flags = get32(sh + 8);
+		u32_t off = get32(sh + 16);
+		u32_t size = get32(sh + 20);
+
+		if ( type != 1 || off + size > len )		/* SHT_PROGBITS only */
+			continue;
+
+		if ( strcmp(name, ".rp2040_log") == 0 )
+		{
+			log_strings = elf + off;
+			log_size = size;
+		}
+		else if ( (flags & 0x2) != 0 && n_sect < MAXSECT )		/* SHF_ALLOC */
+		{
+			sect[n_sect].addr = get32(sh + 12);
+			sect[n_sect].size = size;
+			sect[n_sect].data = elf + off;
+			n_sect++;
+		}
+	}
+	return 0;
+}
+
+/* target_string() - find a string constant in the program
+*/
+static const char *target_string(u32_t addr)
+{
+	for ( int i = 0; i < n_sect; i++ )
+	{
+		if ( addr >= sect[i].addr && addr < sect[i].addr + sect[i].size &&
+			 memchr(sect[i].data + (addr - sect[i].addr), '\0', sect[i].addr + sect[i].size - addr) != NULL )
+			return (const char *)sect[i].data + (addr - sect[i].addr);
+	}
+	return NULL;
+}
+
+/* print_msg() - format a message with the host's printf, one conversion at a time
+*/
+static void print_msg(FILE *out, const char *fmt, const u32_t *arg, int n)
+{
+	int a = 0;
+
+	while ( *fmt != '\0' )
+	{
+		if ( *fmt != '%' )
+		{
+			fputc(*fmt++, out);
+			continue;
+		}
+
+		char spec[16];
+		int len = (int)strspn(fmt + 1, "-0123456789*l") + 2;
+
+		if ( len >= (int)sizeof(spec) || fmt[len-1] == '\0' )
+		{
+			fputs(fmt, out);
+			return;
+		}
+		memcpy(spec, fmt, (size_t)len);
+		spec[len] = '\0';
+		fmt += len;
+
+		char conv = spec[len-1];
+		u32_t v = (a < n) ? arg[a] : 0;
+
+		if ( conv == '%' )
+		{
+			fputc('%', out);
+			continue;
+		}
+		if ( strchr(spec, '*') != NULL || strstr(spec, "ll") != NULL )
+		{
+			fprintf(out, "<%s unsupported>", spec);
+			a++;
+			continue;
+		}
+
+		/* Drop the 'l': the host's long may be 64 bits
+		*/
+		char *l = strchr(spec, 'l');
+		if ( l != NULL )
+			memmove(l, l + 1, strlen(l));
+
+		switch ( conv )
+		{
+		case 'd':
+		case 'i':
+			fprintf(out, spec, (int)v);
+			break;
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'c':
+			fprintf(out, spec, v);
+			break;
+		case 'p':
+			fprintf(out, "0x%08x", v);
+			break;
+		case 's':
+			{
+				const char *s = target_string(v);
+				if ( s != NULL )
+					fprintf(out, spec, s);
+				else
+					fprintf(out, "<0x%08x>", v);
+			}
+			break;
+		default:
+			fputs(spec, out);
+			continue;
+		}
+		a++;
+	}
+}
+
+/* decode_frame() - print a complete, checked frame
+*/
+static void decode_frame(FILE *out, const u8_t *f)
+{
+	int core = f[1] >> 7;
+	int n = f[1] & 0x7f;
+	u32_t id = get16(f + 2);
+	u32_t ts = get32(f + 4);
+	u32_t arg[LOG_MAXARG];
+
+	for ( int i = 0; i < n; i++ )
+		arg[i] = get32(f + 8 + 4 * i);
+
+	fprintf(out, "%d %10u: ", core, ts);
+	if ( id == LOG_DROPPED )
+		fprintf(out, "<%u records dropped>", arg[0]);
+	else if ( id < log_size && memchr(log_strings + id, '\0', log_size - id) != NULL )
+		print_msg(out, (const char *)log_strings + id, arg, n);
+	else
+		fprintf(out, "<unknown message 0x%04x>", id);
+	fputc('\n', out);
+}
+
+/* decode() - decode a stream
+ *
+ * The decoder collects a frame from each sync byte. If the frame is malformed, its first byte is
+ * printed and the search for a sync byte continues after it.
+*/
+typedef struct decoder_s
+{
+	u8_t frame[LOG_MAXFRAME];
+	int len;
+} decoder_t;
+
+static int frame_length(const u8_t *f)
+{
+	int n = f[1] & 0x7f;
+	return (n > LOG_MAXARG) ? -1 : (1 + 1 + 2 + 4 + 4 * n + 1);
+}
+
+static void decode_byte(FILE *out, decoder_t *d, u8_t c)
+{
+	if ( d->len == 0 )
+	{
+		if ( c == LOG_SYNC )
+			d->frame[d->len++] = c;
+		else
+			fputc(c, out);
+		return;
+	}
+
+	d->frame[d->len++] = c;
+	if ( d->len < 2 )
+		return;
+
+	int flen = frame_length(d->frame);
+	if ( flen > 0 && d->len < flen )
+		return;
+
+	u8_t sum = 0;
+	for ( int i = 1; flen > 0 && i < flen; i++ )
+		sum ^= d->frame[i];
+
+	if ( flen > 0 && sum == 0 )
+	{
+		decode_frame(out, d->frame);
+		d->len = 0;
+		return;
+	}
+
+	/* Not a frame: resynchronise after the false sync byte
+	*/
+	u8_t rest[LOG_MAXFRAME];
+	int n = d->len - 1;
+
+	memcpy(rest, &d->frame[1], (size_t)n);
+	fputc(d->frame[0], out);
+	d->len = 0;
+	for ( int i = 0; i < n; i++ )
+		decode_byte(out, d, rest[i]);
+}
+
+/* self_test() - decode two records, a drop report and some text
+*/
+static const u8_t test_strings[] = "hello\0t=%d x=%04x %s\0";
+static const u8_t test_rodata[] = "world";
+
+static int self_test(void)
+{
+	u8_t stream[64];
+	int n = 0;
+	char *text;
+	size_t len;
+	decoder_t d = { { 0 }, 0 };
+	FILE *out = open_memstream(&text, &len);
+	static const char expect[] =
+		"Hi\n"
+		"0          7: hello\n"
+		"1     100000: t=-5 x=00ab world\n"
+		"0        200: <3 records dropped>\n";
+
+	log_strings = test_strings;
+	log_size = sizeof(test_strings);
+	sect[0].addr = 0x10001000;
+	sect[0].size = sizeof(test_rodata);
+	sect[0].data = test_rodata;
+	n_sect = 1;
+
+	memcpy(stream, "Hi\n", 3);
+	n = 3;
+
+	const u8_t rec1[] = { 0xa5, 0x00, 0x00, 0x00, 7, 0, 0, 0, 0 };
+	const u8_t rec2[] = { 0xa5, 0x83, 0x06, 0x00, 0xa0, 0x86, 0x01, 0x00,
+						  0xfb, 0xff, 0xff, 0xff, 0xab, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x10, 0 };
+	const u8_t rec3[] = { 0xa5, 0x01, 0xff, 0xff, 200, 0, 0, 0, 3, 0, 0, 0, 0 };
+	const u8_t *rec[3] = { rec1, rec2, rec3 };
+	const int rlen[3] = { sizeof(rec1), sizeof(rec2), sizeof(rec3) };
+
+	for ( int r = 0; r < 3; r++ )
+	{
+		u8_t sum = 0;
+		memcpy(&stream[n], rec[r], (size_t)rlen[r]);
+		for ( int i = 1; i < rlen[r] - 1; i++ )
+			sum ^= rec[r][i];
+		stream[n + rlen[r] - 1] = sum;
+		n += rlen[r];
+	}
+
+	for ( int i = 0; i < n; i++ )
+		decode_byte(out, &d, stream[i]);
+	fclose(out);
+
+	if ( strcmp(text, expect) != 0 )
+	{
+		printf("Fail: got\n%sexpected\n%s", text, expect);
+		free(text);
+		return 1;
+	}
+	free(text);
+	printf("Pass\n");
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	FILE *f;
+	u8_t *elf;
+	long len;
+	decoder_t d = { { 0 }, 0 };
+	int c;
+
+	if ( argc == 2 && strcmp(argv[1], "-t") == 0 )
+		return self_test();
+
+	if ( argc != 2 && argc != 3 )
+	{
+		fprintf(stderr, "Usage: logdecode <program.elf> [<capture>]\n       logdecode -t\n");
+		return 1;
+	}
+
+	f = fopen(argv[1], "rb");
+	if ( f == NULL )
+	{
+		fprintf(stderr, "logdecode: can't open %s\n", argv[1]);
+		return 1;
+	}
+	fseek(f, 0, SEEK_END);
+	len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	elf = malloc((size_t)len);
+	if ( elf == NULL || fread(elf, 1, (size_t)len, f) != (size_t)len || read_elf(elf, (size_t)len) != 0 )
+	{
+		fprintf(stderr, "logdecode: %s isn't a 32-bit little-endian ELF file\n", argv[1]);
+		return 1;
+	}
+	fclose(f);
+
+	if ( log_strings == NULL )
+		fprintf(stderr, "logdecode: %s has no .rp2040_log section\n", argv[1]);
+
+	f = stdin;
+	if ( argc == 3 )
+	{
+		f = fopen(argv[2], "rb");
+		if ( f == NULL )
+		{
+			fprintf(stderr, "logdecode: can't open %s\n", argv[2]);
+			return 1;
+		}
+	}
+
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	while ( (c = fgetc(f)) != EOF )
+		decode_byte(stdout, &d, (u8_t)c);
+
+	return 0;
+}
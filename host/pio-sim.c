@@ -0,0 +1,803 @@
+/* pio-sim.c - cycle-level PIO simulator for the host
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <string.h>
+#include "host-types.h"
+#include "rp2040-pio.h"
+#include "pio-sim.h"
+
+/* Result of executing an instruction
+*/
+#define EXEC_NEXT		0		/* Done; advance the PC (with wrap) */
+#define EXEC_JUMP		1		/* Done; the PC has been set */
+#define EXEC_EXEC		2		/* Done; an instruction has been queued for execution. Ignore the delay */
+#define EXEC_STALL		3		/* Not done; try again on the next SM cycle */
+
+/* FDEBUG flags
+*/
+#define FDEBUG_TXSTALL(sm)	(0x01000000 << (sm))
+#define FDEBUG_TXOVER(sm)	(0x00010000 << (sm))
+#define FDEBUG_RXUNDER(sm)	(0x00000100 << (sm))
+#define FDEBUG_RXSTALL(sm)	(0x00000001 << (sm))
+
+static void sm_tick(piosim_t *sim, int n);
+static int sm_execute(piosim_t *sim, int n, u16_t instr);
+static void vcd_sample(piosim_t *sim);
+
+/* field() - extract a register field given its mask
+*/
+static u32_t field(u32_t reg, u32_t mask)
+{
+	return (reg & mask) >> __builtin_ctz(mask);
+}
+
+/* thresh() - decode a shift threshold (0 means 32)
+*/
+static u32_t thresh(u32_t reg, u32_t mask)
+{
+	u32_t t = field(reg, mask);
+	return (t == 0) ? 32 : t;
+}
+
+static u32_t fifo_depth(piosim_sm_t *s, u32_t join)
+{
+	u32_t j = s->cfg.shiftctrl & (PIO_FJOIN_TX | PIO_FJOIN_RX);
+	if ( j == 0 )
+		return 4;
+	return (j == join) ? 8 : 0;
+}
+
+static u32_t rotr(u32_t v, u32_t n)
+{
+	n &= 31;
+	return (n == 0) ? v : ((v >> n) | (v << (32 - n)));
+}
+
+static u32_t bitrev(u32_t v)
+{
+	u32_t r = 0;
+	for ( int i = 0; i < 32; i++ )
+	{
+		r = (r << 1) | (v & 1);
+		v >>= 1;
+	}
+	return r;
+}
+
+/* pins_write() - write count bits of data to the pins starting at base (wrapping at 32)
+*/
+static void pins_write(u32_t *reg, u32_t base, u32_t count, u32_t data)
+{
+	for ( u32_t i = 0; i < count; i++ )
+	{
+		u32_t m = 1u << ((base + i) & 31);
+		if ( (data >> i) & 1 )
+			*reg |= m;
+		else
+			*reg &= ~m;
+	}
+}
+
+/* piosim_init() - initialise a simulated PIO block. All state machines are disabled.
+*/
+void piosim_init(piosim_t *sim, u32_t clk_hz)
+{
+	memset(sim, 0, sizeof(*sim));
+	sim->clk_hz = clk_hz;
+	for ( int i = 0; i < PIOSIM_NSM; i++ )
+	{
+		rp2040_piosm_cfg_init(&sim->sm[i].cfg);
+		sim->sm[i].osr_count = 32;
+	}
+}
+
+/* piosim_load() - copy a program into instruction memory at offset, relocating the jumps
+ *
+ * Jump addresses in pioasm output are relative to the start of the program.
+*/
+void piosim_load(piosim_t *sim, const u16_t *prog, u32_t len, u32_t offset)
+{
+	for ( u32_t i = 0; i < len; i++ )
+	{
+		u16_t instr = prog[i];
+		if ( (instr & 0xe000) == PIO_JMP )
+			instr = (instr & ~0x1f) | ((instr + offset) & 0x1f);
+		sim->instr_mem[(offset + i) & 31] = instr;
+	}
+}
+
+/* piosim_configure() - the equivalent of rp2040_piosm_apply()
+ *
+ * The state machine is disabled, configured and restarted at start_addr with empty FIFOs.
+*/
+void piosim_configure(piosim_t *sim, int sm, const rp2040_piosm_cfg_t *cfg, u32_t start_addr)
+{
+	piosim_sm_t *s = &sim->sm[sm];
+
+	memset(s, 0, sizeof(*s));
+	s->cfg = *cfg;
+	s->pc = start_addr & 31;
+	s->osr_count = 32;
+	sim->fdebug &= ~(FDEBUG_TXSTALL(sm) | FDEBUG_TXOVER(sm) | FDEBUG_RXUNDER(sm) | FDEBUG_RXSTALL(sm));
+}
+
+/* piosim_enable() - enable state machines (one bit per SM). The clock dividers are restarted.
+ *
+ * The divider accumulator starts one step short of the divisor so that an SM runs in the first cycle.
+*/
+void piosim_enable(piosim_t *sim, u32_t smmask)
+{
+	for ( int i = 0; i < PIOSIM_NSM; i++ )
+	{
+		if ( (smmask >> i) & 1 )
+		{
+			piosim_sm_t *s = &sim->sm[i];
+			u32_t div = s->cfg.clkdiv >> 8;
+			if ( div < 0x100 )
+				div += 0x1000000;		/* INT == 0 means 65536 */
+			s->div_acc = div - 0x100;
+			s->enabled = 1;
+		}
+	}
+}
+
+void piosim_disable(piosim_t *sim, u32_t smmask)
+{
+	for ( int i = 0; i < PIOSIM_NSM; i++ )
+	{
+		if ( (smmask >> i) & 1 )
+			sim->sm[i].enabled = 0;
+	}
+}
+
+/* piosim_tx_put() - write to a TX FIFO, as the CPU or DMA would
+ *
+ * Returns 0 if OK, -1 if the FIFO is full (and sets TXOVER, as the hardware does)
+*/
+int piosim_tx_put(piosim_t *sim, int sm, u32_t v)
+{
+	piosim_sm_t *s = &sim->sm[sm];
+	u32_t depth = fifo_depth(s, PIO_FJOIN_TX);
+
+	if ( s->tx_level >= depth )
+	{
+		sim->fdebug |= FDEBUG_TXOVER(sm);
+		return -1;
+	}
+	s->txf[(s->tx_rd + s->tx_level) % PIOSIM_FIFO_MAX] = v;
+	s->tx_level++;
+	return 0;
+}
+
+/* piosim_rx_get() - read from an RX FIFO, as the CPU or DMA would
+ *
+ * Returns 0 if OK, -1 if the FIFO is empty (and sets RXUNDER, as the hardware does)
+*/
+int piosim_rx_get(piosim_t *sim, int sm, u32_t *v)
+{
+	piosim_sm_t *s = &sim->sm[sm];
+
+	if ( s->rx_level == 0 )
+	{
+		sim->fdebug |= FDEBUG_RXUNDER(sm);
+		return -1;
+	}
+	*v = s->rxf[s->rx_rd];
+	s->rx_rd = (s->rx_rd + 1) % PIOSIM_FIFO_MAX;
+	s->rx_level--;
+	return 0;
+}
+
+static boolean_t tx_pop(piosim_sm_t *s, u32_t *v)
+{
+	if ( s->tx_level == 0 )
+		return 0;
+	*v = s->txf[s->tx_rd];
+	s->tx_rd = (s->tx_rd + 1) % PIOSIM_FIFO_MAX;
+	s->tx_level--;
+	return 1;
+}
+
+static boolean_t rx_push(piosim_sm_t *s, u32_t v)
+{
+	if ( s->rx_level >= fifo_depth(s, PIO_FJOIN_RX) )
+		return 0;
+	s->rxf[(s->rx_rd + s->rx_level) % PIOSIM_FIFO_MAX] = v;
+	s->rx_level++;
+	return 1;
+}
+
+/* piosim_set_inputs() - drive the pins in mask to the values in val from outside the PIO
+*/
+void piosim_set_inputs(piosim_t *sim, u32_t mask, u32_t val)
+{
+	sim->pins_ext = (sim->pins_ext & ~mask) | (val & mask);
+}
+
+/* piosim_force_oe() - force the output enable on for the pins in mask
+ *
+ * This is the equivalent of OEOVER_ENABLE in the GPIO control register, as used in test/pio.
+*/
+void piosim_force_oe(piosim_t *sim, u32_t mask)
+{
+	sim->oe_force = mask;
+}
+
+/* piosim_pins() - the state of the pins: PIO output where enabled, external input elsewhere
+*/
+u32_t piosim_pins(piosim_t *sim)
+{
+	u32_t oe = sim->pad_oe | sim->oe_force;
+	return (sim->pad_out & oe) | (sim->pins_ext & ~oe);
+}
+
+/* piosim_step() - simulate one clk_sys cycle
+*/
+void piosim_step(piosim_t *sim)
+{
+	for ( int i = 0; i < PIOSIM_NSM; i++ )
+	{
+		piosim_sm_t *s = &sim->sm[i];
+
+		if ( s->enabled )
+		{
+			u32_t div = s->cfg.clkdiv >> 8;
+			if ( div < 0x100 )
+				div += 0x1000000;
+
+			s->div_acc += 0x100;
+			if ( s->div_acc >= div )
+			{
+				s->div_acc -= div;
+				sm_tick(sim, i);
+			}
+		}
+	}
+	vcd_sample(sim);
+	sim->cycle++;
+}
+
+void piosim_run(piosim_t *sim, u64_t ncycles)
+{
+	while ( ncycles-- > 0 )
+		piosim_step(sim);
+}
+
+/* piosim_run_until() - run until (pins & mask) == val
+ *
+ * Returns the number of cycles simulated, or max if the condition was not met.
+ * Use this to measure pulse widths and edge timing.
+*/
+u64_t piosim_run_until(piosim_t *sim, u32_t mask, u32_t val, u64_t max)
+{
+	u64_t n = 0;
+
+	while ( n < max && (piosim_pins(sim) & mask) != val )
+	{
+		piosim_step(sim);
+		n++;
+	}
+	return n;
+}
+
+/* sm_tick() - one cycle of a state machine (i.e. a clock-enable from its divider)
+ *
+ * The side-set is asserted as soon as an instruction is issued, even if it then stalls.
+ * The delay starts when the instruction completes.
+*/
+static void sm_tick(piosim_t *sim, int n)
+{
+	piosim_sm_t *s = &sim->sm[n];
+
+	s->n_ticks++;
+
+	if ( s->delay > 0 )
+	{
+		s->delay--;
+		return;
+	}
+
+	boolean_t is_exec = s->exec_pending;
+	u16_t instr = is_exec ? s->exec_instr : sim->instr_mem[s->pc];
+	s->exec_pending = 0;
+
+	/* Side-set and delay share bits 12..8. The side-set (including the enable bit if optional)
+	 * is at the top.
+	*/
+	u32_t ss_count = field(s->cfg.pinctrl, PIO_SIDESET_COUNT);
+	u32_t dfield = (instr >> 8) & 0x1f;
+	u32_t delay_bits = (ss_count > 5) ? 0 : 5 - ss_count;
+	u32_t delay = dfield & ((1u << delay_bits) - 1);
+
+	if ( ss_count > 0 )
+	{
+		u32_t ss = dfield >> delay_bits;
+		u32_t nbits = ss_count;
+		boolean_t apply = 1;
+
+		if ( (s->cfg.execctrl & PIO_SIDE_EN) != 0 )
+		{
+			nbits--;
+			apply = (ss >> nbits) & 1;
+			ss &= (1u << nbits) - 1;
+		}
+
+		if ( apply )
+		{
+			u32_t base = field(s->cfg.pinctrl, PIO_SIDESET_BASE);
+			if ( (s->cfg.execctrl & PIO_SIDE_PINDIR) != 0 )
+				pins_write(&sim->pad_oe, base, nbits, ss);
+			else
+				pins_write(&sim->pad_out, base, nbits, ss);
+		}
+	}
+
+	int r = sm_execute(sim, n, instr);
+
+	if ( r == EXEC_STALL )
+	{
+		s->exec_pending = is_exec;
+		s->n_stall++;
+		return;
+	}
+
+	s->n_instr++;
+
+	/* An instruction from EXEC doesn't advance the PC: that was done by the OUT/MOV that supplied it.
+	*/
+	if ( r == EXEC_NEXT && !is_exec )
+	{
+		if ( s->pc == field(s->cfg.execctrl, PIO_WRAP_TOP) )
+			s->pc = field(s->cfg.execctrl, PIO_WRAP_BOTTOM);
+		else
+			s->pc = (s->pc + 1) & 31;
+	}
+	else
+	if ( r == EXEC_EXEC )
+	{
+		/* OUT EXEC and MOV EXEC advance the PC but ignore their own delay.
+		*/
+		if ( s->pc == field(s->cfg.execctrl, PIO_WRAP_TOP) )
+			s->pc = field(s->cfg.execctrl, PIO_WRAP_BOTTOM);
+		else
+			s->pc = (s->pc + 1) & 31;
+		delay = 0;
+	}
+
+	s->delay = delay;
+}
+
+/* read_pins() - the pin state rotated so that IN_BASE is bit 0
+*/
+static u32_t read_pins(piosim_t *sim, piosim_sm_t *s)
+{
+	return rotr(piosim_pins(sim), field(s->cfg.pinctrl, PIO_IN_BASE));
+}
+
+/* irq_index() - decode the IRQ index of WAIT IRQ and IRQ, including the REL bit
+*/
+static u32_t irq_index(u16_t instr, int sm)
+{
+	u32_t idx = instr & 0x07;
+	if ( (instr & 0x10) != 0 )
+		idx = (idx & 0x4) | ((idx + (u32_t)sm) & 0x3);
+	return idx;
+}
+
+static void stall_tx(piosim_t *sim, piosim_sm_t *s, int n)
+{
+	s->n_txstall++;
+	sim->fdebug |= FDEBUG_TXSTALL(n);
+}
+
+static void stall_rx(piosim_t *sim, piosim_sm_t *s, int n)
+{
+	s->n_rxstall++;
+	sim->fdebug |= FDEBUG_RXSTALL(n);
+}
+
+/* osr_shift() - shift nbits out of the OSR
+*/
+static u32_t osr_shift(piosim_sm_t *s, u32_t nbits)
+{
+	u32_t data;
+
+	if ( nbits == 32 )
+	{
+		data = s->osr;
+		s->osr = 0;
+	}
+	else
+	if ( (s->cfg.shiftctrl & PIO_OUT_SHIFTDIR) != 0 )
+	{
+		data = s->osr & ((1u << nbits) - 1);
+		s->osr >>= nbits;
+	}
+	else
+	{
+		data = s->osr >> (32 - nbits);
+		s->osr <<= nbits;
+	}
+	s->osr_count = (s->osr_count + nbits > 32) ? 32 : s->osr_count + nbits;
+	return data;
+}
+
+/* isr_shift() - shift nbits of data into the ISR
+*/
+static void isr_shift(piosim_sm_t *s, u32_t data, u32_t nbits)
+{
+	if ( nbits == 32 )
+		s->isr = data;
+	else
+	{
+		data &= (1u << nbits) - 1;
+		if ( (s->cfg.shiftctrl & PIO_IN_SHIFTDIR) != 0 )
+			s->isr = (s->isr >> nbits) | (data << (32 - nbits));
+		else
+			s->isr = (s->isr << nbits) | data;
+	}
+	s->isr_count = (s->isr_count + nbits > 32) ? 32 : s->isr_count + nbits;
+}
+
+static void set_pc(piosim_sm_t *s, u32_t addr)
+{
+	s->pc = addr & 31;
+}
+
+/* sm_execute() - execute one instruction
+*/
+static int sm_execute(piosim_t *sim, int n, u16_t instr)
+{
+	piosim_sm_t *s = &sim->sm[n];
+	u32_t pull_thresh = thresh(s->cfg.shiftctrl, PIO_PULL_THRESH);
+	u32_t push_thresh = thresh(s->cfg.shiftctrl, PIO_PUSH_THRESH);
+	boolean_t autopull = (s->cfg.shiftctrl & PIO_AUTOPULL) != 0;
+	boolean_t autopush = (s->cfg.shiftctrl & PIO_AUTOPUSH) != 0;
+	u32_t op = (instr >> 5) & 0x7;
+	u32_t bits = instr & 0x1f;
+	u32_t v = 0;
+
+	switch ( instr & 0xe000 )
+	{
+	case PIO_JMP:
+		{
+			boolean_t take = 0;
+			switch ( op )
+			{
+			case 0:	take = 1;							break;
+			case 1:	take = (s->x == 0);					break;
+			case 2:	take = (s->x != 0);	s->x--;			break;
+			case 3:	take = (s->y == 0);					break;
+			case 4:	take = (s->y != 0);	s->y--;			break;
+			case 5:	take = (s->x != s->y);				break;
+			case 6:	take = (piosim_pins(sim) >> field(s->cfg.execctrl, PIO_JMP_PIN)) & 1;	break;
+			case 7:	take = (s->osr_count < pull_thresh);	break;
+			}
+			if ( take )
+			{
+				set_pc(s, bits);
+				return EXEC_JUMP;
+			}
+			return EXEC_NEXT;
+		}
+
+	case PIO_WAIT:
+		{
+			u32_t pol = (instr >> 7) & 1;
+			u32_t idx = bits;
+			u32_t src = op & 0x3;
+			u32_t state;
+
+			if ( src == 0 )
+				state = (piosim_pins(sim) >> idx) & 1;
+			else
+			if ( src == 1 )
+				state = (read_pins(sim, s) >> idx) & 1;
+			else
+			{
+				idx = irq_index(instr, n);
+				state = (sim->irq >> idx) & 1;
+			}
+
+			if ( state != pol )
+				return EXEC_STALL;
+
+			if ( src == 2 && pol == 1 )
+				sim->irq &= ~(1u << idx);		/* WAIT 1 IRQ clears the flag */
+			return EXEC_NEXT;
+		}
+
+	case PIO_IN:
+		if ( !s->in_done )
+		{
+			u32_t nbits = (bits == 0) ? 32 : bits;
+			switch ( op )
+			{
+			case 0:	v = read_pins(sim, s);	break;
+			case 1:	v = s->x;				break;
+			case 2:	v = s->y;				break;
+			case 6:	v = s->isr;				break;
+			case 7:	v = s->osr;				break;
+			default: v = 0;					break;
+			}
+			isr_shift(s, v, nbits);
+			s->in_done = 1;
+		}
+		if ( autopush && s->isr_count >= push_thresh )
+		{
+			if ( !rx_push(s, s->isr) )
+			{
+				stall_rx(sim, s, n);
+				return EXEC_STALL;
+			}
+			s->isr = 0;
+			s->isr_count = 0;
+		}
+		s->in_done = 0;
+		return EXEC_NEXT;
+
+	case PIO_OUT:
+		{
+			u32_t nbits = (bits == 0) ? 32 : bits;
+
+			if ( autopull && s->osr_count >= pull_thresh )
+			{
+				if ( !tx_pop(s, &s->osr) )
+				{
+					stall_tx(sim, s, n);
+					return EXEC_STALL;
+				}
+				s->osr_count = 0;
+			}
+
+			v = osr_shift(s, nbits);
+
+			/* The autopull refill happens in the background when the threshold is reached.
+			*/
+			if ( autopull && s->osr_count >= pull_thresh && tx_pop(s, &s->osr) )
+				s->osr_count = 0;
+
+			switch ( op )
+			{
+			case 0:	pins_write(&sim->pad_out, field(s->cfg.pinctrl, PIO_OUT_BASE), nbits, v);	break;
+			case 1:	s->x = v;	break;
+			case 2:	s->y = v;	break;
+			case 3:				break;
+			case 4:	pins_write(&sim->pad_oe, field(s->cfg.pinctrl, PIO_OUT_BASE), nbits, v);	break;
+			case 5:	set_pc(s, v);	return EXEC_JUMP;
+			case 6:	s->isr = v;	s->isr_count = nbits;	break;
+			case 7:	s->exec_instr = (u16_t)v;	s->exec_pending = 1;	return EXEC_EXEC;
+			}
+			return EXEC_NEXT;
+		}
+
+	case PIO_PUSH:		/* Also PULL: bit 7 distinguishes */
+		if ( (instr & 0x0080) == 0 )
+		{
+			boolean_t iffull = (instr & 0x40) != 0;
+			boolean_t block = (instr & 0x20) != 0;
+
+			if ( iffull && s->isr_count < push_thresh )
+				return EXEC_NEXT;
+
+			if ( !rx_push(s, s->isr) )
+			{
+				if ( block )
+				{
+					stall_rx(sim, s, n);
+					return EXEC_STALL;
+				}
+			}
+			s->isr = 0;
+			s->isr_count = 0;
+			return EXEC_NEXT;
+		}
+		else
+		{
+			boolean_t ifempty = (instr & 0x40) != 0;
+			boolean_t block = (instr & 0x20) != 0;
+
+			if ( ifempty && s->osr_count < pull_thresh )
+				return EXEC_NEXT;
+			if ( autopull && s->osr_count < pull_thresh )
+				return EXEC_NEXT;		/* PULL is a no-op when autopull has already filled the OSR */
+
+			if ( !tx_pop(s, &s->osr) )
+			{
+				if ( block )
+				{
+					stall_tx(sim, s, n);
+					return EXEC_STALL;
+				}
+				s->osr = s->x;			/* Non-blocking PULL from an empty FIFO copies X */
+			}
+			s->osr_count = 0;
+			return EXEC_NEXT;
+		}
+
+	case PIO_MOV:
+		{
+			u32_t src = instr & 0x7;
+			u32_t mop = (instr >> 3) & 0x3;
+
+			switch ( src )
+			{
+			case 0:	v = read_pins(sim, s);	break;
+			case 1:	v = s->x;				break;
+			case 2:	v = s->y;				break;
+			case 3:	v = 0;					break;
+			case 5:
+				{
+					u32_t level = ((s->cfg.execctrl & PIO_STATUS_SEL) != 0) ? s->rx_level : s->tx_level;
+					v = (level < field(s->cfg.execctrl, PIO_STATUS_N)) ? 0xffffffff : 0;
+				}
+				break;
+			case 6:	v = s->isr;				break;
+			case 7:	v = s->osr;				break;
+			default: v = 0;					break;
+			}
+
+			if ( mop == 1 )
+				v = ~v;
+			else
+			if ( mop == 2 )
+				v = bitrev(v);
+
+			switch ( op )
+			{
+			case 0:	pins_write(&sim->pad_out, field(s->cfg.pinctrl, PIO_OUT_BASE),
+								field(s->cfg.pinctrl, PIO_OUT_COUNT), v);	break;
+			case 1:	s->x = v;	break;
+			case 2:	s->y = v;	break;
+			case 4:	s->exec_instr = (u16_t)v;	s->exec_pending = 1;	return EXEC_EXEC;
+			case 5:	set_pc(s, v);	return EXEC_JUMP;
+			case 6:	s->isr = v;	s->isr_count = 0;	break;
+			case 7:	s->osr = v;	s->osr_count = 0;	break;
+			}
+			return EXEC_NEXT;
+		}
+
+	case PIO_IRQ:
+		{
+			u32_t mask = 1u << irq_index(instr, n);
+
+			if ( s->irq_waiting )
+			{
+				if ( (sim->irq & mask) != 0 )
+					return EXEC_STALL;
+				s->irq_waiting = 0;
+				return EXEC_NEXT;
+			}
+
+			if ( (instr & 0x40) != 0 )
+			{
+				sim->irq &= ~mask;
+				return EXEC_NEXT;
+			}
+
+			sim->irq |= mask;
+			if ( (instr & 0x20) != 0 )
+			{
+				s->irq_waiting = 1;
+				return EXEC_STALL;
+			}
+			return EXEC_NEXT;
+		}
+
+	case PIO_SET:
+		switch ( op )
+		{
+		case 0:	pins_write(&sim->pad_out, field(s->cfg.pinctrl, PIO_SET_BASE),
+							field(s->cfg.pinctrl, PIO_SET_COUNT), bits);	break;
+		case 1:	s->x = bits;	break;
+		case 2:	s->y = bits;	break;
+		case 4:	pins_write(&sim->pad_oe, field(s->cfg.pinctrl, PIO_SET_BASE),
+							field(s->cfg.pinctrl, PIO_SET_COUNT), bits);	break;
+		}
+		return EXEC_NEXT;
+	}
+
+	return EXEC_NEXT;
+}
+
+/* piosim_vcd_open() - start writing a VCD trace of the given pins and the four program counters
+ *
+ * Returns 0 if OK, -1 if the file can't be created.
+*/
+int piosim_vcd_open(piosim_t *sim, const char *filename, u32_t pins)
+{
+	sim->vcd = fopen(filename, "w");
+	if ( sim->vcd == NULL )
+		return -1;
+
+	sim->vcd_pins = pins;
+	sim->vcd_started = 0;
+
+	fprintf(sim->vcd, "$timescale 1 ps $end\n");
+	fprintf(sim->vcd, "$scope module pio $end\n");
+	for ( int i = 0; i < 32; i++ )
+	{
+		if ( (pins >> i) & 1 )
+			fprintf(sim->vcd, "$var wire 1 g%d gpio%d $end\n", i, i);
+	}
+	for ( int i = 0; i < PIOSIM_NSM; i++ )
+	{
+		fprintf(sim->vcd, "$var wire 5 p%d sm%d_pc $end\n", i, i);
+	}
+	fprintf(sim->vcd, "$upscope $end\n");
+	fprintf(sim->vcd, "$enddefinitions $end\n");
+	return 0;
+}
+
+void piosim_vcd_close(piosim_t *sim)
+{
+	if ( sim->vcd != NULL )
+	{
+		fclose(sim->vcd);
+		sim->vcd = NULL;
+	}
+}
+
+static void vcd_pc(FILE *f, int sm, u32_t pc)
+{
+	char b[6];
+	for ( int i = 0; i < 5; i++ )
+		b[i] = ((pc >> (4 - i)) & 1) ? '1' : '0';
+	b[5] = '\0';
+	fprintf(f, "b%s p%d\n", b, sm);
+}
+
+/* vcd_sample() - write the changes since the last sample
+*/
+static void vcd_sample(piosim_t *sim)
+{
+	if ( sim->vcd == NULL )
+		return;
+
+	u32_t pins = piosim_pins(sim) & sim->vcd_pins;
+	u32_t changed = sim->vcd_started ? (pins ^ sim->vcd_last_pins) : sim->vcd_pins;
+	boolean_t pc_changed = !sim->vcd_started;
+
+	for ( int i = 0; i < PIOSIM_NSM; i++ )
+	{
+		if ( sim->sm[i].pc != sim->vcd_last_pc[i] )
+			pc_changed = 1;
+	}
+
+	if ( changed == 0 && !pc_changed )
+		return;
+
+	fprintf(sim->vcd, "#%llu\n", (unsigned long long)((double)sim->cycle * 1.0e12 / (double)sim->clk_hz));
+
+	for ( int i = 0; i < 32; i++ )
+	{
+		if ( (changed >> i) & 1 )
+			fprintf(sim->vcd, "%dg%d\n", (pins >> i) & 1, i);
+	}
+	for ( int i = 0; i < PIOSIM_NSM; i++ )
+	{
+		if ( !sim->vcd_started || sim->sm[i].pc != sim->vcd_last_pc[i] )
+			vcd_pc(sim->vcd, i, sim->sm[i].pc);
+		sim->vcd_last_pc[i] = sim->sm[i].pc;
+	}
+
+	sim->vcd_last_pins = pins;
+	sim->vcd_started = 1;
+}
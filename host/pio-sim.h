@@ -0,0 +1,123 @@
+/* pio-sim.h - cycle-level PIO simulator for the host
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef PIO_SIM_H
+#define PIO_SIM_H	1
+
+#include <stdio.h>
+#include "host-types.h"
+#include "rp2040-pio.h"
+
+/* The simulator models one PIO block (four state machines, 32 instructions) at clk_sys cycle resolution:
+ *	- all nine instructions, including side-set, delay, EXEC (OUT/MOV), relative IRQs and MOV STATUS
+ *	- TX and RX FIFOs (4 deep, or 8 with FJOIN), autopull, autopush and the shift thresholds
+ *	- the fractional clock divider (as an accumulator, so the average rate is exact)
+ *	- pin output values and directions, and externally driven inputs
+ *	- stall statistics and the sticky FDEBUG flags, for detecting FIFO starvation
+ *
+ * The state machines are configured with the same rp2040_piosm_cfg_t that rp2040_piosm_apply() uses
+ * on the target, so a driver's configuration code can be shared between target and host.
+ *
+ * Pin output from several state machines in the same cycle is resolved in favour of the highest-numbered
+ * state machine, as in the hardware. The input synchronisers are not modelled (as if IP_SYN_BYP were set).
+ *
+ * A VCD trace of the pins and the program counters can be written for viewing with gtkwave or similar.
+*/
+#define PIOSIM_NSM			4
+#define PIOSIM_NINSTR		32
+#define PIOSIM_FIFO_MAX		8
+
+typedef struct piosim_sm_s piosim_sm_t;
+typedef struct piosim_s piosim_t;
+
+struct piosim_sm_s
+{
+	rp2040_piosm_cfg_t cfg;		/* Configuration registers */
+	boolean_t enabled;
+	u32_t pc;
+	u32_t x;
+	u32_t y;
+	u32_t isr;
+	u32_t osr;
+	u32_t isr_count;			/* No. of bits shifted into the ISR (0..32) */
+	u32_t osr_count;			/* No. of bits shifted out of the OSR (0..32). 32 means empty */
+	u32_t delay;				/* Remaining delay cycles of the current instruction */
+	u32_t div_acc;				/* Clock divider accumulator (units of 1/256 clk_sys cycle) */
+	u16_t exec_instr;			/* Instruction from OUT EXEC or MOV EXEC ... */
+	boolean_t exec_pending;		/* ... to be executed on the next SM cycle */
+	boolean_t in_done;			/* IN has shifted; waiting for space for the autopush */
+	boolean_t irq_waiting;		/* IRQ WAIT has set its flag; waiting for it to be cleared */
+
+	u32_t txf[PIOSIM_FIFO_MAX];
+	u32_t tx_rd;
+	u32_t tx_level;
+	u32_t rxf[PIOSIM_FIFO_MAX];
+	u32_t rx_rd;
+	u32_t rx_level;
+
+	/* Statistics
+	*/
+	u64_t n_ticks;				/* SM clock enables */
+	u64_t n_instr;				/* Completed instructions */
+	u64_t n_stall;				/* SM cycles spent stalled, for any reason */
+	u64_t n_txstall;			/* SM cycles stalled on an empty TX FIFO (starvation) */
+	u64_t n_rxstall;			/* SM cycles stalled on a full RX FIFO (overrun) */
+};
+
+struct piosim_s
+{
+	u16_t instr_mem[PIOSIM_NINSTR];
+	piosim_sm_t sm[PIOSIM_NSM];
+	u32_t irq;					/* IRQ flags 0..7 */
+	u32_t fdebug;				/* Same layout as the FDEBUG register */
+	u32_t pins_ext;				/* Values driven onto the pins from outside */
+	u32_t pad_out;				/* Output values from the PIO */
+	u32_t pad_oe;				/* Output enables from the PIO */
+	u32_t oe_force;				/* Output enables forced by the GPIO (OEOVER_ENABLE) */
+	u64_t cycle;				/* clk_sys cycles since piosim_init() */
+	u32_t clk_hz;				/* clk_sys frequency, for the VCD time scale */
+
+	FILE *vcd;
+	u32_t vcd_pins;				/* Pins to trace */
+	u32_t vcd_last_pins;
+	u32_t vcd_last_pc[PIOSIM_NSM];
+	boolean_t vcd_started;
+};
+
+extern void piosim_init(piosim_t *sim, u32_t clk_hz);
+extern void piosim_load(piosim_t *sim, const u16_t *prog, u32_t len, u32_t offset);
+extern void piosim_configure(piosim_t *sim, int sm, const rp2040_piosm_cfg_t *cfg, u32_t start_addr);
+extern void piosim_enable(piosim_t *sim, u32_t smmask);
+extern void piosim_disable(piosim_t *sim, u32_t smmask);
+
+extern int piosim_tx_put(piosim_t *sim, int sm, u32_t v);
+extern int piosim_rx_get(piosim_t *sim, int sm, u32_t *v);
+
+extern void piosim_set_inputs(piosim_t *sim, u32_t mask, u32_t val);
+extern void piosim_force_oe(piosim_t *sim, u32_t mask);
+extern u32_t piosim_pins(piosim_t *sim);
+
+extern void piosim_step(piosim_t *sim);
+extern void piosim_run(piosim_t *sim, u64_t ncycles);
+extern u64_t piosim_run_until(piosim_t *sim, u32_t mask, u32_t val, u64_t max);
+
+extern int piosim_vcd_open(piosim_t *sim, const char *filename, u32_t pins);
+extern void piosim_vcd_close(piosim_t *sim);
+
+#endif
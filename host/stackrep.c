@@ -0,0 +1,448 @@
+/* stackrep.c - worst-case stack usage report
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Intended to be compiled on the host system (gcc).
+ *
+ * Usage: stackrep [-e entry]... <program.dis> <file.su>...
+ *	Combines the frame sizes from gcc -fstack-usage (the .su files) with the call graph from the
+ *	disassembly of the program (arm-none-eabi-objdump -d program.elf > program.dis) and prints the
+ *	worst-case stack usage and the deepest call chain of each entry point.
+ *
+ *	Without -e the entry points are all the functions that aren't called directly: main(), main1(),
+ *	the boot code, the exception and interrupt handlers (whether they are APP_xxx handlers in the vector
+ *	table or attached at run time) and functions that are only called through pointers.
+ *
+ * Usage: stackrep -t
+ *	Runs the analysis on a built-in example and prints "Pass".
+ *
+ * Direct calls (bl) and tail calls (b to the start of another function) are edges of the call graph.
+ * A tail call is counted as if it were a call, which overestimates slightly. The results are flagged:
+ *	?	a reachable function has no .su entry (assembly language or a library); its frame counts as 0
+ *	D	a reachable function has a dynamic (unbounded) frame size
+ *	I	a reachable function makes an indirect call (blx or bx to a register), which isn't followed
+ *	R	a reachable function is recursive; the recursion is counted once
+ *
+ * Static functions with the same name in different files are treated as one function with the larger
+ * frame. An exception handler also needs the 32-byte exception frame that the hardware pushes.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host-types.h"
+
+#define MAXFUNC		4096
+#define MAXNAME		80
+#define MAXLINE		512
+
+#define F_UNKNOWN	0x01
+#define F_DYNAMIC	0x02
+#define F_INDIRECT	0x04
+#define F_RECURSIVE	0x08
+
+typedef struct edge_s edge_t;
+struct edge_s
+{
+	edge_t *next;
+	int to;
+};
+
+typedef struct func_s
+{
+	char name[MAXNAME];
+	int frame;				/* From the .su file; -1 if unknown */
+	int flags;				/* Own flags */
+	int n_callers;
+	edge_t *callees;
+	int state;				/* 0: not visited, 1: being visited, 2: done */
+	int worst;				/* Worst-case usage including callees */
+	int worst_flags;		/* Flags of all the functions that can be reached from here */
+	int next;				/* Next function on the worst-case chain, or -1 */
+} func_t;
+
+static func_t func[MAXFUNC];
+static int n_func;
+
+/* find_func() - find a function by name, adding it if it isn't there
+*/
+static int find_func(const char *name)
+{
+	for ( int i = 0; i < n_func; i++ )
+	{
+		if ( strcmp(func[i].name, name) == 0 )
+			return i;
+	}
+
+	if ( n_func >= MAXFUNC )
+	{
+		fprintf(stderr, "stackrep: too many functions\n");
+		exit(1);
+	}
+
+	func_t *f = &func[n_func];
+	memset(f, 0, sizeof(*f));
+	snprintf(f->name, sizeof(f->name), "%s", name);
+	f->frame = -1;
+	f->next = -1;
+	return n_func++;
+}
+
+static void add_edge(int from, int to)
+{
+	for ( edge_t *e = func[from].callees; e != NULL; e = e->next )
+	{
+		if ( e->to == to )
+			return;
+	}
+
+	edge_t *e = malloc(sizeof(*e));
+	e->to = to;
+	e->next = func[from].callees;
+	func[from].callees = e;
+	if ( from != to )
+		func[to].n_callers++;
+}
+
+/* read_su() - read a .su file
+ *
+ * Each line is <file>:<line>:<column>:<function> <tab> <bytes> <tab> <static|dynamic|dynamic,bounded>
+*/
+static void read_su(FILE *f)
+{
+	char line[MAXLINE];
+
+	while ( fgets(line, sizeof(line), f) != NULL )
+	{
+		char *tab = strchr(line, '\t');
+		if ( tab == NULL )
+			continue;
+		*tab = '\0';
+
+		char *name = strrchr(line, ':');
+		name = (name == NULL) ? line : name + 1;
+
+		char *qual;
+		int bytes = (int)strtol(tab + 1, &qual, 10);
+		int i = find_func(name);
+
+		if ( bytes > func[i].frame )
+			func[i].frame = bytes;
+		if ( strncmp(qual, "\tdynamic", 8) == 0 && strncmp(qual, "\tdynamic,bounded", 16) != 0 )
+			func[i].flags |= F_DYNAMIC;
+	}
+}
+
+/* is_branch() - return true if the mnemonic is a branch that can leave the function
+*/
+static int is_branch(const char *m)
+{
+	static const char * const br[] =
+	{	"bl", "b", "beq", "bne", "bcs", "bcc", "bhs", "blo", "bmi", "bpl", "bvs", "bvc",
+		"bhi", "bls", "bge", "blt", "bgt", "ble", "bal", NULL
+	};
+	char base[16];
+	size_t n = strcspn(m, ".");
+
+	if ( n >= sizeof(base) )
+		return 0;
+	memcpy(base, m, n);
+	base[n] = '\0';
+
+	for ( int i = 0; br[i] != NULL; i++ )
+	{
+		if ( strcmp(base, br[i]) == 0 )
+			return 1;
+	}
+	return 0;
+}
+
+/* read_dis() - read the disassembly and build the call graph
+ *
+ * Function labels look like "20000100 <main>:". Instructions look like
+ * "20000104:<tab>f000 f805 <tab>bl<tab>20000118 <foo>". A branch to a label with an offset
+ * (<main+0x12>) stays inside a function.
+*/
+static void read_dis(FILE *f)
+{
+	char line[MAXLINE];
+	int cur = -1;
+
+	while ( fgets(line, sizeof(line), f) != NULL )
+	{
+		line[strcspn(line, "\r\n")] = '\0';
+
+		size_t len = strlen(line);
+		char *lt = strchr(line, '<');
+
+		if ( len > 3 && line[len-1] == ':' && line[len-2] == '>' && lt != NULL && strchr(line, '\t') == NULL )
+		{
+			line[len-2] = '\0';
+			cur = find_func(lt + 1);
+			continue;
+		}
+
+		if ( cur < 0 )
+			continue;
+
+		/* Instruction: address, code, mnemonic, operands, separated by tabs
+		*/
+		char *fld[4] = { NULL, NULL, NULL, NULL };
+		int n = 0;
+		for ( char *p = strtok(line, "\t"); p != NULL && n < 4; p = strtok(NULL, "\t") )
+			fld[n++] = p;
+		if ( n < 4 )
+			continue;
+
+		char *mn = fld[2];
+		char *op = fld[3];
+
+		if ( strcmp(mn, "blx") == 0 || (strcmp(mn, "bx") == 0 && strncmp(op, "lr", 2) != 0) )
+		{
+			func[cur].flags |= F_INDIRECT;
+		}
+		else if ( is_branch(mn) && (lt = strchr(op, '<')) != NULL )
+		{
+			char *gt = strchr(lt, '>');
+			if ( gt == NULL )
+				continue;
+			*gt = '\0';
+			if ( strpbrk(lt + 1, "+-") != NULL )
+				continue;
+
+			int to = find_func(lt + 1);
+			if ( to != cur || strcmp(mn, "bl") == 0 )
+				add_edge(cur, to);
+		}
+	}
+}
+
+/* worst() - calculate the worst-case stack usage of a function and its callees
+*/
+static void worst(int i)
+{
+	func_t *f = &func[i];
+
+	if ( f->state == 2 )
+		return;
+
+	f->state = 1;
+	f->worst = 0;
+	f->worst_flags = 0;
+	f->next = -1;
+
+	for ( edge_t *e = f->callees; e != NULL; e = e->next )
+	{
+		func_t *c = &func[e->to];
+
+		if ( c->state == 1 )
+		{
+			f->worst_flags |= F_RECURSIVE;
+			continue;
+		}
+		worst(e->to);
+		if ( f->next < 0 || c->worst > f->worst )
+		{
+			f->worst = c->worst;
+			f->next = e->to;
+		}
+	}
+
+	for ( edge_t *e = f->callees; e != NULL; e = e->next )
+	{
+		if ( func[e->to].state == 2 )
+			f->worst_flags |= func[e->to].worst_flags;
+	}
+
+	f->worst += (f->frame < 0) ? 0 : f->frame;
+	f->worst_flags |= f->flags | ((f->frame < 0) ? F_UNKNOWN : 0);
+	f->state = 2;
+}
+
+static void print_flags(FILE *out, int flags)
+{
+	fprintf(out, "%c%c%c%c",
+		(flags & F_UNKNOWN) ? '?' : ' ',
+		(flags & F_DYNAMIC) ? 'D' : ' ',
+		(flags & F_INDIRECT) ? 'I' : ' ',
+		(flags & F_RECURSIVE) ? 'R' : ' ');
+}
+
+static void report(FILE *out, int i)
+{
+	worst(i);
+	fprintf(out, "%6d ", func[i].worst);
+	print_flags(out, func[i].worst_flags);
+	fprintf(out, " %s:", func[i].name);
+	for ( int j = i; j >= 0; j = func[j].next )
+		fprintf(out, " %s(%d)", func[j].name, func[j].frame);
+	fprintf(out, "\n");
+}
+
+static int cmp_worst(const void *a, const void *b)
+{
+	int ia = *(const int *)a, ib = *(const int *)b;
+
+	if ( func[ia].worst != func[ib].worst )
+		return func[ib].worst - func[ia].worst;
+	return strcmp(func[ia].name, func[ib].name);
+}
+
+/* report_all() - print the report for the given entry points, or for all functions without callers
+*/
+static void report_all(FILE *out, char **entry, int n_entry)
+{
+	int *list = malloc(sizeof(int) * (size_t)(n_func + 1));
+	int n = 0;
+
+	fprintf(out, " Bytes Flag Entry: chain (frame sizes)\n");
+
+	if ( n_entry > 0 )
+	{
+		for ( int i = 0; i < n_entry; i++ )
+			report(out, find_func(entry[i]));
+	}
+	else
+	{
+		for ( int i = 0; i < n_func; i++ )
+		{
+			if ( func[i].n_callers == 0 )
+			{
+				worst(i);
+				list[n++] = i;
+			}
+		}
+		qsort(list, (size_t)n, sizeof(int), cmp_worst);
+		for ( int i = 0; i < n; i++ )
+			report(out, list[i]);
+	}
+	free(list);
+}
+
+/* self_test() - analyse a small example
+ *
+ * main -> foo -> bar (indirect call), main -> bar, foo -> rec (tail call), rec -> rec.
+ * handler -> bar (tail call). foo and bar are called directly, so they aren't entry points.
+*/
+static const char test_su[] =
+	"a.c:1:5:main\t16\tstatic\n"
+	"a.c:5:6:foo\t24\tstatic\n"
+	"a.c:9:13:bar\t8\tstatic\n"
+	"a.c:12:6:handler\t40\tstatic\n"
+	"a.c:14:6:rec\t8\tstatic\n";
+
+static const char test_dis[] =
+	"20000000 <main>:\n"
+	"20000000:\tb500      \tpush\t{lr}\n"
+	"20000002:\tf000 f805 \tbl\t20000010 <foo>\n"
+	"20000006:\tf000 f80b \tbl\t20000020 <bar>\n"
+	"2000000a:\te7fe      \tb.n\t2000000a <main+0xa>\n"
+	"\n"
+	"20000010 <foo>:\n"
+	"20000010:\tf000 f806 \tbl\t20000020 <bar>\n"
+	"20000014:\te00c      \tb.n\t20000030 <rec>\n"
+	"\n"
+	"20000020 <bar>:\n"
+	"20000020:\t4798      \tblx\tr3\n"
+	"20000022:\t4770      \tbx\tlr\n"
+	"\n"
+	"20000028 <handler>:\n"
+	"20000028:\te7fa      \tb.n\t20000020 <bar>\n"
+	"\n"
+	"20000030 <rec>:\n"
+	"20000030:\tf7ff fffe \tbl\t20000030 <rec>\n"
+	"20000034:\td1fc      \tbne.n\t20000030 <rec>\n";
+
+static int self_test(void)
+{
+	FILE *f;
+	int m, h, ok;
+
+	f = fmemopen((void *)test_su, sizeof(test_su) - 1, "r");
+	read_su(f);
+	fclose(f);
+	f = fmemopen((void *)test_dis, sizeof(test_dis) - 1, "r");
+	read_dis(f);
+	fclose(f);
+
+	m = find_func("main");
+	h = find_func("handler");
+	worst(m);
+	worst(h);
+
+	ok = func[m].worst == 48 && func[m].worst_flags == (F_INDIRECT | F_RECURSIVE) &&
+		 func[h].worst == 48 && func[h].worst_flags == F_INDIRECT &&
+		 func[m].n_callers == 0 && func[h].n_callers == 0 &&
+		 func[find_func("foo")].n_callers == 1 && func[find_func("bar")].n_callers == 3;
+
+	if ( !ok )
+	{
+		printf("Fail:\n");
+		report_all(stdout, NULL, 0);
+		return 1;
+	}
+	printf("Pass\n");
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	char **entry = malloc(sizeof(char *) * (size_t)argc);
+	int n_entry = 0;
+	int a = 1;
+	FILE *f;
+
+	if ( argc == 2 && strcmp(argv[1], "-t") == 0 )
+		return self_test();
+
+	while ( a + 1 < argc && strcmp(argv[a], "-e") == 0 )
+	{
+		entry[n_entry++] = argv[a+1];
+		a += 2;
+	}
+
+	if ( argc - a < 2 )
+	{
+		fprintf(stderr, "Usage: stackrep [-e entry]... <program.dis> <file.su>...\n       stackrep -t\n");
+		return 1;
+	}
+
+	for ( int i = a + 1; i < argc; i++ )
+	{
+		f = fopen(argv[i], "r");
+		if ( f == NULL )
+		{
+			fprintf(stderr, "stackrep: can't open %s\n", argv[i]);
+			return 1;
+		}
+		read_su(f);
+		fclose(f);
+	}
+
+	f = fopen(argv[a], "r");
+	if ( f == NULL )
+	{
+		fprintf(stderr, "stackrep: can't open %s\n", argv[a]);
+		return 1;
+	}
+	read_dis(f);
+	fclose(f);
+
+	report_all(stdout, entry, n_entry);
+	return 0;
+}
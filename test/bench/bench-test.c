@@ -0,0 +1,184 @@
+/* bench-test.c - benchmarks for the drivers
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-uart.h"
+#include "rp2040-gpio.h"
+#include "rp2040-resets.h"
+#include "rp2040-dma.h"
+#include "rp2040-sio.h"
+#include "rp2040-clocks.h"
+#include "rp2040-bench.h"
+#include "test-io.h"
+
+/* Expected outcome of this test:
+ *
+ * Async serial output at 115200-8N1 on GPIO 16
+ *	- "Test started ..."
+ *	- a few dots from the UART benchmark
+ *	- one line per benchmark (see rp2040-bench.h for the format), all times in CPU cycles:
+ *		empty		sanity check: 0
+ *		udiv		rp2040_udiv(): a handful of cycles for the SIO divider plus the function overhead
+ *		uart_putc	rp2040_uart_putc() with an empty tx FIFO
+ *		dma_copy	DMA copy of 256 words, memory to memory, including set-up and waiting
+ *		dma_banked	the same copy between buffers in SRAM2 and SRAM3 (non-striped alias), for comparison
+ *		cpu_copy	the same copy by the CPU, for comparison
+ *		interp		32 steps of the 1-bit DAC from the interp test
+ *	- "Test finished"
+ *
+ * The lines can be extracted with grep ^BENCH and compared with an earlier run.
+*/
+#define NCOPY	256
+
+static u32_t src[NCOPY];
+static u32_t dst[NCOPY];
+static u32_t src_banked[NCOPY] RP2040_SRAM_BANK(2);
+static u32_t dst_banked[NCOPY] RP2040_SRAM_BANK(3);
+
+typedef struct copy_s
+{
+	u32_t *src;
+	u32_t *dst;
+} copy_t;
+
+static const copy_t copy_striped = { src, dst };
+static const copy_t copy_banked = { src_banked, dst_banked };
+static volatile u32_t result;
+
+static void bench_empty(void *arg)
+{
+}
+
+static void bench_udiv(void *arg)
+{
+	result = rp2040_udiv(123456789, result | 1, 0);
+}
+
+static void wait_uart_empty(void *arg)
+{
+	while ( (rp2040_uart0.fr & UART_TXFE) == 0 )
+	{
+		/* Wait */
+	}
+}
+
+static void bench_uart_putc(void *arg)
+{
+	rp2040_uart_putc(&rp2040_uart0, '.');
+}
+
+static void bench_dma_copy(void *arg)
+{
+	const copy_t *c = arg;
+
+	rp2040_dma.ch[0].read_addr = (u32_t)c->src;
+	rp2040_dma.ch[0].write_addr = (u32_t)c->dst;
+	rp2040_dma.ch[0].trans_count = NCOPY;
+	rp2040_dma.ch[0].ctrl_trig = DMA_TREQ_VAL(TREQ_PERM) | DMA_CHAIN_VAL(0) | DMA_RING_NONE |
+								DMA_INCR_WRITE | DMA_INCR_READ | DMA_SIZE_WORD | DMA_CHANNEL_EN;
+
+	while ( (rp2040_dma.ch[0].ctrl_trig & DMA_BUSY) != 0 )
+	{
+		/* Wait */
+	}
+}
+
+static void bench_cpu_copy(void *arg)
+{
+	for ( int i = 0; i < NCOPY; i++ )
+		dst[i] = src[i];
+}
+
+static void bench_interp(void *arg)
+{
+	u32_t stream = 0;
+	u32_t oflo0 = rp2040_sio.interp[0].peek_lane0;
+	u32_t oflo1;
+
+	for ( int i = 0; i < 32; i++ )
+	{
+		stream <<= 1;
+		rp2040_sio.interp[0].accum0_add = 0x5555;
+		oflo1 = rp2040_sio.interp[0].peek_lane0;
+		stream |= (oflo0 ^ oflo1);
+		oflo0 = oflo1;
+	}
+	result = stream;
+}
+
+static const rp2040_bench_t benchmarks[] =
+{	/*	name			fn					setup				arg						warm	rep	flags	*/
+	{	"empty",		bench_empty,		0,					0,						4,		32,	0	},
+	{	"udiv",			bench_udiv,			0,					0,						4,		32,	0	},
+	{	"uart_putc",	bench_uart_putc,	wait_uart_empty,	0,						1,		8,	0	},
+	{	"dma_copy",		bench_dma_copy,		0,					(void *)&copy_striped,	2,		16,	0	},
+	{	"dma_banked",	bench_dma_copy,		0,					(void *)&copy_banked,	2,		16,	0	},
+	{	"cpu_copy",		bench_cpu_copy,		0,					0,						2,		16,	0	},
+	{	"interp",		bench_interp,		0,					0,						2,		16,	0	}
+};
+
+#define NBENCH	(sizeof(benchmarks)/sizeof(benchmarks[0]))
+
+int main(void)
+{
+	rp2040_benchresult_t results[NBENCH];
+
+	/* Initialise uart0
+	*/
+	(void)rp2040_uart_init(&rp2040_uart0, 115200, "8N1");
+
+	/* Set up the I/O function for UART0
+	  * GPIO 16 = UART0 tx
+	  * GPIO 17 = UART0 rx
+	 */
+	rp2040_iobank0.gpio[16].ctrl = FUNCSEL_UART;
+	rp2040_iobank0.gpio[17].ctrl = FUNCSEL_UART;
+
+	dh_puts("Test started ...\n");
+
+	rp2040_release(RESETS_dma);
+
+	rp2040_sio.interp[0].accum0 = 0x8000;
+	rp2040_sio.interp[0].base0 = 0;
+	rp2040_sio.interp[0].ctrl_lane0 = (16 << 0) | (0 << 5) | (0 << 10);
+
+	for ( int i = 0; i < NCOPY; i++ )
+	{
+		src[i] = (u32_t)i;
+		src_banked[i] = (u32_t)i;
+	}
+
+	rp2040_bench_init();
+
+	/* Run everything first, then report, so that the reporting doesn't disturb the UART benchmark
+	*/
+	for ( unsigned i = 0; i < NBENCH; i++ )
+		rp2040_bench_run(&benchmarks[i], &results[i]);
+
+	dh_putc('\n');
+	for ( unsigned i = 0; i < NBENCH; i++ )
+		rp2040_bench_report(&benchmarks[i], &results[i], dh_putc);
+
+	dh_puts("Test finished\n");
+
+	for (;;) {}
+
+	return 0;
+}
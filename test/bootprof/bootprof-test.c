@@ -0,0 +1,77 @@
+/* bootprof-test.c - print the boot profile
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-uart.h"
+#include "rp2040-gpio.h"
+#include "rp2040-clocks.h"
+#include "rp2040-startup.h"
+#include "test-io.h"
+
+/* Expected outcome of this test:
+ *
+ * Async serial output at 115200-8N1 on GPIO 16
+ *	- "Test started ..."
+ *	- the time in microseconds (hex) at the end of each phase of the boot, measured from the start of the timer:
+ *		"pll     "	system PLL locked
+ *		"usbpll  "	USB PLL locked; the same as pll unless built with RP2040_USBPLL
+ *		"bss     "	.bss cleared by DMA; normally the same as usbpll
+ *		"verify  "	clock frequencies checked
+ *		"main    "	main() called
+ *	- "clk bad " and the rp2040_clk_verify() result if the startup check failed
+ *	- "Test finished"
+*/
+static const char * const phase_name[RP2040_BOOT_NPHASE] =
+{	"pll     ", "usbpll  ", "bss     ", "verify  ", "main    "
+};
+
+int main(void)
+{
+	/* Initialise uart0
+	*/
+	(void)rp2040_uart_init(&rp2040_uart0, 115200, "8N1");
+
+	/* Set up the I/O function for UART0
+	  * GPIO 16 = UART0 tx
+	  * GPIO 17 = UART0 rx
+	 */
+	rp2040_iobank0.gpio[16].ctrl = FUNCSEL_UART;
+	rp2040_iobank0.gpio[17].ctrl = FUNCSEL_UART;
+
+	dh_puts("Test started ...\n");
+
+	for ( int i = 0; i < RP2040_BOOT_NPHASE; i++ )
+	{
+		dh_puts(phase_name[i]);
+		dh_putx32(rp2040_boot_time[i]);
+	}
+
+	if ( rp2040_clk_failed != 0 )
+	{
+		dh_puts("clk bad ");
+		dh_putx32(rp2040_clk_failed);
+	}
+
+	dh_puts("Test finished\n");
+
+	for (;;) {}
+
+	return 0;
+}
@@ -0,0 +1,93 @@
+/* clkscale-test.c - run-time changes of clk_sys
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-uart.h"
+#include "rp2040-gpio.h"
+#include "rp2040-resets.h"
+#include "rp2040-clocks.h"
+#include "rp2040-pio.h"
+#include "test-io.h"
+
+/* Expected outcome of this test:
+ *
+ * Async serial output at 115200-8N1 on GPIO 16, built with RP2040_CLK_PERI_SYS so that the UART's
+ * clock follows clk_sys.
+ *	- "Test started ..."
+ *	- for each frequency in the list, repeated forever:
+ *		- "clk_sys " and the frequency in hex
+ *		- "clkdiv  " and PIO0 SM0's clock divider register, which should keep the SM at 1 MHz
+ *		- "fc0 kHz " and clk_sys measured by the frequency counter
+ *		- a one-second pause
+ *	- "Failed" and the frequency if a frequency can't be set
+ *
+ * Before that, "clk bad " and the rp2040_clk_verify() result if the startup check failed.
+ *
+ * The output should be readable at every frequency, with no garbled characters around the changes.
+*/
+static const u32_t freqs[] = { 48000000, 125000000, 24000000, 100000000, 133000000 };
+
+#define NFREQ	(sizeof(freqs)/sizeof(freqs[0]))
+
+int main(void)
+{
+	/* Initialise uart0
+	*/
+	(void)rp2040_uart_init(&rp2040_uart0, 115200, "8N1");
+
+	/* Set up the I/O function for UART0
+	  * GPIO 16 = UART0 tx
+	  * GPIO 17 = UART0 rx
+	 */
+	rp2040_iobank0.gpio[16].ctrl = FUNCSEL_UART;
+	rp2040_iobank0.gpio[17].ctrl = FUNCSEL_UART;
+
+	dh_puts("Test started ...\n");
+
+	if ( rp2040_clk_failed != 0 )
+	{
+		dh_puts("clk bad ");
+		dh_putx32(rp2040_clk_failed);
+	}
+
+	rp2040_release(RESETS_pio0);
+	(void)rp2040_pio_sm_set_freq(&rp2040_pio0, 0, 1000000);
+
+	for (;;)
+	{
+		for ( unsigned i = 0; i < NFREQ; i++ )
+		{
+			if ( rp2040_clk_sys_set(freqs[i]) != 0 )
+			{
+				dh_puts("Failed  ");
+				dh_putx32(freqs[i]);
+			}
+			dh_puts("clk_sys ");
+			dh_putx32(rp2040_clk_sys_hz());
+			dh_puts("clkdiv  ");
+			dh_putx32(rp2040_pio0.sm[0].clkdiv);
+			dh_puts("fc0 kHz ");
+			dh_putx32(rp2040_fc0_measure_khz(FC0_SRC_CLK_SYS));
+			soft_delay_1s();
+		}
+	}
+
+	return 0;
+}
@@ -20,6 +20,7 @@
 #include "rp2040-types.h"
 #include "rp2040.h"
 #include "rp2040-uart.h"
+#include "rp2040-delay.h"
 #include "test-io.h"
 
 void dh_putc(char c)
@@ -55,17 +56,13 @@ void dh_putx32(u32_t v)
 	dh_puts(str);
 }
 
-#define NLOOPS	(133000000/12)	/* Assumes no compiler optimisation */
+/* soft_delay_1s() - wait for one second
+ *
+ * The timer is started by rp2040_kickstart(), so this doesn't depend on the CPU clock.
+*/
 void soft_delay_1s(void)
 {
-	/* An earler version of this function used xosc.count
-	 * However, the counter is not reliable - see RP2040 datasheet erratum RP2040-E7
-	 * So we're stuck with a loop until a timer gets initialised.
-	*/
-	for ( int i = 0; i < NLOOPS; i++ )
-	{
-		__asm__ volatile ("nop");
-	}
+	rp2040_busy_wait_us(1000000);
 }
 
 void app_nmi(void)
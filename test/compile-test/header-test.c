@@ -46,13 +46,28 @@ typedef int boolean_t;
 
 #include "rp2040.h"
 #include "rp2040-adc.h"
+#include "rp2040-bench.h"
 #include "rp2040-clocks.h"
+#include "rp2040-crash.h"
+#include "rp2040-delay.h"
 #include "rp2040-dma.h"
+#include "rp2040-edgecap.h"
 #include "rp2040-gpio.h"
+#include "rp2040-gpioirq.h"
+#include "rp2040-irqprof.h"
+#include "rp2040-log.h"
+#include "rp2040-mem.h"
+#include "rp2040-nvic.h"
 #include "rp2040-pads.h"
 #include "rp2040-pio.h"
+#include "rp2040-piodma.h"
+#include "rp2040-printf.h"
+#include "rp2040-psm.h"
 #include "rp2040-resets.h"
 #include "rp2040-sio.h"
+#include "rp2040-softirq.h"
+#include "rp2040-stack.h"
+#include "rp2040-startup.h"
 #include "rp2040-timer.h"
 #include "rp2040-uart.h"
 #include "rp2040-watchdog.h"
@@ -66,11 +81,15 @@ static int test_gpio(void);
 static int test_pio(void);
 static int test_pads(void);
 static int test_resets(void);
+static int test_psm(void);
 static int test_sio(void);
 static int test_timer(void);
 static int test_uart(void);
 static int test_watchdog(void);
 static int test_cm0(void);
+static int test_nvic(void);
+static int test_irqprof(void);
+static int test_pllcalc(void);
 static int test_address(volatile void *p, u32_t v, const char *name);
 
 int main(int argc, char **argv)
@@ -85,11 +104,15 @@ int main(int argc, char **argv)
 	nfail += test_pads();
 	nfail += test_pio();
 	nfail += test_resets();
+	nfail += test_psm();
 	nfail += test_sio();
 	nfail += test_timer();
 	nfail += test_uart();
 	nfail += test_watchdog();
 	nfail += test_cm0();
+	nfail += test_nvic();
+	nfail += test_irqprof();
+	nfail += test_pllcalc();
 
 	if ( nfail == 0 )
 		printf("Pass\n");
@@ -239,6 +262,16 @@ static int test_resets(void)
 	return nfail;
 }
 
+static int test_psm(void)
+{
+	int nfail = 0;
+	nfail += test_address(&rp2040_psm.frce_on,			0x40010000, "rp2040_psm.frce_on");
+	nfail += test_address(&rp2040_psm.frce_off,			0x40010004, "rp2040_psm.frce_off");
+	nfail += test_address(&rp2040_psm.wdsel,			0x40010008, "rp2040_psm.wdsel");
+	nfail += test_address(&rp2040_psm.done,				0x4001000c, "rp2040_psm.done");
+	return nfail;
+}
+
 static int test_sio(void)
 {
 	int nfail = 0;
@@ -506,6 +539,7 @@ static int test_watchdog(void)
 	nfail += test_address(&rp2040_watchdog.reason,		0x40058008, "rp2040_watchdog.reason");
 	nfail += test_address(&rp2040_watchdog.scratch[0],	0x4005800c, "rp2040_watchdog.scratch0");
 	nfail += test_address(&rp2040_watchdog.scratch[1],	0x40058010, "rp2040_watchdog.scratch1");
+	nfail += test_address(&rp2040_watchdog.scratch[7],	0x40058028, "rp2040_watchdog.scratch7");
 	nfail += test_address(&rp2040_watchdog.tick,		0x4005802c, "rp2040_watchdog.tick");
 	return nfail;
 }
@@ -521,6 +555,78 @@ static int test_pads(void)
 	return nfail;
 }
 
+static int test_nvic(void)
+{
+	int nfail = 0;
+	nfail += test_address(&rp2040_nvic.iser[0],		0xe000e100, "rp2040_nvic.iser");
+	nfail += test_address(&rp2040_nvic.icer[0],		0xe000e180, "rp2040_nvic.icer");
+	nfail += test_address(&rp2040_nvic.ispr[0],		0xe000e200, "rp2040_nvic.ispr");
+	nfail += test_address(&rp2040_nvic.icpr[0],		0xe000e280, "rp2040_nvic.icpr");
+	nfail += test_address(&rp2040_nvic.ipr[0],		0xe000e400, "rp2040_nvic.ipr[0]");
+	nfail += test_address(&rp2040_nvic.ipr[7],		0xe000e41c, "rp2040_nvic.ipr[7]");
+	return nfail;
+}
+
+/* Histogram buckets and SysTick wrap-around
+*/
+static int test_irqprof(void)
+{
+	int nfail = 0;
+	static const u32_t t[] = { 0, 1, 2, 3, 4, 133, 65535, 65536, 0xffffff };
+	static const int b[] = { 0, 0, 1, 1, 2, 7, 15, 15, 15 };
+
+	for ( int i = 0; i < (int)(sizeof(t)/sizeof(t[0])); i++ )
+	{
+		if ( rp2040_irqprof_bucket(t[i]) != b[i] )
+		{
+			printf("rp2040_irqprof_bucket(%u) is %d, expected %d\n", t[i], rp2040_irqprof_bucket(t[i]), b[i]);
+			nfail++;
+		}
+	}
+
+	if ( cxm_systick_elapsed(0x000010, 0xfffff0) != 0x20 )
+	{
+		printf("cxm_systick_elapsed() doesn't handle wrap-around\n");
+		nfail++;
+	}
+	return nfail;
+}
+
+/* PLL solver: the default settings must be the ones from the datasheet. 48 MHz is the USB PLL.
+*/
+static int test_pll(u32_t f, u32_t refdiv, u32_t fbdiv, u32_t pd1, u32_t pd2)
+{
+	u32_t s = RP2040_PLL_SOLVE(RP2040_XOSC_HZ, f);
+
+	if ( s != 0 && RP2040_PLL_REFDIV_OF(s) == refdiv && RP2040_PLL_FBDIV_OF(RP2040_XOSC_HZ, f, s) == fbdiv &&
+		 RP2040_PLL_POSTDIV1_OF(s) == pd1 && RP2040_PLL_POSTDIV2_OF(s) == pd2 )
+		return 0;
+
+	printf("RP2040_PLL_SOLVE(%u) gives 0x%03x, expected %u/%u/%u/%u\n", f, s, refdiv, fbdiv, pd1, pd2);
+	return 1;
+}
+
+static int test_pllcalc(void)
+{
+	int nfail = 0;
+	nfail += test_pll(133000000, 1, 133, 6, 2);
+	nfail += test_pll(125000000, 1, 125, 6, 2);
+	nfail += test_pll(48000000, 1, 120, 6, 5);
+	nfail += test_pll(200000000, 1, 100, 6, 1);
+	nfail += test_pll(100000000, 1, 125, 5, 3);
+
+	if ( RP2040_PLL_SOLVE(RP2040_XOSC_HZ, 133333333) != 0 )
+	{
+		printf("RP2040_PLL_SOLVE(133333333) should have no solution\n");
+		nfail++;
+	}
+
+#if RP2040_PLL_SOLVE(RP2040_XOSC_HZ, 12000000) != 0
+#error "RP2040_PLL_SOLVE() in #if: 12 MHz should have no solution"
+#endif
+	return nfail;
+}
+
 #if 0
 /* Template peripheral test
 */
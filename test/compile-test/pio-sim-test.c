@@ -0,0 +1,366 @@
+/* pio-sim-test.c - host test for the PIO simulator
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Intended to be compiled on the host system (gcc), together with host/pio-sim.c
+ * Runs some well-known PIO programs in the simulator and checks the timing of the outputs.
+ * Writes a VCD trace of the squarewave test to build/pio-sim-test.vcd
+*/
+#include <stdio.h>
+#include "host-types.h"
+#include "rp2040-pio.h"
+#include "rp2040-edgecap.h"
+#include "pio-sim.h"
+
+#define CLK_HZ		133000000
+
+static int test_shifter(void);
+static int test_squarewave(void);
+static int test_ws2812(void);
+static int test_autopush(void);
+static int test_clkdiv(void);
+static int test_irq(void);
+static int test_edgecap(void);
+static int check(const char *name, u64_t actual, u64_t expected);
+
+int main(int argc, char **argv)
+{
+	int nfail = 0;
+
+	nfail += test_shifter();
+	nfail += test_squarewave();
+	nfail += test_ws2812();
+	nfail += test_autopush();
+	nfail += test_clkdiv();
+	nfail += test_irq();
+	nfail += test_edgecap();
+
+	if ( nfail == 0 )
+		printf("Pass\n");
+
+	return nfail != 0;
+}
+
+/* shifter.pio with the configuration and data from test/pio
+ *	out pins, 1
+ *
+ * Waveform on GPIO15: low 6.4 ms, high 0.4 ms, low 2.0 ms, high 4.0 ms at 10 kHz.
+ * After the four words, the state machine starves.
+*/
+static int test_shifter(void)
+{
+	static const u16_t prog[] = { 0x6001 };
+	const u32_t pin = 1u << 15;
+	const u64_t bit = 13300;		/* clk_sys cycles per bit */
+	int nfail = 0;
+	piosim_t sim;
+	rp2040_piosm_cfg_t cfg;
+
+	piosim_init(&sim, CLK_HZ);
+	piosim_load(&sim, prog, 1, 0);
+	piosim_force_oe(&sim, pin);
+
+	rp2040_piosm_cfg_init(&cfg);
+	rp2040_piosm_cfg_clkdiv(&cfg, 13300, 0);
+	rp2040_piosm_cfg_out_pins(&cfg, 15, 1);
+	rp2040_piosm_cfg_out_shift(&cfg, 0, 1, 32);
+	rp2040_piosm_cfg_wrap(&cfg, 0, 0);
+	piosim_configure(&sim, 3, &cfg, 0);
+
+	piosim_tx_put(&sim, 3, 0x00000000);
+	piosim_tx_put(&sim, 3, 0x00000000);
+	piosim_tx_put(&sim, 3, 0xf00000ff);
+	piosim_tx_put(&sim, 3, 0xffffffff);
+	nfail += check("shifter TX FIFO full", piosim_tx_put(&sim, 3, 0) == -1, 1);
+	sim.fdebug = 0;
+
+	piosim_enable(&sim, 1 << 3);
+
+	/* The first bit is output in the first cycle, so the pin is sampled one cycle later
+	 * than the start of the waveform.
+	*/
+	nfail += check("shifter low 6.4 ms", piosim_run_until(&sim, pin, pin, 1000000000), 64 * bit + 1);
+	nfail += check("shifter high 0.4 ms", piosim_run_until(&sim, pin, 0, 1000000000), 4 * bit);
+	nfail += check("shifter low 2.0 ms", piosim_run_until(&sim, pin, pin, 1000000000), 20 * bit);
+
+	/* The data ends with 40 consecutive ones. After that the TX FIFO is empty,
+	 * so the pin stays high and the state machine stalls.
+	*/
+	piosim_run(&sim, 100 * bit);
+	nfail += check("shifter starved output", piosim_pins(&sim) & pin, pin);
+	nfail += check("shifter instructions", sim.sm[3].n_instr, 128);
+	nfail += check("shifter TXSTALL", (sim.fdebug & (0x01000000 << 3)) != 0, 1);
+	nfail += check("shifter stalled", sim.sm[3].n_txstall > 0, 1);
+
+	return nfail;
+}
+
+/* squarewave.pio from the RP2040 datasheet, at clk_sys/2
+ *		set pindirs, 1
+ *	again:
+ *		set pins, 1 [31]
+ *		set pins, 0 [30]
+ *		jmp again
+*/
+static int test_squarewave(void)
+{
+	static const u16_t prog[] = { 0xe081, 0xff01, 0xfe00, 0x0001 };
+	int nfail = 0;
+	piosim_t sim;
+	rp2040_piosm_cfg_t cfg;
+
+	piosim_init(&sim, CLK_HZ);
+	piosim_load(&sim, prog, 4, 8);
+
+	rp2040_piosm_cfg_init(&cfg);
+	rp2040_piosm_cfg_clkdiv(&cfg, 2, 0);
+	rp2040_piosm_cfg_set_pins(&cfg, 0, 1);
+	piosim_configure(&sim, 0, &cfg, 8);
+
+	if ( piosim_vcd_open(&sim, "build/pio-sim-test.vcd", 0x1) != 0 )
+	{
+		printf("Can't create build/pio-sim-test.vcd\n");
+		nfail++;
+	}
+
+	piosim_enable(&sim, 1);
+
+	(void)piosim_run_until(&sim, 1, 1, 1000);
+	for ( int i = 0; i < 3; i++ )
+	{
+		nfail += check("squarewave high", piosim_run_until(&sim, 1, 0, 1000), 64);
+		nfail += check("squarewave low", piosim_run_until(&sim, 1, 1, 1000), 64);
+	}
+
+	piosim_vcd_close(&sim);
+	return nfail;
+}
+
+/* ws2812.pio from pico-examples, 24-bit autopull, side-set on GPIO 2
+ *	.side_set 1
+ *	.wrap_target
+ *	bitloop:
+ *		out x, 1       side 0 [2]
+ *		jmp !x do_zero side 1 [1]
+ *	do_one:
+ *		jmp  bitloop   side 1 [4]
+ *	do_zero:
+ *		nop            side 0 [4]
+ *	.wrap
+ *
+ * A 1 bit is high for 7 cycles, a 0 bit for 2. Each bit is 10 cycles.
+*/
+static int test_ws2812(void)
+{
+	static const u16_t prog[] = { 0x6221, 0x1123, 0x1400, 0xa442 };
+	const u32_t pin = 1u << 2;
+	int nfail = 0;
+	piosim_t sim;
+	rp2040_piosm_cfg_t cfg;
+
+	piosim_init(&sim, CLK_HZ);
+	piosim_load(&sim, prog, 4, 0);
+	piosim_force_oe(&sim, pin);
+
+	rp2040_piosm_cfg_init(&cfg);
+	rp2040_piosm_cfg_sideset(&cfg, 2, 1, 0, 0);
+	rp2040_piosm_cfg_out_shift(&cfg, 0, 1, 24);
+	rp2040_piosm_cfg_fifo_join(&cfg, PIO_FJOIN_TX);
+	rp2040_piosm_cfg_wrap(&cfg, 0, 3);
+	piosim_configure(&sim, 1, &cfg, 0);
+
+	piosim_tx_put(&sim, 1, 0x80000000);		/* GRB: 1 followed by 23 zeros */
+	piosim_enable(&sim, 1 << 1);
+
+	nfail += check("ws2812 first bit low", piosim_run_until(&sim, pin, pin, 1000), 3 + 1);	/* See test_shifter() */
+	nfail += check("ws2812 1 bit high", piosim_run_until(&sim, pin, 0, 1000), 7);
+	nfail += check("ws2812 1 bit low", piosim_run_until(&sim, pin, pin, 1000), 3);
+	nfail += check("ws2812 0 bit high", piosim_run_until(&sim, pin, 0, 1000), 2);
+	nfail += check("ws2812 0 bit low", piosim_run_until(&sim, pin, pin, 1000), 5 + 3);	/* Next bit is also 0 */
+
+	/* 24 bits take 240 cycles. Run on; the SM must stall on the empty FIFO with the line low (reset)
+	*/
+	piosim_run(&sim, 400);
+	nfail += check("ws2812 idle low", piosim_pins(&sim) & pin, 0);
+	nfail += check("ws2812 starved", sim.sm[1].n_txstall > 0, 1);
+
+	return nfail;
+}
+
+/* Sampling with autopush
+ *	in pins, 1
+ *
+ * GPIO 4 is driven with 0xa5 (MSB first), one bit per cycle. Autopush at 8 bits, shift left.
+*/
+static int test_autopush(void)
+{
+	static const u16_t prog[] = { 0x4001 };
+	int nfail = 0;
+	piosim_t sim;
+	rp2040_piosm_cfg_t cfg;
+	u32_t v = 0;
+
+	piosim_init(&sim, CLK_HZ);
+	piosim_load(&sim, prog, 1, 31);
+
+	rp2040_piosm_cfg_init(&cfg);
+	rp2040_piosm_cfg_in_pins(&cfg, 4);
+	rp2040_piosm_cfg_in_shift(&cfg, 0, 1, 8);
+	rp2040_piosm_cfg_wrap(&cfg, 31, 31);
+	piosim_configure(&sim, 2, &cfg, 31);
+	piosim_enable(&sim, 1 << 2);
+
+	for ( int i = 7; i >= 0; i-- )
+	{
+		piosim_set_inputs(&sim, 1u << 4, ((0xa5 >> i) & 1) << 4);
+		piosim_step(&sim);
+	}
+
+	nfail += check("autopush level", sim.sm[2].rx_level, 1);
+	nfail += check("autopush read", piosim_rx_get(&sim, 2, &v), 0);
+	nfail += check("autopush value", v, 0xa5);
+	nfail += check("autopush empty", piosim_rx_get(&sim, 2, &v) == -1, 1);
+
+	return nfail;
+}
+
+/* Fractional clock divider: 2.5 gives 400 SM cycles in 1000 clk_sys cycles
+*/
+static int test_clkdiv(void)
+{
+	static const u16_t prog[] = { 0x0000 };		/* jmp 0 */
+	piosim_t sim;
+	rp2040_piosm_cfg_t cfg;
+
+	piosim_init(&sim, CLK_HZ);
+	piosim_load(&sim, prog, 1, 0);
+
+	rp2040_piosm_cfg_init(&cfg);
+	rp2040_piosm_cfg_clkdiv(&cfg, 2, 128);
+	piosim_configure(&sim, 0, &cfg, 0);
+	piosim_enable(&sim, 1);
+	piosim_run(&sim, 1000);
+
+	return check("clkdiv 2.5", sim.sm[0].n_ticks, 400);
+}
+
+/* IRQ between state machines. SM0 waits for IRQ 0, which SM1 raises after a delay.
+ *	SM0 (offset 0):		wait 1 irq 0
+ *						set x, 1
+ *						jmp 2 (self)
+ *	SM1 (offset 3):		nop [15]
+ *						irq 0
+ *						jmp 5 (self)
+*/
+static int test_irq(void)
+{
+	static const u16_t prog0[] = { 0x20c0, 0xe021, 0x0002 };
+	static const u16_t prog1[] = { 0xaf42, 0xc000, 0x0002 };
+	int nfail = 0;
+	piosim_t sim;
+	rp2040_piosm_cfg_t cfg;
+
+	piosim_init(&sim, CLK_HZ);
+	piosim_load(&sim, prog0, 3, 0);
+	piosim_load(&sim, prog1, 3, 3);
+
+	rp2040_piosm_cfg_init(&cfg);
+	piosim_configure(&sim, 0, &cfg, 0);
+	piosim_configure(&sim, 1, &cfg, 3);
+	piosim_enable(&sim, 0x3);
+
+	piosim_run(&sim, 10);
+	nfail += check("irq: SM0 waiting", sim.sm[0].x, 0);
+	piosim_run(&sim, 20);
+	nfail += check("irq: SM0 released", sim.sm[0].x, 1);
+	nfail += check("irq: flag cleared by wait", sim.irq, 0);
+
+	return nfail;
+}
+
+/* The edge capture program from rp2040-edgecap.h, watching GPIO 7. The program is loaded at
+ * offset 5 to check the relocation.
+ *
+ * The decoded time of each edge must be the time of the first sample at or after the edge,
+ * i.e. 0 or 1 cycles after the edge.
+*/
+static int test_edgecap(void)
+{
+	static const u16_t prog[RP2040_EDGECAP_PROGLEN] = RP2040_EDGECAP_PROGRAM;
+	static const u64_t edges[] = { 100, 107, 250, 1001, 5000, 5013, 70001, 70008 };
+	const int nedges = sizeof(edges)/sizeof(edges[0]);
+	const u32_t pin = 1u << 7;
+	int nfail = 0;
+	int e = 0;
+	int n = 0;
+	piosim_t sim;
+	rp2040_piosm_cfg_t cfg;
+	u32_t prev = 0x7fffffff;
+	u64_t t = 0;
+	u32_t w;
+
+	piosim_init(&sim, CLK_HZ);
+	piosim_load(&sim, prog, RP2040_EDGECAP_PROGLEN, 5);
+	rp2040_edgecap_cfg(&cfg, 7, 5);
+	piosim_configure(&sim, 0, &cfg, 5);
+	piosim_enable(&sim, 1);
+
+	while ( sim.cycle < 80000 )
+	{
+		if ( e < nedges && sim.cycle == edges[e] )
+		{
+			piosim_set_inputs(&sim, pin, (e & 1) ? 0 : pin);
+			e++;
+		}
+		piosim_step(&sim);
+
+		while ( piosim_rx_get(&sim, 0, &w) == 0 )
+		{
+			t += 2 * rp2040_edgecap_delta(prev, w);
+			prev = w >> 1;
+
+			if ( n >= nedges )
+			{
+				printf("edgecap: unexpected event 0x%08x\n", w);
+				nfail++;
+			}
+			else
+			{
+				nfail += check("edgecap level", w & 1, (n & 1) ? 0 : 1);
+				nfail += check("edgecap time", (t - edges[n]) < 2, 1);
+			}
+			n++;
+		}
+	}
+	sim.fdebug &= ~(0x100 << 0);		/* RXUNDER from the polling is expected */
+
+	nfail += check("edgecap events", n, nedges);
+	nfail += check("edgecap fdebug", sim.fdebug, 0);
+	return nfail;
+}
+
+static int check(const char *name, u64_t actual, u64_t expected)
+{
+	if ( actual != expected )
+	{
+		printf("%s: got %lu, expected %lu\n", name, actual, expected);
+		return 1;
+	}
+	return 0;
+}
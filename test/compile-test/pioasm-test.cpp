@@ -0,0 +1,172 @@
+/* pioasm-test.cpp - host test for the compile-time PIO assembler
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Intended to be compiled on the host system (g++).
+ * Compares the output of rp2040-pioasm.h with the output of pioasm for some well-known programs.
+ * Most of the checks are done by the compiler; the run-time part just reports the result.
+*/
+#include <stdio.h>
+
+/* Inhibit inclusion of rp2040-types.h and define our own for the host. Assumes a 64-bit host.
+*/
+#define RP2040_TYPES_H		1
+
+typedef unsigned char u8_t;
+typedef unsigned short u16_t;
+typedef unsigned int u32_t;
+typedef unsigned long u64_t;
+
+typedef signed char s8_t;
+typedef signed short s16_t;
+typedef signed int s32_t;
+typedef signed long s64_t;
+
+typedef volatile u8_t reg8_t;
+typedef volatile u16_t reg16_t;
+typedef volatile u32_t reg32_t;
+typedef volatile u64_t reg64_t;
+
+typedef int boolean_t;
+
+#include "rp2040-pioasm.h"
+
+using namespace rp2040_pioasm;
+
+/* shifter.pio from test/pio
+ *	.wrap_target
+ *		out		pins, 1
+ *	.wrap
+*/
+typedef encoder<> shifter_enc;
+constexpr auto shifter = assemble<shifter_enc>(
+	out<out_dst::pins, 1>()
+);
+static const u16_t shifter_ref[] = { 0x6001 };
+
+/* squarewave.pio from the RP2040 datasheet
+ *		set pindirs, 1
+ *	again:
+ *		set pins, 1 [31]
+ *		set pins, 0 [30]
+ *		jmp again
+*/
+typedef encoder<> squarewave_enc;
+constexpr auto squarewave = assemble<squarewave_enc, 0, 3>(
+	set<set_dst::pindirs, 1>(),
+	squarewave_enc::delay<31>(set<set_dst::pins, 1>()),
+	squarewave_enc::delay<30>(set<set_dst::pins, 0>()),
+	jmp<cond::always, 1>()
+);
+static const u16_t squarewave_ref[] = { 0xe081, 0xff01, 0xfe00, 0x0001 };
+
+/* ws2812.pio from pico-examples
+ *	.side_set 1
+ *	.wrap_target
+ *	bitloop:
+ *		out x, 1       side 0 [2]
+ *		jmp !x do_zero side 1 [1]
+ *	do_one:
+ *		jmp  bitloop   side 1 [4]
+ *	do_zero:
+ *		nop            side 0 [4]
+ *	.wrap
+*/
+typedef encoder<1> ws2812_enc;
+constexpr auto ws2812 = assemble<ws2812_enc>(
+	ws2812_enc::side<0, 2>(out<out_dst::x, 1>()),
+	ws2812_enc::side<1, 1>(jmp<cond::not_x, 3>()),
+	ws2812_enc::side<1, 4>(jmp<cond::always, 0>()),
+	ws2812_enc::side<0, 4>(nop())
+);
+static const u16_t ws2812_ref[] = { 0x6221, 0x1123, 0x1400, 0xa442 };
+
+/* uart_tx.pio from pico-examples
+ *	.side_set 1 opt
+ *		pull       side 1 [7]
+ *		set x, 7   side 0 [7]
+ *	bitloop:
+ *		out pins, 1
+ *		jmp x-- bitloop   [6]
+*/
+typedef encoder<1, true> uart_tx_enc;
+constexpr auto uart_tx = assemble<uart_tx_enc>(
+	uart_tx_enc::side<1, 7>(pull()),
+	uart_tx_enc::side<0, 7>(set<set_dst::x, 7>()),
+	out<out_dst::pins, 1>(),
+	uart_tx_enc::delay<6>(jmp<cond::x_dec, 2>())
+);
+static const u16_t uart_tx_ref[] = { 0x9fa0, 0xf727, 0x6001, 0x0642 };
+
+/* Miscellaneous encodings that aren't covered by the programs above
+*/
+static_assert(wait<1, wait_src::pin, 0>() == 0x20a0, "wait 1 pin 0");
+static_assert(wait<0, wait_src::irq, 4, true>() == 0x2054, "wait 0 irq 4 rel");
+static_assert(in<in_src::pins, 32>() == 0x4000, "in pins, 32");
+static_assert(in<in_src::osr, 1>() == 0x40e1, "in osr, 1");
+static_assert(out<out_dst::exec, 16>() == 0x60f0, "out exec, 16");
+static_assert(push<false, false>() == 0x8000, "push noblock");
+static_assert(push<true, true>() == 0x8060, "push iffull block");
+static_assert(pull<true, false>() == 0x80c0, "pull ifempty noblock");
+static_assert(mov<mov_dst::x, mov_src::null, mov_op::invert>() == 0xa02b, "mov x, ~null");
+static_assert(mov<mov_dst::isr, mov_src::osr, mov_op::bitrev>() == 0xa0d7, "mov isr, ::osr");
+static_assert(irq<irq_mode::wait, 0>() == 0xc020, "irq wait 0");
+static_assert(irq<irq_mode::clear, 3, true>() == 0xc053, "irq clear 3 rel");
+static_assert(set<set_dst::y, 31>() == 0xe05f, "set y, 31");
+
+/* Program attributes and relocation
+*/
+static_assert(squarewave.wrap_target == 0 && squarewave.wrap == 3, "squarewave wrap");
+static_assert(squarewave.execctrl(4) == ((7u << 12) | (4u << 7)), "squarewave execctrl");
+static_assert(ws2812.pinctrl() == (1u << 29), "ws2812 side-set count");
+static_assert(uart_tx.pinctrl() == (2u << 29), "uart_tx side-set count (with opt)");
+static_assert(uart_tx.execctrl(0) == ((3u << 12) | (1u << 30)), "uart_tx execctrl");
+static_assert(relocate<8>(squarewave).instr[3] == 0x0009, "relocated jmp");
+static_assert(relocate<8>(squarewave).instr[1] == 0xff01, "relocation must not change set");
+static_assert(relocate<28>(ws2812).instr[1] == 0x113f, "relocated jmp with side-set");
+
+template <unsigned N>
+static int check(const char *name, const program<N> &p, const u16_t *ref)
+{
+	int nfail = 0;
+	for ( unsigned i = 0; i < N; i++ )
+	{
+		if ( p.instr[i] != ref[i] )
+		{
+			printf("%s[%u] is 0x%04x, expected 0x%04x\n", name, i, p.instr[i], ref[i]);
+			nfail++;
+		}
+	}
+	return nfail;
+}
+
+int main(int argc, char **argv)
+{
+	int nfail = 0;
+
+	nfail += check("shifter", shifter, shifter_ref);
+	nfail += check("squarewave", squarewave, squarewave_ref);
+	nfail += check("ws2812", ws2812, ws2812_ref);
+	nfail += check("uart_tx", uart_tx, uart_tx_ref);
+
+	if ( nfail == 0 )
+		printf("Pass\n");
+
+	return nfail != 0;
+}
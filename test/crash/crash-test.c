@@ -0,0 +1,93 @@
+/* crash-test.c - test program for the crash capture
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-uart.h"
+#include "rp2040-gpio.h"
+#include "rp2040-crash.h"
+#include "test-io.h"
+
+/* Expected outcome of this test:
+ *
+ * The program is linked with ld/rp2040-flash.ldscript, because a RAM-loaded program doesn't survive
+ * the reboot. The HardFault vector is rp2040_crash_handler() (see the Makefile).
+ *
+ * Async serial output at 115200-8N1 on GPIO 16
+ *	- "Test started ..."
+ *	- "RESET,00000000" (power-on) or "RESET,00000002" if the program was started by a reset from software
+ *	- "crash   " and the address of crash_here(): 0x1000xxxx
+ *	- the program reboots. After the reboot:
+ *	- "Test started ..."
+ *	- "RESET,00000002"
+ *	- "CRASH,00000000,00000003,<pc>,<lr>,<xpsr>,<uptime>"
+ *	  i.e. core 0, HardFault, pc a few bytes after the address of crash_here(), lr in main(),
+ *	  xpsr x1000000 (the T bit, thread mode, and any condition flags), uptime a few units of 1024 us
+ *	- "Test finished"
+*/
+
+/* crash_here() - cause a HardFault with an unaligned load
+*/
+static __attribute__((noinline)) u32_t crash_here(volatile u32_t *p)
+{
+	return p[0];
+}
+
+static void uart_flush(void)
+{
+	while ( (rp2040_uart0.fr & (UART_TXFE | UART_BUSY)) != UART_TXFE )
+	{
+		/* Wait */
+	}
+}
+
+int main(void)
+{
+	/* Initialise uart0
+	*/
+	(void)rp2040_uart_init(&rp2040_uart0, 115200, "8N1");
+
+	/* Set up the I/O function for UART0
+	  * GPIO 16 = UART0 tx
+	  * GPIO 17 = UART0 rx
+	 */
+	rp2040_iobank0.gpio[16].ctrl = FUNCSEL_UART;
+	rp2040_iobank0.gpio[17].ctrl = FUNCSEL_UART;
+
+	dh_puts("Test started ...\n");
+
+	rp2040_crash_report(dh_putc);
+
+	if ( !rp2040_reset_info.crashed )
+	{
+		dh_puts("crash   ");
+		dh_putx32((u32_t)&crash_here);
+		uart_flush();
+
+		(void)crash_here((volatile u32_t *)0x20000002);
+
+		dh_puts("No crash!\n");
+	}
+
+	dh_puts("Test finished\n");
+
+	for (;;) {}
+
+	return 0;
+}
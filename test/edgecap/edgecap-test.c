@@ -0,0 +1,112 @@
+/* edgecap-test.c - testing edge capture with PIO and DMA
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-uart.h"
+#include "rp2040-gpio.h"
+#include "rp2040-resets.h"
+#include "rp2040-pio.h"
+#include "rp2040-edgecap.h"
+#include "test-io.h"
+
+/* Expected outcome of this test:
+ *
+ * A square wave is generated on GPIO15 by PIO1 (the squarewave program from the datasheet with
+ * a divider of 65535, so 64 PIO cycles per period = 31.5 ms).
+ *
+ * Edges on GPIO15 and GPIO14 are captured using PIO0 and DMA channels 0 to 3.
+ *
+ * Async serial output at 115200-8N1 on GPIO 16
+ *	- for each edge: direction and pin number, time (us, low 32 bits) and ns, on three lines
+ *	- the edges on GPIO15 are about 15768 us (0x3d98) apart, alternately rising and falling
+ *	- connect GPIO14 to GPIO15 to see both pins' edges (a few ns apart), or to GND/3V3 via a button
+ *	  to see bounce
+*/
+#define NWORDS	64
+
+static const u16_t squarewave[] = { 0xe081, 0xff01, 0xfe00, 0x0001 };
+
+static const u8_t pins[2] = { 15, 14 };
+static u32_t ringbuf[2 * NWORDS];
+static rp2040_edgecap_t cap;
+
+int main(void)
+{
+	rp2040_edge_t ev;
+
+	/* Initialise uart0
+	*/
+	(void)rp2040_uart_init(&rp2040_uart0, 115200, "8N1");
+
+	/* Set up the I/O function for UART0
+	  * GPIO 16 = UART0 tx
+	  * GPIO 17 = UART0 rx
+	 */
+	rp2040_iobank0.gpio[16].ctrl = FUNCSEL_UART;
+	rp2040_iobank0.gpio[17].ctrl = FUNCSEL_UART;
+
+	dh_puts("Test started ...\n");
+
+	rp2040_release(RESETS_pio0);
+	rp2040_release(RESETS_pio1);
+	rp2040_release(RESETS_dma);
+
+	/* Square wave generator on PIO1 SM0, GPIO15. The program has no jumps except
+	 * to address 1, so load it at 0.
+	*/
+	for ( int i = 0; i < 4; i++ )
+	{
+		rp2040_pio1.instr_mem[i] = squarewave[i];
+	}
+	rp2040_iobank0.gpio[15].ctrl = FUNCSEL_PIO1;
+
+	rp2040_piosm_cfg_t cfg;
+	rp2040_piosm_cfg_init(&cfg);
+	rp2040_piosm_cfg_clkdiv(&cfg, 65535, 0);
+	rp2040_piosm_cfg_set_pins(&cfg, 15, 1);
+	rp2040_piosm_cfg_wrap(&cfg, 0, 3);
+	rp2040_piosm_apply(&rp2040_pio1, 0, &cfg, 0);
+
+	/* Edge capture on PIO0
+	*/
+	if ( rp2040_edgecap_init(&cap, &rp2040_pio0, 0, pins, 2, 0, ringbuf, NWORDS) != 0 )
+	{
+		dh_puts("rp2040_edgecap_init() failed\n");
+		for (;;) { }
+	}
+	rp2040_edgecap_start(&cap);
+
+	rp2040_pio_enable(&rp2040_pio1, 1);
+
+	for (;;)
+	{
+		if ( rp2040_edgecap_read(&cap, &ev) )
+		{
+			dh_puts(ev.level ? "rise pin " : "fall pin ");
+			dh_putx32(ev.pin);
+			dh_puts("    time ");
+			dh_putx32((u32_t)ev.time);
+			dh_puts("      ns ");
+			dh_putx32(ev.ns);
+		}
+	}
+
+	return 0;
+}
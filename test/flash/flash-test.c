@@ -0,0 +1,106 @@
+/* flash-test.c - run from flash with hot code in RAM
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-uart.h"
+#include "rp2040-gpio.h"
+#include "rp2040-clocks.h"
+#include "rp2040-cm0.h"
+#include "test-io.h"
+
+/* Expected outcome of this test:
+ *
+ * The program is linked with ld/rp2040-flash.ldscript, so the UF2 file is written to the flash
+ * and the program starts again after a reset or power cycle.
+ *
+ * Async serial output at 115200-8N1 on GPIO 16
+ *	- "Test started ..."
+ *	- "main    " and the address of main(): 0x1000xxxx (flash)
+ *	- "hot     " and the address of hot_loop(): 0x2000xxxx (RAM, from .time_critical)
+ *	- "data    " and the value of an initialised variable: 0x12345678 (copied from flash)
+ *	- "flash   " and the SysTick cycles for 1000 iterations of the same loop in flash, twice.
+ *	  The first is likely to be slower because of XIP cache misses.
+ *	- "ram     " and the same for the loop in RAM, twice. Both should be the same as the second flash run.
+ *	- "Test finished"
+*/
+static volatile u32_t data_value = 0x12345678;
+
+#define LOOP_BODY(n)					\
+	do {								\
+		u32_t x = 0;					\
+		for ( u32_t i = 0; i < (n); i++ )	\
+			x += i ^ (x >> 3);			\
+		data_value = x;					\
+	} while (0)
+
+RP2040_TIME_CRITICAL static void hot_loop(u32_t n)
+{
+	LOOP_BODY(n);
+}
+
+static void cold_loop(u32_t n)
+{
+	LOOP_BODY(n);
+}
+
+static void time_it(const char *name, void (*fn)(u32_t))
+{
+	u32_t t0 = cxm_systick_read();
+	fn(1000);
+	u32_t t1 = cxm_systick_read();
+
+	dh_puts(name);
+	dh_putx32(cxm_systick_elapsed(t0, t1));
+}
+
+int main(void)
+{
+	/* Initialise uart0
+	*/
+	(void)rp2040_uart_init(&rp2040_uart0, 115200, "8N1");
+
+	/* Set up the I/O function for UART0
+	  * GPIO 16 = UART0 tx
+	  * GPIO 17 = UART0 rx
+	 */
+	rp2040_iobank0.gpio[16].ctrl = FUNCSEL_UART;
+	rp2040_iobank0.gpio[17].ctrl = FUNCSEL_UART;
+
+	dh_puts("Test started ...\n");
+
+	dh_puts("main    ");
+	dh_putx32((u32_t)&main);
+	dh_puts("hot     ");
+	dh_putx32((u32_t)&hot_loop);
+	dh_puts("data    ");
+	dh_putx32(data_value);
+
+	cxm_systick_start();
+	time_it("flash   ", cold_loop);
+	time_it("flash   ", cold_loop);
+	time_it("ram     ", hot_loop);
+	time_it("ram     ", hot_loop);
+
+	dh_puts("Test finished\n");
+
+	for (;;) {}
+
+	return 0;
+}
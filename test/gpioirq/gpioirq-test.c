@@ -0,0 +1,122 @@
+/* gpioirq-test.c - test program for the GPIO interrupt dispatcher
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-uart.h"
+#include "rp2040-gpio.h"
+#include "rp2040-sio.h"
+#include "rp2040-timer.h"
+#include "rp2040-delay.h"
+#include "rp2040-nvic.h"
+#include "rp2040-gpioirq.h"
+#include "test-io.h"
+
+/* Expected outcome of this test:
+ *
+ * GPIO 2 and GPIO 3 are SIO outputs. A pin's input (and hence its interrupt) follows its own output,
+ * so no wiring is needed.
+ *
+ * Async serial output at 115200-8N1 on GPIO 16
+ *	- "Test started ..."
+ *	- "edges   " 0x14: GPIO 2 is toggled 20 times, 100 us apart, with interrupts on both edges
+ *	- for the first four edges: the events (8 = rising, 4 = falling) and the time (us) from the
+ *	  toggle to the dispatcher, a few us
+ *	- "level   " 1: GPIO 3 is driven high with a level-high interrupt; the function disables the
+ *	  interrupt on its first call
+ *	- "Test finished"
+*/
+#define NEDGE		20
+#define PIN_EDGE	2
+#define PIN_LEVEL	3
+
+static volatile u32_t n_edges;
+static volatile u32_t n_levels;
+static u32_t edge_events[NEDGE];
+static u32_t edge_time[NEDGE];
+
+static void edge_fn(int pin, u32_t events, u32_t time)
+{
+	if ( n_edges < NEDGE )
+	{
+		edge_events[n_edges] = events;
+		edge_time[n_edges] = time;
+	}
+	n_edges++;
+}
+
+static void level_fn(int pin, u32_t events, u32_t time)
+{
+	rp2040_gpioirq_disable(pin);
+	n_levels++;
+}
+
+int main(void)
+{
+	u32_t t_toggle[NEDGE];
+
+	/* Initialise uart0
+	*/
+	(void)rp2040_uart_init(&rp2040_uart0, 115200, "8N1");
+
+	/* Set up the I/O function for UART0
+	  * GPIO 16 = UART0 tx
+	  * GPIO 17 = UART0 rx
+	 */
+	rp2040_iobank0.gpio[16].ctrl = FUNCSEL_UART;
+	rp2040_iobank0.gpio[17].ctrl = FUNCSEL_UART;
+
+	dh_puts("Test started ...\n");
+
+	rp2040_pin_init(PIN_EDGE, 1);
+	rp2040_pin_init(PIN_LEVEL, 1);
+	rp2040_gpioirq_init(NVIC_PRIO_0);
+
+	rp2040_gpioirq_set(PIN_EDGE, GPIO_IRQ_EDGE, edge_fn);
+	for ( int i = 0; i < NEDGE; i++ )
+	{
+		t_toggle[i] = rp2040_timer.time_lraw;
+		rp2040_sio.gpio_out.xor = 0x1 << PIN_EDGE;
+		rp2040_busy_wait_us(100);
+	}
+	rp2040_gpioirq_disable(PIN_EDGE);
+
+	dh_puts("edges   ");
+	dh_putx32(n_edges);
+	for ( int i = 0; i < 4; i++ )
+	{
+		dh_puts("events  ");
+		dh_putx32(edge_events[i]);
+		dh_puts("latency ");
+		dh_putx32(edge_time[i] - t_toggle[i]);
+	}
+
+	rp2040_gpioirq_set(PIN_LEVEL, GPIO_IRQ_LEVEL_HIGH, level_fn);
+	rp2040_sio.gpio_out.w1s = 0x1 << PIN_LEVEL;
+	rp2040_busy_wait_us(100);
+
+	dh_puts("level   ");
+	dh_putx32(n_levels);
+
+	dh_puts("Test finished\n");
+
+	for (;;) {}
+
+	return 0;
+}
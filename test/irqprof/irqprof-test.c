@@ -0,0 +1,137 @@
+/* irqprof-test.c - interrupt profiler example
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-uart.h"
+#include "rp2040-gpio.h"
+#include "rp2040-timer.h"
+#include "rp2040-nvic.h"
+#include "rp2040-irqprof.h"
+#include "rp2040-cm0.h"
+#include "test-io.h"
+
+/* Expected outcome of this test:
+ *
+ * Async serial output at 115200-8N1 on GPIO 16
+ *	- "Test started ..."
+ *	- every 2 seconds, the profile (see rp2040_irqprof_dump() for the format):
+ *		- IRQ 0 (alarm 0, every 1 ms): short execution times; its latency is mostly the critical
+ *		  sections in thread mode because it pre-empts everything else
+ *		- IRQ 1 (alarm 1, every 10 ms): execution times spread over several buckets, because the
+ *		  handler's busy loop varies. The maximum includes none of IRQ 0's time.
+ *		- IRQ 30 (soft IRQ, triggered by thread mode): latencies from the reference time
+ *		- a nesting depth of 2, and the longest critical section is the loop in main()
+ *
+ * This program is compiled with RP2040_IRQPROF=1, so the critical sections are measured.
+*/
+#define PERIOD0_US	1000
+#define PERIOD1_US	10000
+
+static u32_t next_alarm[2];
+static volatile u32_t busy;
+
+static void alarm0_handler(void)
+{
+	rp2040_timer.intcs.intr = 0x1;		/* w1c */
+	next_alarm[0] += PERIOD0_US;
+	rp2040_timer.alarm[0] = next_alarm[0];
+}
+
+static void alarm1_handler(void)
+{
+	rp2040_timer.intcs.intr = 0x2;		/* w1c */
+	next_alarm[1] += PERIOD1_US;
+	rp2040_timer.alarm[1] = next_alarm[1];
+
+	/* Slow handler: a busy loop of varying length
+	*/
+	for ( u32_t i = 0; i < (next_alarm[1] & 0x3ff); i++ )
+		busy++;
+}
+
+static void soft_handler(void)
+{
+	busy++;
+}
+
+int main(void)
+{
+	/* Initialise uart0
+	*/
+	(void)rp2040_uart_init(&rp2040_uart0, 115200, "8N1");
+
+	/* Set up the I/O function for UART0
+	  * GPIO 16 = UART0 tx
+	  * GPIO 17 = UART0 rx
+	 */
+	rp2040_iobank0.gpio[16].ctrl = FUNCSEL_UART;
+	rp2040_iobank0.gpio[17].ctrl = FUNCSEL_UART;
+
+	dh_puts("Test started ...\n");
+
+	rp2040_irqprof_init();
+
+	(void)rp2040_irq_set_handler(irq_timer0, alarm0_handler);
+	(void)rp2040_irq_set_handler(irq_timer1, alarm1_handler);
+	(void)rp2040_irq_set_handler(irq_30, soft_handler);
+	rp2040_irqprof_attach(irq_timer0);
+	rp2040_irqprof_attach(irq_timer1);
+	rp2040_irqprof_attach(irq_30);
+
+	rp2040_nvic_set_priority(irq_timer0, NVIC_PRIO_0);
+	rp2040_nvic_set_priority(irq_timer1, NVIC_PRIO_1);
+	rp2040_nvic_set_priority(irq_30, NVIC_PRIO_3);
+
+	rp2040_timer.intcs.inte |= 0x3;
+	next_alarm[0] = rp2040_timer.time_lraw + PERIOD0_US;
+	next_alarm[1] = next_alarm[0] + PERIOD1_US/2;
+	rp2040_timer.alarm[0] = next_alarm[0];
+	rp2040_timer.alarm[1] = next_alarm[1];
+
+	rp2040_nvic_enable(irq_timer0);
+	rp2040_nvic_enable(irq_timer1);
+	rp2040_nvic_enable(irq_30);
+
+	u32_t next_dump = rp2040_timer.time_lraw + 2000000;
+
+	for (;;)
+	{
+		/* A critical section in thread mode
+		*/
+		intstatus_t is = disable();
+		for ( int i = 0; i < 200; i++ )
+			busy++;
+		restore(is);
+
+		/* Trigger the soft IRQ
+		*/
+		rp2040_irqprof_ref(irq_30);
+		rp2040_nvic_pend(irq_30);
+
+		if ( (s32_t)(rp2040_timer.time_lraw - next_dump) >= 0 )
+		{
+			next_dump += 2000000;
+			rp2040_irqprof_dump(dh_putc);
+			rp2040_irqprof_reset();
+		}
+	}
+
+	return 0;
+}
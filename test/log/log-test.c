@@ -0,0 +1,138 @@
+/* log-test.c - deferred binary logging
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-uart.h"
+#include "rp2040-gpio.h"
+#include "rp2040-sio.h"
+#include "rp2040-clocks.h"
+#include "rp2040-bench.h"
+#include "rp2040-printf.h"
+#include "rp2040-log.h"
+#include "test-io.h"
+
+/* Expected outcome of this test:
+ *
+ * Async serial output at 115200-8N1 on GPIO 16, mixed text and binary log records. Decode it with
+ *	build/logdecode build/log-test.elf < /dev/ttyUSB0
+ * The output is then:
+ *	- "Test started ..."
+ *	- "0 <time>: log-test: clk_sys <frequency> Hz, <ring size> words per core"
+ *	- "0 <time>: <name>: median <n> cycles", one per benchmark:
+ *		log0		RP2040_LOG0()
+ *		log2		RP2040_LOG2()
+ *		log4		RP2040_LOG4()
+ *		snprintf2	rp2040_snprintf() of a similar message with two numbers, for comparison
+ *	- "0 <time>: <171 records dropped>" after overfilling the ring (85 records of 3 words fit),
+ *		then "0 <time>: ring full at 256"
+ *	- the BENCH lines (see rp2040-bench.h)
+ *	- "Test finished"
+*/
+static volatile u32_t x = 12345;
+static char buf[64];
+
+static void log_discard(void *arg)
+{
+	rp2040_logring[0].tail = rp2040_logring[0].head;
+}
+
+static void bench_log0(void *arg)
+{
+	RP2040_LOG0("event");
+}
+
+static void bench_log2(void *arg)
+{
+	RP2040_LOG2("x=%u y=%x", x, x);
+}
+
+static void bench_log4(void *arg)
+{
+	RP2040_LOG4("%u %u %u %u", x, x, x, x);
+}
+
+static void bench_snprintf2(void *arg)
+{
+	(void)rp2040_snprintf(buf, sizeof(buf), "x=%lu y=%lx", x, x);
+}
+
+static const rp2040_bench_t benchmarks[] =
+{	/*	name			fn					setup			arg		warm	rep	flags	*/
+	{	"log0",			bench_log0,			log_discard,	0,		2,		16,	0	},
+	{	"log2",			bench_log2,			log_discard,	0,		2,		16,	0	},
+	{	"log4",			bench_log4,			log_discard,	0,		2,		16,	0	},
+	{	"snprintf2",	bench_snprintf2,	0,				0,		2,		16,	0	}
+};
+
+#define NBENCH	(sizeof(benchmarks)/sizeof(benchmarks[0]))
+
+int main(void)
+{
+	rp2040_benchresult_t results[NBENCH];
+	int n;
+
+	/* Initialise uart0
+	*/
+	(void)rp2040_uart_init(&rp2040_uart0, 115200, "8N1");
+
+	/* Set up the I/O function for UART0
+	  * GPIO 16 = UART0 tx
+	  * GPIO 17 = UART0 rx
+	 */
+	rp2040_iobank0.gpio[16].ctrl = FUNCSEL_UART;
+	rp2040_iobank0.gpio[17].ctrl = FUNCSEL_UART;
+
+	dh_puts("Test started ...\n");
+
+	rp2040_bench_init();
+
+	for ( unsigned i = 0; i < NBENCH; i++ )
+		rp2040_bench_run(&benchmarks[i], &results[i]);
+
+	RP2040_LOG2("log-test: clk_sys %u Hz, %u words per core", rp2040_clk_sys_hz(), RP2040_LOG_SIZE);
+	for ( unsigned i = 0; i < NBENCH; i++ )
+		RP2040_LOG2("%s: median %u cycles", benchmarks[i].name, results[i].median);
+
+	/* Send the records so far, then overfill the ring
+	*/
+	while ( rp2040_log_poll(&rp2040_uart0) )
+	{
+	}
+
+	for ( n = 0; n < RP2040_LOG_SIZE; n++ )
+		RP2040_LOG1("filling %u", n);
+
+	/* Throw the records away: the drain reports the drops, then the next record
+	*/
+	log_discard(0);
+	RP2040_LOG1("ring full at %u", n);
+	while ( rp2040_log_poll(&rp2040_uart0) )
+	{
+	}
+
+	for ( unsigned i = 0; i < NBENCH; i++ )
+		rp2040_bench_report(&benchmarks[i], &results[i], dh_putc);
+
+	dh_puts("Test finished\n");
+
+	for (;;) {}
+
+	return 0;
+}
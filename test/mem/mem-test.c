@@ -0,0 +1,159 @@
+/* mem-test.c - pools and arenas, used by both cores
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-uart.h"
+#include "rp2040-gpio.h"
+#include "rp2040-sio.h"
+#include "rp2040-mem.h"
+#include "test-io.h"
+
+/* Expected outcome of this test:
+ *
+ * Async serial output at 115200-8N1 on GPIO 16
+ *	- "Test started ..."
+ *	- "Core 1 started ..."
+ *	- both cores allocate and free blocks from the same pool as fast as they can. Then:
+ *		"pool    " n_blocks, "used    " 0, "max     " the high watermark (8 or less), "fail    " 0,
+ *		"errors  " 0 (the number of blocks that were corrupted by the other core)
+ *	- "heap    " the size of the free RAM, then "arena   " 0x300 (the arena usage after three allocations),
+ *		"mark    " 0x300 again after an allocation and a release, then "reset   " 0
+ *	- "Test finished"
+*/
+#define NBLOCK		16
+#define BLOCKSIZE	32
+#define NLOOP		10000
+
+typedef struct block_s
+{
+	u32_t w[BLOCKSIZE/4];
+} block_t;
+
+static u32_t pool_mem[RP2040_POOL_MEM(BLOCKSIZE, NBLOCK)];
+static rp2040_pool_t pool;
+static rp2040_arena_t arena;
+
+/* exercise() - allocate, fill, check and free blocks
+ *
+ * Each core holds up to 4 blocks at a time, so the pool never runs out.
+ * Returns the number of words that didn't contain the expected value.
+*/
+static u32_t exercise(u32_t sig)
+{
+	block_t *b[4];
+	u32_t errors = 0;
+
+	for ( int n = 0; n < NLOOP; n++ )
+	{
+		for ( int i = 0; i < 4; i++ )
+		{
+			b[i] = rp2040_pool_alloc(&pool);
+			for ( int j = 0; j < BLOCKSIZE/4; j++ )
+				b[i]->w[j] = sig + n;
+		}
+		for ( int i = 0; i < 4; i++ )
+		{
+			for ( int j = 0; j < BLOCKSIZE/4; j++ )
+				if ( b[i]->w[j] != sig + n )
+					errors++;
+			rp2040_pool_free(&pool, b[i]);
+		}
+	}
+	return errors;
+}
+
+int main(void)
+{
+	u32_t errors;
+
+	/* Initialise uart0
+	*/
+	(void)rp2040_uart_init(&rp2040_uart0, 115200, "8N1");
+
+	/* Set up the I/O function for UART0
+	  * GPIO 16 = UART0 tx
+	  * GPIO 17 = UART0 rx
+	 */
+	rp2040_iobank0.gpio[16].ctrl = FUNCSEL_UART;
+	rp2040_iobank0.gpio[17].ctrl = FUNCSEL_UART;
+
+	dh_puts("Test started ...\n");
+
+	(void)rp2040_pool_init(&pool, pool_mem, sizeof(pool_mem), BLOCKSIZE, RP2040_SPINLOCK_MEM);
+
+	if ( rp2040_start_core1() != 0 )
+	{
+		dh_puts("Core 1 didn't start\n");
+		for (;;) {}
+	}
+
+	errors = exercise(0x00000000);
+
+	while ( (rp2040_sio.fifo_st & SIO_FIFO_VLD) == 0 )
+	{	/* Wait for core 1 */
+	}
+	errors += rp2040_sio.fifo_rd;
+
+	dh_puts("pool    ");
+	dh_putx32(pool.n_blocks);
+	dh_puts("used    ");
+	dh_putx32(pool.n_used);
+	dh_puts("max     ");
+	dh_putx32(pool.max_used);
+	dh_puts("fail    ");
+	dh_putx32(pool.n_fail);
+	dh_puts("errors  ");
+	dh_putx32(errors);
+
+	rp2040_arena_init_heap(&arena, RP2040_SPINLOCK_MEM);
+	dh_puts("heap    ");
+	dh_putx32(arena.size);
+
+	(void)rp2040_arena_alloc(&arena, 0x100);
+	(void)rp2040_arena_alloc(&arena, 0xfd);		/* Rounded up to 0x100 by the next allocation */
+	(void)rp2040_arena_alloc(&arena, 0x100);
+	dh_puts("arena   ");
+	dh_putx32(arena.used);
+
+	u32_t mark = rp2040_arena_mark(&arena);
+	(void)rp2040_arena_alloc(&arena, 0x1000);
+	rp2040_arena_release(&arena, mark);
+	dh_puts("mark    ");
+	dh_putx32(arena.used);
+
+	rp2040_arena_reset(&arena);
+	dh_puts("reset   ");
+	dh_putx32(arena.used);
+
+	dh_puts("Test finished\n");
+
+	for (;;) {}
+
+	return 0;
+}
+
+int main1(void)
+{
+	dh_puts("Core 1 started ...\n");
+
+	rp2040_sio.fifo_wr = exercise(0x10000000);
+
+	for (;;) {}
+}
@@ -50,7 +50,11 @@ int main(void)
 
 	dh_puts("Test started ...\n");
 
-	rp2040_start_core1();
+	if ( rp2040_start_core1() != 0 )
+	{
+		dh_puts("Core 1 didn't start\n");
+		for (;;) {}
+	}
 
 	for ( unsigned i = 0; i < 10; i++ )		/* unsigned because there's a bitwise operation on it */
 	{
@@ -0,0 +1,132 @@
+/* nvic-test.c - testing NVIC priorities and run-time handler registration
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-uart.h"
+#include "rp2040-gpio.h"
+#include "rp2040-nvic.h"
+#include "test-io.h"
+
+/* Expected outcome of this test:
+ *
+ * Async serial output at 115200-8N1 on GPIO 16
+ *	- "Test started ..."
+ *	- "OK" for each of the three cases below, followed by "Finished"
+ *
+ * The test uses the software-triggered IRQs 26 and 31 with handlers installed at run time.
+ *	1. Low-priority handler pends a high-priority IRQ: the high-priority handler pre-empts it
+ *	2. High-priority handler pends a low-priority IRQ: the low-priority handler runs afterwards
+ *	3. Same priority: no pre-emption; the second handler runs afterwards
+*/
+static volatile int seq[8];
+static volatile int nseq;
+
+static void step(int s)
+{
+	if ( nseq < 8 )
+		seq[nseq] = s;
+	nseq++;
+}
+
+/* Handlers for IRQ 26 and 31. The test cases set pend_from_26 and pend_from_31 to select which handler
+ * pends the other IRQ.
+*/
+static volatile boolean_t pend_from_26;
+static volatile boolean_t pend_from_31;
+
+static void handler_26(void)
+{
+	step(26);
+	if ( pend_from_26 )
+	{
+		rp2040_nvic_pend(irq_31);
+		step(-26);
+	}
+}
+
+static void handler_31(void)
+{
+	step(31);
+	if ( pend_from_31 )
+	{
+		rp2040_nvic_pend(irq_26);
+		step(-31);
+	}
+}
+
+static void run_case(const char *name, u32_t prio26, u32_t prio31, irqid_t first, const int *expect)
+{
+	nseq = 0;
+	pend_from_26 = (first == irq_26);
+	pend_from_31 = (first == irq_31);
+	rp2040_nvic_set_priority(irq_26, prio26);
+	rp2040_nvic_set_priority(irq_31, prio31);
+
+	rp2040_nvic_pend(first);
+	__asm__ volatile("dsb; isb");
+
+	/* Both handlers have finished by now, because thread mode has the lowest priority.
+	*/
+	dh_puts(name);
+	for ( int i = 0; i < 3; i++ )
+	{
+		if ( nseq != 3 || seq[i] != expect[i] )
+		{
+			dh_puts(" FAIL\n");
+			return;
+		}
+	}
+	dh_puts(" OK\n");
+}
+
+static const int expect_preempt[3] = { 31, 26, -31 };
+static const int expect_tail[3] = { 26, -26, 31 };
+static const int expect_same[3] = { 31, -31, 26 };
+
+int main(void)
+{
+	/* Initialise uart0
+	*/
+	(void)rp2040_uart_init(&rp2040_uart0, 115200, "8N1");
+
+	/* Set up the I/O function for UART0
+	  * GPIO 16 = UART0 tx
+	  * GPIO 17 = UART0 rx
+	 */
+	rp2040_iobank0.gpio[16].ctrl = FUNCSEL_UART;
+	rp2040_iobank0.gpio[17].ctrl = FUNCSEL_UART;
+
+	dh_puts("Test started ...\n");
+
+	(void)rp2040_irq_set_handler(irq_26, handler_26);
+	(void)rp2040_irq_set_handler(irq_31, handler_31);
+	rp2040_nvic_enable(irq_26);
+	rp2040_nvic_enable(irq_31);
+
+	run_case("1. pre-emption", NVIC_PRIO_0, NVIC_PRIO_3, irq_31, expect_preempt);
+	run_case("2. tail-chain", NVIC_PRIO_0, NVIC_PRIO_3, irq_26, expect_tail);
+	run_case("3. same priority", NVIC_PRIO_2, NVIC_PRIO_2, irq_31, expect_same);
+
+	dh_puts("Finished\n");
+
+	for (;;) { }
+
+	return 0;
+}
@@ -0,0 +1,119 @@
+/* pins-test.c - test program for the multi-pin GPIO functions
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-uart.h"
+#include "rp2040-gpio.h"
+#include "rp2040-sio.h"
+#include "rp2040-cm0.h"
+#include "rp2040-delay.h"
+#include "test-io.h"
+
+/* Expected outcome of this test:
+ *
+ * GPIO 2 to GPIO 9 form an 8-bit output bus and GPIO 10 is a strobe. A pin's input follows its own
+ * output, so the values can be read back without any wiring. Connect a logic analyser to see the
+ * strobe pulses and the values; no bus pin changes while the others are settling.
+ *
+ * Async serial output at 115200-8N1 on GPIO 16
+ *	- "Test started ..."
+ *	- "errors  " 0: out-of-range buses are rejected, and each of the 256 values is written to the bus
+ *	  and read back
+ *	- "other   " 0: the pins outside the bus don't change
+ *	- "cycles  " and the SysTick cycles for 256 writes with a strobe pulse each (a few cycles per write)
+ *	- "Test finished"
+*/
+#define BUS_FIRST	2
+#define BUS_WIDTH	8
+#define PIN_STROBE	10
+
+static rp2040_bus_t bus;
+
+static void write_all(void)
+{
+	for ( u32_t v = 0; v < 256; v++ )
+	{
+		rp2040_bus_write(&bus, v);
+		rp2040_pins_set(0x1 << PIN_STROBE);
+		rp2040_pins_clr(0x1 << PIN_STROBE);
+	}
+}
+
+int main(void)
+{
+	u32_t errors = 0;
+	u32_t other = 0;
+
+	/* Initialise uart0
+	*/
+	(void)rp2040_uart_init(&rp2040_uart0, 115200, "8N1");
+
+	/* Set up the I/O function for UART0
+	  * GPIO 16 = UART0 tx
+	  * GPIO 17 = UART0 rx
+	 */
+	rp2040_iobank0.gpio[16].ctrl = FUNCSEL_UART;
+	rp2040_iobank0.gpio[17].ctrl = FUNCSEL_UART;
+
+	dh_puts("Test started ...\n");
+
+	/* Buses that don't fit in GPIO0 to GPIO29 must be rejected.
+	*/
+	if ( rp2040_bus_init(&bus, 0, 0, 1) == 0 || rp2040_bus_init(&bus, 24, 8, 1) == 0 )
+		errors++;
+
+	if ( rp2040_bus_init(&bus, BUS_FIRST, BUS_WIDTH, 1) != 0 )
+		errors++;
+	rp2040_pins_init(0x1 << PIN_STROBE, 1);
+
+	u32_t out = rp2040_sio.gpio_out.val & ~bus.mask;
+
+	for ( u32_t v = 0; v < 256; v++ )
+	{
+		rp2040_bus_write(&bus, v | 0xffffff00);		/* The upper bits must be ignored */
+		rp2040_pins_toggle(0x1 << PIN_STROBE);
+		rp2040_pins_toggle(0x1 << PIN_STROBE);
+		rp2040_busy_wait_cycles(10);		/* The inputs are synchronised to clk_sys */
+
+		if ( rp2040_bus_read(&bus) != v )
+			errors++;
+		if ( (rp2040_sio.gpio_out.val & ~bus.mask) != out )
+			other++;
+	}
+
+	dh_puts("errors  ");
+	dh_putx32(errors);
+	dh_puts("other   ");
+	dh_putx32(other);
+
+	cxm_systick_start();
+	u32_t t0 = cxm_systick_read();
+	write_all();
+	u32_t t1 = cxm_systick_read();
+
+	dh_puts("cycles  ");
+	dh_putx32(cxm_systick_elapsed(t0, t1));
+
+	dh_puts("Test finished\n");
+
+	for (;;) {}
+
+	return 0;
+}
@@ -44,9 +44,6 @@
 */
 #define SM	3		/* Use state machine 3 (of PIO0) */
 
-#define	FSTAT_TXEMPTY	(1 << (24+SM))
-#define	FSTAT_TXFULL	(1 << (16+SM))
-
 static void pio_fifo_write(u32_t v);
 
 int main(void)
@@ -85,20 +82,20 @@ int main(void)
 	}
 
 	/* Set up the PIO state machine
+	 *	- 10 kHz clock
+	 *	- OUT pins is 1 pin starting at pin 15
+	 *	- OSR shifts left, autopull at 32 bits
+	 *	- wrap addresses from the program, relocated to start_addr
 	*/
-	rp2040_pio0.sm[SM].clkdiv = 13300 << 16;		/* 10 kHz clock */
-	rp2040_pio0.sm[SM].pinctrl = (1 << 20) | 15;	/* PINS is 1 pin starting at pin 15 */
-	rp2040_pio0.sm[SM].shiftctrl = (1 << 17);		/* PULL_THRESH=32  OUT_SHIFTDIR=L  AUTOPULL */
-
-	/* 
-	 * WRAP_BOTTOM = (start_addr + shifter_wrap_target)
-	 * WRAP_TOP = (start_addr + shifter_wrap)
-	*/
-	rp2040_pio0.sm[SM].execctrl = ((start_addr + shifter_wrap) << 12) | ((start_addr + shifter_wrap_target) << 7);
-	rp2040_pio0.sm[SM].instr = (PIO_JMP | PIO_JMP_ALWAYS | start_addr);
-
-	rp2040_pio0_w1s.ctrl = (1 << SM);
+	rp2040_piosm_cfg_t cfg;
+	rp2040_piosm_cfg_init(&cfg);
+	(void)rp2040_piosm_cfg_freq(&cfg, 10000);
+	rp2040_piosm_cfg_out_pins(&cfg, 15, 1);
+	rp2040_piosm_cfg_out_shift(&cfg, 0, 1, 32);
+	rp2040_piosm_cfg_wrap(&cfg, start_addr + shifter_wrap_target, start_addr + shifter_wrap);
 
+	rp2040_piosm_apply(&rp2040_pio0, SM, &cfg, start_addr);
+	rp2040_pio_enable(&rp2040_pio0, 1 << SM);
 
 	for (;;)
 	{
@@ -118,7 +115,7 @@ int main(void)
 
 static void pio_fifo_write(u32_t v)
 {
-	while ( (rp2040_pio0.fstat & FSTAT_TXFULL) != 0 )
+	while ( (rp2040_pio0.fstat & PIO_FSTAT_TXFULL(SM)) != 0 )
 	{
 		/* Wait */
 	}
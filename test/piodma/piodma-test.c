@@ -0,0 +1,157 @@
+/* piodma-test.c - testing PIO streaming with DMA
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-uart.h"
+#include "rp2040-gpio.h"
+#include "rp2040-clocks.h"
+#include "rp2040-resets.h"
+#include "rp2040-pio.h"
+#include "rp2040-dma.h"
+#include "rp2040-piodma.h"
+#include "rp2040-sio.h"
+#include "rp2040-timer.h"
+#include "test-io.h"
+
+#include "piodma-test.h"
+
+/* Expected outcome of this test:
+ *
+ * Async serial output at 115200-8N1 on GPIO 16
+ *	- "Test started ..."
+ *	- Once per second, the position of the ring stream (changes between lines)
+ *	- One asterisk for each buffer refilled by the CPU (one every 12.8 ms)
+ *
+ * Waveform appears on GPIO15 (ring stream, no CPU involvement)
+ *	- low  6.4 ms
+ *	- high 0.4 ms
+ *	- low  2.0 ms
+ *	- high 4.0 ms
+ *	- repeats endlessly
+ *
+ * Waveform appears on GPIO14 (double-buffered stream)
+ *	- a 32-bit counter, MSB first, 4 words per buffer. The counter increments each time a
+ *	  buffer is refilled
+ *
+ * Both state machines run the same program (shifter.pio from the pio test) at 10 kHz.
+*/
+#define SM_RING		3		/* PIO0 SM3 on GPIO15 */
+#define SM_DBL		2		/* PIO0 SM2 on GPIO14 */
+
+#define NWORDS		4
+
+static u32_t ring_buf[NWORDS] = { 0x00000000, 0x00000000, 0xf00000ff, 0xffffffff };
+static u32_t dbl_buf[2][NWORDS];
+
+static rp2040_piodma_t ring_stream;
+static rp2040_piodma_t dbl_stream;
+
+static u32_t counter;
+
+static void fill(u32_t *buf);
+static void sm_init(int sm, int pin, u32_t start_addr);
+
+int main(void)
+{
+	/* Initialise uart0
+	*/
+	(void)rp2040_uart_init(&rp2040_uart0, 115200, "8N1");
+
+	/* Set up the I/O function for UART0
+	  * GPIO 16 = UART0 tx
+	  * GPIO 17 = UART0 rx
+	 */
+	rp2040_iobank0.gpio[16].ctrl = FUNCSEL_UART;
+	rp2040_iobank0.gpio[17].ctrl = FUNCSEL_UART;
+
+	dh_puts("Test started ...\n");
+
+	rp2040_release(RESETS_pio0);
+	rp2040_release(RESETS_dma);
+
+	/* Load the program at 0
+	*/
+	u16_t start_addr = 0;
+	for ( int i = 0; i < sizeof(shifter_program_instructions)/sizeof(shifter_program_instructions[0]); i++)
+	{
+		rp2040_pio0.instr_mem[start_addr + i] = shifter_program_instructions[i];
+	}
+
+	sm_init(SM_RING, 15, start_addr);
+	sm_init(SM_DBL, 14, start_addr);
+
+	/* Start the streams before the state machines so that the FIFOs are full when they start.
+	*/
+	rp2040_piodma_ring(&ring_stream, &rp2040_pio0, SM_RING, RP2040_PIODMA_TX, 0, 1, ring_buf, NWORDS);
+
+	fill(dbl_buf[0]);
+	fill(dbl_buf[1]);
+	rp2040_piodma_double(&dbl_stream, &rp2040_pio0, SM_DBL, RP2040_PIODMA_TX, 2, 3,
+							dbl_buf[0], dbl_buf[1], NWORDS);
+
+	rp2040_pio_enable(&rp2040_pio0, (1 << SM_RING) | (1 << SM_DBL));
+
+	u32_t t0 = (u32_t)rp2040_read_time();
+	for (;;)
+	{
+		int b = rp2040_piodma_poll(&dbl_stream);
+		if ( b >= 0 )
+		{
+			fill(dbl_buf[b]);
+			dh_putc('*');
+		}
+
+		if ( ((u32_t)rp2040_read_time() - t0) >= 1000000 )
+		{
+			t0 += 1000000;
+			dh_puts("\nring position ");
+			dh_putx32(rp2040_piodma_position(&ring_stream));
+		}
+	}
+
+	return 0;
+}
+
+/* sm_init() - set up a state machine to run shifter.pio on the given pin
+ *
+ * The TX FIFO is joined to give the DMA more slack.
+*/
+static void sm_init(int sm, int pin, u32_t start_addr)
+{
+	rp2040_iobank0.gpio[pin].ctrl = FUNCSEL_PIO0 | OEOVER_ENABLE;
+
+	rp2040_piosm_cfg_t cfg;
+	rp2040_piosm_cfg_init(&cfg);
+	(void)rp2040_piosm_cfg_freq(&cfg, 10000);
+	rp2040_piosm_cfg_out_pins(&cfg, pin, 1);
+	rp2040_piosm_cfg_out_shift(&cfg, 0, 1, 32);
+	rp2040_piosm_cfg_fifo_join(&cfg, PIO_FJOIN_TX);
+	rp2040_piosm_cfg_wrap(&cfg, start_addr + shifter_wrap_target, start_addr + shifter_wrap);
+	rp2040_piosm_apply(&rp2040_pio0, sm, &cfg, start_addr);
+}
+
+static void fill(u32_t *buf)
+{
+	for ( int i = 0; i < NWORDS; i++ )
+	{
+		buf[i] = counter;
+	}
+	counter++;
+}
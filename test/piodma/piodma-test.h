@@ -0,0 +1,30 @@
+/* piodma-test.h - header file for RP2040 PIO DMA test
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef PIODMA_TEST_H
+#define PIODMA_TEST_H	1
+
+/* Set up environment and include header file generated by pioasm
+*/
+#define PICO_NO_HARDWARE	1
+#define uint16_t			u16_t
+
+#include "build/shifter.pio.h"
+
+#endif
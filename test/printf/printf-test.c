@@ -0,0 +1,157 @@
+/* printf-test.c - formatted output
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-uart.h"
+#include "rp2040-gpio.h"
+#include "rp2040-sio.h"
+#include "rp2040-bench.h"
+#include "rp2040-printf.h"
+#include "test-io.h"
+
+/* Expected outcome of this test:
+ *
+ * Async serial output at 115200-8N1 on GPIO 16
+ *	- "Test started ..."
+ *	- "errors 0" (the number of conversions that didn't give the expected string)
+ *	- "printf -42 0x0000002a 18446744073709551615 [ab   ]", formatted directly to the UART
+ *	- one BENCH line per benchmark (see rp2040-bench.h), all times in CPU cycles:
+ *		text		a 32-character string without conversions, to a buffer
+ *		str			%s with a 32-character string, to a buffer
+ *		u32			%u of 4000000000 (10 digits), to a buffer
+ *		u64			%llu of 2^64-1 (20 digits), to a buffer
+ *	- "cycles/char" for each benchmark: the median divided by the number of characters. Compare
+ *		with the budget in rp2040-printf.h.
+ *	- "Test finished"
+*/
+static char buf[64];
+static const char str32[] = "abcdefghijklmnopqrstuvwxyz012345";
+
+static int n_err;
+
+/* check() - format into a buffer and compare with the expected string
+*/
+static void check(const char *expect, const char *fmt, ...)
+{
+	va_list ap;
+	int i;
+
+	va_start(ap, fmt);
+	(void)rp2040_vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+
+	for ( i = 0; expect[i] != '\0' && expect[i] == buf[i]; i++ )
+	{
+	}
+
+	if ( expect[i] != buf[i] )
+	{
+		n_err++;
+		rp2040_printf(dh_putc, "FAIL \"%s\": \"%s\", expected \"%s\"\n", fmt, buf, expect);
+	}
+}
+
+static void bench_text(void *arg)
+{
+	(void)rp2040_snprintf(buf, sizeof(buf), "abcdefghijklmnopqrstuvwxyz012345");
+}
+
+static void bench_str(void *arg)
+{
+	(void)rp2040_snprintf(buf, sizeof(buf), "%s", str32);
+}
+
+static void bench_u32(void *arg)
+{
+	(void)rp2040_snprintf(buf, sizeof(buf), "%lu", 4000000000ul);
+}
+
+static void bench_u64(void *arg)
+{
+	(void)rp2040_snprintf(buf, sizeof(buf), "%llu", 18446744073709551615ull);
+}
+
+static const rp2040_bench_t benchmarks[] =
+{	/*	name		fn				setup	arg		warm	rep	flags	*/
+	{	"text",		bench_text,		0,		0,		2,		16,	0	},
+	{	"str",		bench_str,		0,		0,		2,		16,	0	},
+	{	"u32",		bench_u32,		0,		0,		2,		16,	0	},
+	{	"u64",		bench_u64,		0,		0,		2,		16,	0	}
+};
+
+static const u32_t n_char[] = { 32, 32, 10, 20 };
+
+#define NBENCH	(sizeof(benchmarks)/sizeof(benchmarks[0]))
+
+int main(void)
+{
+	rp2040_benchresult_t results[NBENCH];
+	char small[8];
+
+	/* Initialise uart0
+	*/
+	(void)rp2040_uart_init(&rp2040_uart0, 115200, "8N1");
+
+	/* Set up the I/O function for UART0
+	  * GPIO 16 = UART0 tx
+	  * GPIO 17 = UART0 rx
+	 */
+	rp2040_iobank0.gpio[16].ctrl = FUNCSEL_UART;
+	rp2040_iobank0.gpio[17].ctrl = FUNCSEL_UART;
+
+	dh_puts("Test started ...\n");
+
+	check("hello", "hello");
+	check("0 -1 2147483647 -2147483648", "%d %d %d %d", 0, -1, 2147483647, (int)0x80000000);
+	check("4294967295", "%lu", 0xfffffffful);
+	check("10000 100000000 1000000000", "%u %u %u", 10000u, 100000000u, 1000000000u);
+	check("deadbeef DEADBEEF 00001234", "%lx %lX %08x", 0xdeadbeeful, 0xdeadbeeful, 0x1234u);
+	check("18446744073709551615", "%llu", 18446744073709551615ull);
+	check("-9223372036854775808", "%lld", (long long)0x8000000000000000ull);
+	check("4294967296 123456789abcdef0", "%llu %llx", 4294967296ull, 0x123456789abcdef0ull);
+	check("   42|42   |00042|-0042", "%5d|%-5d|%05d|%05d", 42, 42, 42, -42);
+	check("     7|7     |", "%*d|%*d|", 6, 7, -6, 7);
+	check("abc|       abc|abc       |x%", "%s|%10s|%-10s|%c%%", "abc", "abc", "abc", 'x');
+	check("0x20000000", "%p", (void *)0x20000000);
+
+	if ( rp2040_snprintf(small, sizeof(small), "%s", "0123456789") != 10 || small[7] != '\0' || small[6] != '6' )
+		n_err++;
+
+	rp2040_printf(dh_putc, "errors %d\n", n_err);
+	rp2040_printf(dh_putc, "printf %d 0x%08x %llu [%-5s]\n", -42, 42, 18446744073709551615ull, "ab");
+
+	rp2040_bench_init();
+
+	for ( unsigned i = 0; i < NBENCH; i++ )
+		rp2040_bench_run(&benchmarks[i], &results[i]);
+
+	for ( unsigned i = 0; i < NBENCH; i++ )
+		rp2040_bench_report(&benchmarks[i], &results[i], dh_putc);
+
+	for ( unsigned i = 0; i < NBENCH; i++ )
+		rp2040_printf(dh_putc, "cycles/char %-5s %lu\n", benchmarks[i].name,
+														rp2040_udiv(results[i].median, n_char[i], 0));
+
+	dh_puts("Test finished\n");
+
+	for (;;) {}
+
+	return 0;
+}
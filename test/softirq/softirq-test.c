@@ -0,0 +1,98 @@
+/* softirq-test.c - testing deferred work on soft IRQs
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-uart.h"
+#include "rp2040-gpio.h"
+#include "rp2040-timer.h"
+#include "rp2040-nvic.h"
+#include "rp2040-softirq.h"
+#include "test-io.h"
+
+/* Expected outcome of this test:
+ *
+ * Async serial output at 115200-8N1 on GPIO 16
+ *	- "Test started ..."
+ *	- every 100 ms: the number of alarms so far and the time (us) from posting to running the work
+ *
+ * Timer alarm 0 interrupts at the highest priority every 100 ms. The handler only clears the
+ * interrupt, re-arms the alarm and posts a work item to soft IRQ 31 at the lowest priority.
+ * The work function does the (slow) printing.
+*/
+#define PERIOD_US	100000
+
+static rp2040_work_t tick_work;
+static volatile u32_t n_alarms;
+static volatile u32_t t_posted;
+static u32_t next_alarm;
+
+static void alarm_handler(void)
+{
+	rp2040_timer.intcs.intr = 0x1;		/* w1c */
+	next_alarm += PERIOD_US;
+	rp2040_timer.alarm[0] = next_alarm;
+
+	n_alarms++;
+	t_posted = rp2040_timer.time_lraw;
+	(void)rp2040_work_post(irq_31, &tick_work);
+}
+
+static void tick_fn(rp2040_work_t *w)
+{
+	u32_t latency = rp2040_timer.time_lraw - t_posted;
+
+	dh_puts("alarms  ");
+	dh_putx32(n_alarms);
+	dh_puts("latency ");
+	dh_putx32(latency);
+}
+
+int main(void)
+{
+	/* Initialise uart0
+	*/
+	(void)rp2040_uart_init(&rp2040_uart0, 115200, "8N1");
+
+	/* Set up the I/O function for UART0
+	  * GPIO 16 = UART0 tx
+	  * GPIO 17 = UART0 rx
+	 */
+	rp2040_iobank0.gpio[16].ctrl = FUNCSEL_UART;
+	rp2040_iobank0.gpio[17].ctrl = FUNCSEL_UART;
+
+	dh_puts("Test started ...\n");
+
+	rp2040_work_init(&tick_work, tick_fn);
+	(void)rp2040_softirq_init(irq_31, NVIC_PRIO_3);
+
+	(void)rp2040_irq_set_handler(irq_timer0, alarm_handler);
+	rp2040_nvic_set_priority(irq_timer0, NVIC_PRIO_0);
+	rp2040_timer.intcs.inte |= 0x1;
+	next_alarm = rp2040_timer.time_lraw + PERIOD_US;
+	rp2040_timer.alarm[0] = next_alarm;
+	rp2040_nvic_enable(irq_timer0);
+
+	for (;;)
+	{
+		__asm__ volatile("wfi");
+	}
+
+	return 0;
+}
@@ -0,0 +1,120 @@
+/* stack-test.c - stack painting and high-water marks
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-uart.h"
+#include "rp2040-gpio.h"
+#include "rp2040-sio.h"
+#include "rp2040-stack.h"
+#include "test-io.h"
+
+/* Expected outcome of this test:
+ *
+ * Async serial output at 115200-8N1 on GPIO 16
+ *	- "Test started ..."
+ *	- "psp0    " core 0's process stack high-water mark so far
+ *	- "psp0    " the mark after a function with a 1 KiB local array; at least 0x400 more than before
+ *	- "Core 1 started ..."
+ *	- "thread  " 0x100: the mark of a painted array that has been partly used
+ *	- the report from rp2040_stack_report(), one line per stack:
+ *		STACK,<name>,<size>,<max used>
+ *	- "Test finished"
+ *
+ * "make report" prints the worst-case stack usage of main(), main1(), the handlers etc., computed
+ * from the .su files and the disassembly. Compare it with the marks.
+*/
+#define NBIG	256
+
+static u32_t thread_stack[64];
+
+/* use_stack() - use about n words of stack
+*/
+static u32_t use_stack(int n)
+{
+	volatile u32_t buf[NBIG];
+	u32_t sum = 0;
+
+	for ( int i = 0; i < n && i < NBIG; i++ )
+		buf[i] = (u32_t)i;
+	for ( int i = 0; i < n && i < NBIG; i++ )
+		sum += buf[i];
+
+	return sum;
+}
+
+int main(void)
+{
+	/* Initialise uart0
+	*/
+	(void)rp2040_uart_init(&rp2040_uart0, 115200, "8N1");
+
+	/* Set up the I/O function for UART0
+	  * GPIO 16 = UART0 tx
+	  * GPIO 17 = UART0 rx
+	 */
+	rp2040_iobank0.gpio[16].ctrl = FUNCSEL_UART;
+	rp2040_iobank0.gpio[17].ctrl = FUNCSEL_UART;
+
+	dh_puts("Test started ...\n");
+
+	dh_puts("psp0    ");
+	dh_putx32(rp2040_psp_used(0));
+	(void)use_stack(NBIG);
+	dh_puts("psp0    ");
+	dh_putx32(rp2040_psp_used(0));
+
+	if ( rp2040_start_core1() != 0 )
+	{
+		dh_puts("Core 1 didn't start\n");
+		for (;;) {}
+	}
+
+	while ( (rp2040_sio.fifo_st & SIO_FIFO_VLD) == 0 )
+	{	/* Wait */
+	}
+	(void)rp2040_sio.fifo_rd;
+
+	/* A thread's stack: paint it, use the top quarter (as a stack would) and check the mark
+	*/
+	rp2040_stack_paint(&thread_stack[0], &thread_stack[64]);
+	for ( int i = 48; i < 64; i++ )
+		thread_stack[i] = 0;
+	dh_puts("thread  ");
+	dh_putx32(rp2040_stack_used(&thread_stack[0], &thread_stack[64]));
+
+	rp2040_stack_report(dh_putc);
+
+	dh_puts("Test finished\n");
+
+	for (;;) {}
+
+	return 0;
+}
+
+int main1(void)
+{
+	dh_puts("Core 1 started ...\n");
+
+	(void)use_stack(NBIG/4);
+
+	rp2040_sio.fifo_wr = 0x11111111;
+
+	for (;;) {}
+}
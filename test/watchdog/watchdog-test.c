@@ -0,0 +1,134 @@
+/* watchdog-test.c - test program for the watchdog service
+ *
+ * (c) David Haworth
+ *
+ *  This file is part of rp2040-bare-metal.
+ *
+ *  rp2040-bare-metal is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  rp2040-bare-metal is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with rp2040-bare-metal.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "rp2040-types.h"
+#include "rp2040.h"
+#include "rp2040-uart.h"
+#include "rp2040-gpio.h"
+#include "rp2040-delay.h"
+#include "rp2040-watchdog.h"
+#include "rp2040-crash.h"
+#include "test-io.h"
+
+/* Expected outcome of this test:
+ *
+ * The program is linked with ld/rp2040-flash.ldscript, because a RAM-loaded program doesn't survive
+ * the reboot.
+ *
+ * Async serial output at 115200-8N1 on GPIO 16
+ *	- "Test started ..."
+ *	- "RESET,00000000" (power-on)
+ *	- "task    " 0 and "task    " 1: two tasks register, with periods of 10 ms and 50 ms
+ *	- "alive   " 0xffffffff: both tasks check in for a second and the service feeds the watchdog
+ *	- "missed  " 1: task 1 stops checking in; the service notices after 50 ms and stops feeding
+ *	- the watchdog resets the chip 100 ms later, although task 0 and the service still run. Then:
+ *	- "Test started ..."
+ *	- "RESET,00000001" (the watchdog timer)
+ *	- "MISSED,00000001,<late>", with late a little over 50000 (0xc350)
+ *	- "Test finished"
+*/
+#define PERIOD_A	10000
+#define PERIOD_B	50000
+#define TIMEOUT		100000
+
+static void uart_flush(void)
+{
+	while ( (rp2040_uart0.fr & (UART_TXFE | UART_BUSY)) != UART_TXFE )
+	{
+		/* Wait */
+	}
+}
+
+int main(void)
+{
+	/* Initialise uart0
+	*/
+	(void)rp2040_uart_init(&rp2040_uart0, 115200, "8N1");
+
+	/* Set up the I/O function for UART0
+	  * GPIO 16 = UART0 tx
+	  * GPIO 17 = UART0 rx
+	 */
+	rp2040_iobank0.gpio[16].ctrl = FUNCSEL_UART;
+	rp2040_iobank0.gpio[17].ctrl = FUNCSEL_UART;
+
+	dh_puts("Test started ...\n");
+
+	rp2040_crash_report(dh_putc);
+
+	if ( rp2040_reset_info.missed < 0 )
+	{
+		int a = rp2040_watchdog_register(PERIOD_A);
+		int b = rp2040_watchdog_register(PERIOD_B);
+		int missed = -1;
+
+		dh_puts("task    ");
+		dh_putx32((u32_t)a);
+		dh_puts("task    ");
+		dh_putx32((u32_t)b);
+		uart_flush();
+
+		rp2040_watchdog_start(TIMEOUT, 1);
+
+		/* Both tasks alive for a second
+		*/
+		u32_t end = rp2040_deadline(1000000);
+		u32_t next_b = rp2040_deadline(PERIOD_B / 2);
+		while ( !rp2040_deadline_passed(end) && missed < 0 )
+		{
+			rp2040_watchdog_checkin(a);
+			if ( rp2040_deadline_passed(next_b) )
+			{
+				rp2040_watchdog_checkin(b);
+				next_b = rp2040_deadline(PERIOD_B / 2);
+			}
+			missed = rp2040_watchdog_service();
+		}
+
+		dh_puts("alive   ");
+		dh_putx32((u32_t)missed);
+
+		/* Task b stalls. The dh_ functions take much less than PERIOD_A.
+		*/
+		end = rp2040_deadline(1000000);
+		while ( !rp2040_deadline_passed(end) )
+		{
+			rp2040_watchdog_checkin(a);
+			if ( missed < 0 )
+			{
+				missed = rp2040_watchdog_service();
+				if ( missed >= 0 )
+				{
+					dh_puts("missed  ");
+					dh_putx32((u32_t)missed);
+				}
+			}
+			else
+				(void)rp2040_watchdog_service();
+		}
+
+		dh_puts("No reset!\n");
+	}
+
+	dh_puts("Test finished\n");
+
+	for (;;) {}
+
+	return 0;
+}